@@ -6,9 +6,26 @@
  */
 
 #include "ACS712.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
 
-ACS712::ACS712()
+ACS712 *ACS712::_continuous = 0;
+
+ISR(ADC_vect) {
+  ACS712::conversionComplete(ADC);
+}
+
+// Marks a valid calibration record
+#define CALIBRATION_MAGIC 0xac
+// Smoothing of the zero by single readings while the load is off
+#define ZERO_SHIFT 4
+
+ACS712::ACS712(Range range)
   : SensorImpl() {
+  _windowSize = 0;
+  _range = range;
+  _zeroUpdates = 0;
+  setCalibration(0, 1);
 }
 
 Sensor::Error ACS712::initialize(int analogPin, int vccPin) {
@@ -18,8 +35,15 @@ Sensor::Error ACS712::initialize(int analogPin, int vccPin) {
 }
 
 Sensor::Error ACS712::reset() {
+  if(isContinuous()) {
+    stopContinuous();
+  }
+  _rms = _acRms = _peak = _dcOffset = 0;
   _on = true;
   _value = 0;
+  _fixedValue = 0;
+  _loadOff = false;
+  _driftShift = 0;
   setCalibration(0, 1);
 
   // If there is a vcc pin, we are use power management
@@ -49,13 +73,260 @@ Sensor::Error ACS712::endSamplingImpl() {
 }
 
 Sensor::Error ACS712::readSensorImpl(unsigned long timeInMillis, int config) {
-  on(); // Only has effect if there is a power pin and we are not in sampling mode
-  _value = analogRead(_analogPin);
-  off();
+  Window window;
+  unsigned int samples;
+  unsigned long count;
+  uint8_t oldSREG;
+
+  if(isContinuous()) {
+    if(config == Current) {
+      oldSREG = SREG;
+      cli();
+      _value = _lastSample;
+      SREG = oldSREG;
+    }
+    else {
+      // The interrupt does not touch the complete window before the active one is full, but it
+      // must not switch windows while the count is read and the complete one is copied
+      oldSREG = SREG;
+      cli();
+      count = _windowCount;
+      if(count == _evaluated) {
+        SREG = oldSREG;
+        return MEASUREMENT_PENDING;
+      }
+      window.sum = _windows[_active ^ 1].sum;
+      window.squares = _windows[_active ^ 1].squares;
+      window.minimum = _windows[_active ^ 1].minimum;
+      window.maximum = _windows[_active ^ 1].maximum;
+      _evaluated = count;
+      samples = _windowSize;
+      SREG = oldSREG;
+
+      evaluate(&window, samples);
+      return NO_ERROR;
+    }
+  }
+  else if(config != Current) {
+    return FUNCTION_NOT_SUPPORTED;
+  }
+  else {
+    on(); // Only has effect if there is a power pin and we are not in sampling mode
+    _value = analogRead(_analogPin);
+    off();
+    if(_loadOff) {
+      trackZero(_value * 16, ZERO_SHIFT);
+    }
+  }
+  _fixedValue = toFixed(_value);
+
+  return NO_ERROR;
+}
+
+void ACS712::setRange(Range range) {
+  _range = range;
+  updateScale();
+}
+
+void ACS712::setCalibration(int offset, float scale) {
+  _zero = (512 + offset) * 16;
+  _gain = (uint16_t)(scale * 10000 + 0.5);
+  updateScale();
+}
+
+void ACS712::setZero(int zero) {
+  _zero = zero;
+}
+
+void ACS712::setLoadOff(bool off) {
+  _loadOff = off;
+  // Only windows that start from now on are free of current, the one in progress completes the next count
+  _zeroWindow = windows() + 2;
+}
+
+void ACS712::updateScale() {
+  _scale = _range / 1000.0 * (_gain / 10000.0) * 1024.0 / 5.0;
+  // 0.01 A per ADC step in 16.16 fixed point, so readings need no float
+  _fixedFactor = (long)(65536.0 * FIXED_SCALE / _scale + 0.5);
+}
+
+void ACS712::trackZero(int zero, uint8_t shift) {
+  _zero += (zero - _zero) >> shift;
+  _zeroUpdates++;
+}
+
+int ACS712::toFixed(int value) {
+  // The zero has 4 fractional bits. The difference times the factor could overflow 32 bits, so the
+  // whole steps and the fraction are multiplied separately.
+  int difference = value * 16 - _zero;
+  long whole = (long)(difference >> 4) * _fixedFactor;
+  long fraction = ((long)(difference & 0x0f) * _fixedFactor) >> 4;
+
+  // Shifting rounds towards minus infinity, adding half a step rounds to the nearest value
+  return (int)((whole + fraction + 0x8000) >> 16);
+}
+
+void ACS712::writeCalibration(uint8_t *record) {
+  uint8_t sum = 0;
+
+  record[0] = CALIBRATION_MAGIC;
+  record[1] = _zero & 0xff;
+  record[2] = _zero >> 8;
+  record[3] = _gain & 0xff;
+  record[4] = _gain >> 8;
+  record[5] = _range;
+  for(uint8_t i = 0; i < CALIBRATION_SIZE - 1; i++) {
+    sum += record[i];
+  }
+  record[CALIBRATION_SIZE - 1] = ~sum;
+}
+
+bool ACS712::readCalibration(const uint8_t *record) {
+  uint8_t sum = 0;
+
+  for(uint8_t i = 0; i < CALIBRATION_SIZE - 1; i++) {
+    sum += record[i];
+  }
+  if((record[0] != CALIBRATION_MAGIC) || (record[CALIBRATION_SIZE - 1] != (uint8_t)~sum) || (record[5] != _range)) {
+    return false;
+  }
+
+  _zero = (int16_t)(record[1] | (record[2] << 8));
+  _gain = record[3] | (record[4] << 8);
+  updateScale();
+
+  return true;
+}
+
+Sensor::Error ACS712::startContinuous(unsigned int samples) {
+  uint8_t channel = _analogPin >= 14 ? _analogPin - 14 : _analogPin;
+
+  if(_continuous && (_continuous != this)) {
+    return FUNCTION_NOT_SUPPORTED;
+  }
+  if((samples == 0) || (samples > MAX_WINDOW)) {
+    return UNKNOWN_CONFIG;
+  }
+
+  stopContinuous();
+  beginSampling();
+
+  _windowSize = samples;
+  _samples = 0;
+  _active = 0;
+  _windowCount = 0;
+  _evaluated = 0;
+  _lastSample = 512;
+  clearWindow(&_windows[0]);
+  _continuous = this;
+
+  // AVcc reference, free running with prescaler 128 and the interrupt enabled
+  ADMUX = _BV(REFS0) | (channel & 0x07);
+  ADCSRB = 0;
+  ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
 
   return NO_ERROR;
 }
 
+void ACS712::stopContinuous() {
+  if(!isContinuous()) {
+    return;
+  }
+
+  // Back to the single conversions of analogRead
+  ADCSRA = _BV(ADEN) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0);
+  _continuous = 0;
+  endSampling();
+}
+
+unsigned long ACS712::windows() {
+  unsigned long count;
+  uint8_t oldSREG = SREG;
+
+  cli();
+  count = _windowCount;
+  SREG = oldSREG;
+
+  return count;
+}
+
+void ACS712::conversionComplete(int value) {
+  ACS712 *sensor = _continuous;
+  volatile Window *window;
+  int sample = value - 512;
+
+  if(!sensor) {
+    return;
+  }
+
+  window = &sensor->_windows[sensor->_active];
+  sensor->_lastSample = value;
+  window->sum += sample;
+  window->squares += (unsigned long)((long)sample * sample);
+  if(sample < window->minimum) {
+    window->minimum = sample;
+  }
+  if(sample > window->maximum) {
+    window->maximum = sample;
+  }
+
+  if(++sensor->_samples >= sensor->_windowSize) {
+    sensor->_active ^= 1;
+    sensor->clearWindow(&sensor->_windows[sensor->_active]);
+    sensor->_samples = 0;
+    sensor->_windowCount++;
+  }
+}
+
+void ACS712::clearWindow(volatile Window *window) {
+  window->sum = 0;
+  window->squares = 0;
+  window->minimum = 0x7fff;
+  window->maximum = -0x7fff;
+}
+
+void ACS712::evaluate(const Window *window, unsigned int samples) {
+  long long sum = window->sum;
+  long long squares;
+  long long variance;
+  long long mean;
+  long peak;
+  long zero;
+
+  // The mean of the window in 1/16 ADC steps; a window without current is the zero
+  mean = (sum * 16 + (sum < 0 ? -(long long)samples : (long long)samples) / 2) / samples + 8192;
+  if(_loadOff && (_evaluated >= _zeroWindow)) {
+    trackZero((int)mean, 0);
+  }
+  else if(!_loadOff && _driftShift) {
+    trackZero((int)mean, _driftShift);
+  }
+
+  // The zero relative to the 512 the samples are relative to, in 1/16 ADC steps
+  zero = _zero - 8192;
+
+  // Mean squares relative to the zero in 1/256 ADC steps squared: sum((16x - zero)^2) / n
+  squares = (long long)window->squares * 256 - 32 * zero * sum + (long long)samples * zero * zero;
+  squares = (squares + samples / 2) / samples;
+  // Variance in 1/256 ADC steps squared: (n * sum(x^2) - sum(x)^2) * 256 / n^2
+  variance = ((long long)window->squares * samples - sum * sum) * 256;
+  variance = (variance + (long long)samples * samples / 2) / ((long long)samples * samples);
+
+  // The square roots are in 1/16 ADC steps, the factor is 16.16 fixed point per ADC step
+  _rms = (int)(((long long)Sensor::squareRoot((unsigned long)squares) * _fixedFactor + (1L << 19)) >> 20);
+  _acRms = (int)(((long long)Sensor::squareRoot((unsigned long)variance) * _fixedFactor + (1L << 19)) >> 20);
+
+  peak = labs(window->maximum * 16L - zero);
+  if(labs(window->minimum * 16L - zero) > peak) {
+    peak = labs(window->minimum * 16L - zero);
+  }
+  _peak = (int)(((long long)peak * _fixedFactor + (1L << 19)) >> 20);
+
+  // Mean relative to the zero in 1/256 ADC steps: sum(16x - zero) * 16 / n, rounded
+  mean = (sum * 16 - zero * samples) * 16;
+  mean = (mean + (mean < 0 ? -(long long)samples : (long long)samples) / 2) / samples;
+  _dcOffset = (int)((mean * _fixedFactor + (1L << 23)) >> 24);
+}
 
 int ACS712::getIntegerValue(int config) {
   return _value;
@@ -66,8 +337,28 @@ byte ACS712::getByteValue(int config) {
 }
 
 float ACS712::getFloatValue(int config) {
+  if(config != Current) {
+    // The statistics of a window are computed in fixed point
+    return getFixedValue(config) / (float)FIXED_SCALE;
+  }
+
   // I = (V - 2.5V) / 185 mV
-  return ((float)(_value - _offset))/_scale;
+  return ((float)(_value - _zero / 16.0))/_scale;
+}
+
+int ACS712::getFixedValue(int config) {
+  switch(config) {
+    case Rms:
+      return _rms;
+    case AcRms:
+      return _acRms;
+    case Peak:
+      return _peak;
+    case DcOffset:
+      return _dcOffset;
+  }
+
+  return _fixedValue;
 }
 
 void ACS712::on() {
@@ -11,9 +11,55 @@
 #include <Sensor.h>
 #include <WProgram.h>
 
+/**
+ * Allegro ACS712 hall effect current sensor on an analog pin, optionally powered through a digital pin.
+ * <p>
+ * By default every <code>readSensor</code> does one <code>analogRead</code> (about 110 us) and the value is the
+ * momentary current. For AC loads the ADC can run continuously instead (<code>startContinuous</code>): the ADC
+ * converts in free running mode (9615 samples/s at 16 MHz) and the ADC interrupt adds every sample to the
+ * sums of a window. At the end of a window the interrupt switches to the other of two windows, so the
+ * completed one can be evaluated while sampling goes on. The statistics of the last complete window are
+ * read with the configs <code>Rms</code>, <code>AcRms</code>, <code>Peak</code> and <code>DcOffset</code>; for these
+ * configs <code>readSensor</code> returns <code>MEASUREMENT_PENDING</code> until a window completed since the
+ * last reading. <code>Current</code> returns the latest sample. No reading waits for a conversion.
+ * <p>
+ * While an ACS712 samples continuously the ADC belongs to it, <code>analogRead</code> must not be used.
+ * <p>
+ * The zero, i.e. the ADC value of 0 A, drifts with temperature and supply. It can be tracked while the
+ * sensor is in use (<code>setLoadOff</code>, <code>setDriftTracking</code>) and saved to and loaded from
+ * a storage device, so no calibration run is needed at start up.
+ */
 class ACS712: public SensorImpl {
   public:
-    ACS712();
+    /**
+     * The values of the sensor, passed as config.
+     */
+    enum Value {
+      Current = 0,    // the momentary current
+      Rms = 1,        // the true RMS current of the last window, relative to the calibrated zero
+      AcRms = 2,      // the RMS current of the last window without its mean, i.e. of the AC part only
+      Peak = 3,       // the largest absolute current of the last window
+      DcOffset = 4    // the mean current of the last window
+    };
+
+    // Rate of the free running ADC: CPU clock / prescaler 128 / 13 cycles per conversion
+    static const unsigned int SAMPLE_RATE = F_CPU / 128 / 13;
+    // The sum of squares of a window has to fit into 32 bits
+    static const unsigned int MAX_WINDOW = 16000;
+
+    /**
+     * The versions of the chip and their sensitivity in mV/A.
+     */
+    enum Range {
+      Range5A = 185,
+      Range20A = 100,
+      Range30A = 66
+    };
+
+    // Size of the calibration record, see saveCalibration
+    static const uint8_t CALIBRATION_SIZE = 7;
+
+    ACS712(Range range = Range5A);
 
     Sensor::Error initialize(int analogPin, int vccPin = -1);
     Sensor::Error initialize() {
@@ -21,10 +67,73 @@ class ACS712: public SensorImpl {
     };
     Sensor::Error reset();
 
-    void setCalibration(int offset, float scale = 1.0) {
-      _offset = 512 + offset;
-      // TODO: this should be generalized for the different version of the chip
-      _scale = 0.185 * scale * 1024.0 / 5.0;
+    /**
+     * Sets the version of the chip. Keeps the calibration.
+     */
+    void setRange(Range range);
+    Range getRange() { return (Range)_range; };
+
+    /**
+     * Calibrates the sensor.
+     *
+     * @param[in] offset the ADC value of 0 A relative to 512, i.e. the ideal 2.5 V.
+     * @param[in] scale the gain correction, the sensitivity of the chip version is multiplied with it.
+     */
+    void setCalibration(int offset, float scale = 1.0);
+
+    /**
+     * Sets the ADC value of 0 A, in 1/16 ADC steps, i.e. 8192 is the ideal 2.5 V.
+     */
+    void setZero(int zero);
+    int getZero() { return _zero; };
+
+    /**
+     * Marks that no current flows, e.g. because the application switched the load off. While the load is
+     * off, the readings move the zero towards the measured value: single readings with a smoothing factor
+     * of 1/16 and in continuous mode every window that started after the load was switched off replaces the
+     * zero with its mean.
+     */
+    void setLoadOff(bool off);
+    bool isLoadOff() { return _loadOff; };
+
+    /**
+     * Tracks a slow drift of the zero in continuous mode: the zero moves towards the mean of each window
+     * with the smoothing factor 1/2^shift, <code>0</code> turns tracking off. Only for AC loads, whose mean
+     * current is zero.
+     */
+    void setDriftTracking(uint8_t shift) { _driftShift = shift; };
+
+    /**
+     * @return the number of times the zero was adjusted since the start, e.g. to decide when the
+     *         calibration should be saved.
+     */
+    unsigned long zeroUpdates() { return _zeroUpdates; };
+
+    /**
+     * Saves the calibration (zero, scale and chip version) in <code>CALIBRATION_SIZE</code> bytes of a
+     * storage device, e.g. <code>EEPROMStorage::instance</code>, see the Storage library.
+     *
+     * @return <code>true</code> if the record was written completely.
+     */
+    template <class Storage>
+    bool saveCalibration(Storage &storage, int address) {
+      uint8_t record[CALIBRATION_SIZE];
+
+      writeCalibration(record);
+      return storage.write(address, record, CALIBRATION_SIZE) == CALIBRATION_SIZE;
+    };
+
+    /**
+     * Loads the calibration saved with <code>saveCalibration</code>.
+     *
+     * @return <code>true</code> if a valid calibration for this version of the chip was loaded;
+     *         <code>false</code> otherwise, in which case the calibration is not changed.
+     */
+    template <class Storage>
+    bool loadCalibration(Storage &storage, int address) {
+      uint8_t record[CALIBRATION_SIZE];
+
+      return (storage.read(address, record, CALIBRATION_SIZE) == CALIBRATION_SIZE) && readCalibration(record);
     };
 
     /**
@@ -57,19 +166,96 @@ class ACS712: public SensorImpl {
      */
     float getFloatValue(int config = 0);
 
+    /**
+     * Returns the current that was measured in the last reading in hundredths of A, i.e. the value of
+     * <code>getFloatValue</code> times 100. The value is computed with integer arithmetic when the
+     * sensor is read.
+     *
+     * @param[IN] config is ignored
+     *
+     * @return the current in 0.01 A that was measured in the last reading.
+     */
+    int getFixedValue(int config = 0);
+
+    /**
+     * Starts continuous sampling with windows of <code>samples</code> samples. For the RMS value of a mains
+     * current the window should cover whole cycles, see <code>windowSamples</code>. The sensor stays powered
+     * until <code>stopContinuous</code>.
+     *
+     * @return <code>NO_ERROR</code> if sampling started;<code>UNKNOWN_CONFIG</code> if the window is larger than
+     *         <code>MAX_WINDOW</code> and <code>FUNCTION_NOT_SUPPORTED</code> if another ACS712 samples already.
+     */
+    Sensor::Error startContinuous(unsigned int samples);
+    void stopContinuous();
+    bool isContinuous() { return _continuous == this; };
+
+    /**
+     * @return the number of samples that cover <code>cycles</code> whole cycles of the given frequency.
+     */
+    static unsigned int windowSamples(uint8_t cycles, uint8_t frequency) {
+      return (unsigned int)(((unsigned long)cycles * SAMPLE_RATE + frequency / 2) / frequency);
+    };
+
+    /**
+     * @return the number of windows that were completed since <code>startContinuous</code>.
+     */
+    unsigned long windows();
+
+    /**
+     * Called by the ADC interrupt with the result of the conversion.
+     */
+    static void conversionComplete(int value);
+
   protected:
     Sensor::Error beginSamplingImpl();
     Sensor::Error endSamplingImpl();
     Sensor::Error readSensorImpl(unsigned long timeInMillis, int config = 0);
 
   private:
+    struct Window {
+      long sum;                 // of the samples - 512
+      unsigned long squares;
+      int minimum;
+      int maximum;
+    };
+
+    static ACS712 *_continuous;
 
     void on();
     void off();
+    void updateScale();
+    void trackZero(int zero, uint8_t shift);
+    int toFixed(int value);
+    void writeCalibration(uint8_t *record);
+    bool readCalibration(const uint8_t *record);
+    void clearWindow(volatile Window *window);
+    void evaluate(const Window *window, unsigned int samples);
 
     int _value;
-    int _offset;
-    float _scale;
+    int _zero;              // in 1/16 ADC steps
+    uint16_t _gain;         // in 1/10000
+    uint8_t _range;         // mV/A
+    float _scale;           // ADC steps per A
+    long _fixedFactor;      // 0.01 A per ADC step, 16.16 fixed point
+    bool _loadOff;
+    uint8_t _driftShift;
+    unsigned long _zeroWindow;
+    unsigned long _zeroUpdates;
+    int _fixedValue;
+
+    // Continuous sampling: the interrupt fills _windows[_active], the other one is complete
+    volatile Window _windows[2];
+    volatile uint8_t _active;
+    volatile unsigned int _samples;
+    volatile unsigned long _windowCount;
+    volatile int _lastSample;
+    unsigned int _windowSize;
+    unsigned long _evaluated;
+    // The statistics of the last window that was read, in 0.01 A
+    int _rms;
+    int _acRms;
+    int _peak;
+    int _dcOffset;
     int _vccPin;
     int _analogPin;
     bool _on;
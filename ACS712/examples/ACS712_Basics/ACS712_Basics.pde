@@ -1,4 +1,6 @@
 #include <Sensor.h>
+#include <SampleHistory.h>
+#include <SensorFilter.h>
 #include <ACS712.h>
 
 #define CURRENT_ON_OFF_PIN 8
@@ -8,43 +10,45 @@
 
 #define MAX_VALUES 100
 
-int valuesInt[MAX_VALUES];
-float values[MAX_VALUES];
-
 ACS712 acs712;
-Sensor &currentSensor = acs712;
+// Replaces spikes by the median of the last 5 readings
+HampelFilter<5> filtered(&acs712);
+Sensor &currentSensor = filtered;
+// The filtered current of the last MAX_VALUES readings in 0.01 A
+SensorHistory<MAX_VALUES> current;
 
 void setup() {
   Serial.begin(57600);
   Serial.println("====== ACS712 Sensor Demo ======");
   Serial.println("Assumption: ACS712 on A0 and D9, current on/off on D8");
   acs712.initialize(ACS712_ANALOG_PIN, ACS712_VCC_PIN);
+  filtered.attachHistory(&current);
   pinMode(CURRENT_ON_OFF_PIN, OUTPUT);
   digitalWrite(CURRENT_ON_OFF_PIN, LOW);
 } 
 
 void loop() {
-  int offset;
   Serial.print("*****Start with offset Calibration");
   dotDelay(2);
-  takeMeasurement(500);
+  // No current flows, the readings move the zero of the sensor
+  acs712.setLoadOff(true);
+  takeMeasurement();
+  acs712.setLoadOff(false);
   Serial.println("done taking sample.");
-  Serial.print("Average: ");
-  offset = average();
-  Serial.println(offset);
-  //acs712.setCalibration(offset - 512 + 5);
+  Serial.print("Zero (1/16 ADC steps): ");
+  Serial.println(acs712.getZero());
   Serial.println("**** Done calibrating");
   
   Serial.print("***** Measuring w/o current");
   dotDelay(2);
-  takeMeasurement(offset);  
+  takeMeasurement();  
   Serial.println("done");
   printValues();
     
   Serial.print("***** Measuring with current (wait for current to stabilize)");
   digitalWrite(CURRENT_ON_OFF_PIN, HIGH);
   dotDelay(10);
-  takeMeasurement(offset);
+  takeMeasurement();
   Serial.println("done");
   printValues();
   
@@ -61,65 +65,51 @@ void loop() {
 }
 
 
-int takeMeasurement(int init) {
-  int lastValue = init;
-  int count = 0;
-  
+void takeMeasurement() {
+  current.clear();
   currentSensor.beginSampling();
-  for(int i = 0; (i < MAX_VALUES * 10) && (count < MAX_VALUES); i++) {
+  // The history keeps the statistics up to date with every reading
+  for(int i = 0; i < MAX_VALUES; i++) {
     currentSensor.readSensor();
-    valuesInt[count] = currentSensor.getIntegerValue();
-    if(abs(valuesInt[count] - lastValue) < 15) {
-      lastValue = currentSensor.getIntegerValue();
-      values[count++] = currentSensor.getFloatValue();
-    }
     delayMicroseconds((1000000.0/FREQUENCY) / (MAX_VALUES / 2));
   }
   currentSensor.endSampling();
-  return count;
+}
+
+void printFixed(int value) {
+  if(value < 0) {
+    Serial.print("-");
+    value = -value;
+  }
+  Serial.print(value / 100);
+  Serial.print(".");
+  if(value % 100 < 10) {
+    Serial.print("0");
+  }
+  Serial.print(value % 100);
 }
 
 void printValues() {
-  float minValue = 2000;
-  float maxValue = -1;
-  float averageValue = 0;
-    
-  Serial.print(values[0]);  
-  for(int i = 1; i < MAX_VALUES; i++) {
-    Serial.print(", ");
-    Serial.print(values[i]);
-    if(values[i] < minValue) minValue = values[i];
-    if(values[i] > maxValue) maxValue = values[i];
-    averageValue += values[i];
+  // Oldest first
+  for(int i = current.count() - 1; i >= 0; i--) {
+    printFixed(current.sample(i));
+    Serial.print(i ? ", " : " ");
   }
-  Serial.println(" ");
+  Serial.println("");
   Serial.print("Min: ");
-  Serial.print(minValue);
+  printFixed(current.minimum());
   Serial.print(" Max: ");
-  Serial.print(maxValue);
+  printFixed(current.maximum());
   Serial.print(" Average: ");
-  Serial.println(averageValue / MAX_VALUES);
+  printFixed(current.average());
+  Serial.print(" Deviation: ");
+  printFixed(current.standardDeviation());
+  Serial.println("");
   Serial.print("Delta MM: ");
-  Serial.println(maxValue - minValue);
+  printFixed(current.maximum() - current.minimum());
+  Serial.println("");
 }
 
-
-int average() {
-  float averageValue;
-  int count = 1;
-  
-  for(int i = 0; i < MAX_VALUES; i++) {
-    if(abs(valuesInt[i] - 512) < 50) {
-      averageValue += valuesInt[i];
-      count++;
-    }
-  }
-  
-  return round(averageValue / count);
-}
-  
-  
-
 void dotDelay(int t) {
   for(int i = 0; i < t; i++) {
     Serial.print(".");
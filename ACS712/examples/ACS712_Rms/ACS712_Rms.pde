@@ -0,0 +1,37 @@
+/*
+ * ACS712_Rms.pde
+ *
+ * Measures the current of an AC load: the ADC samples the ACS712 continuously in the background
+ * and the sketch prints the RMS, peak and DC offset of every 10 mains cycles.
+ */
+#include <Sensor.h>
+#include <ACS712.h>
+
+#define ACS712_ANALOG_PIN 0
+#define MAINS_FREQUENCY 60
+#define CYCLES 10
+
+ACS712 acs712;
+
+void setup() {
+  Serial.begin(57600);
+  Serial.println("====== ACS712 RMS Demo ======");
+  Serial.println("Assumption: ACS712 on A0");
+  acs712.initialize(ACS712_ANALOG_PIN);
+  acs712.startContinuous(ACS712::windowSamples(CYCLES, MAINS_FREQUENCY));
+}
+
+void loop() {
+  // Returns MEASUREMENT_PENDING until the next window is complete, the loop is free to do other work
+  if(acs712.readSensor(ACS712::Rms) == Sensor::NO_ERROR) {
+    Serial.print("RMS: ");
+    Serial.print(acs712.getFloatValue(ACS712::Rms));
+    Serial.print(" A, AC RMS: ");
+    Serial.print(acs712.getFloatValue(ACS712::AcRms));
+    Serial.print(" A, Peak: ");
+    Serial.print(acs712.getFloatValue(ACS712::Peak));
+    Serial.print(" A, DC: ");
+    Serial.print(acs712.getFloatValue(ACS712::DcOffset));
+    Serial.println(" A");
+  }
+}
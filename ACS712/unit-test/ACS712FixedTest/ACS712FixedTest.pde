@@ -0,0 +1,59 @@
+/*
+ * Compares the fixed point current of the ACS712 with the float current over the whole range of
+ * the ADC. Uses the simulated analog pins, i.e. only runs on the host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <ACS712.h>
+#include <HostSim.h>
+
+TestSuite suite;
+
+ACS712 acs712;
+
+void setup() {
+  Serial.begin(9600);
+  acs712.initialize(0);
+}
+
+void loop() {
+  suite.run();
+}
+
+float maxError(float scale, int offset) {
+  float maxError = 0;
+  float error;
+
+  acs712.setCalibration(offset, scale);
+  for(int adc = 0; adc < 1024; adc++) {
+    SimPins::instance.setAnalogValue(0, adc);
+    acs712.readSensor(millis());
+    error = fabs(acs712.getFixedValue() / 100.0 - acs712.getFloatValue());
+    if(error > maxError) {
+      maxError = error;
+    }
+  }
+
+  return maxError;
+}
+
+test(range) {
+  SimPins::instance.setAnalogValue(0, 512);
+  acs712.readSensor(millis());
+  assertEquals(0, acs712.getFixedValue());
+
+  // One ADC step is 0.026 A
+  SimPins::instance.setAnalogValue(0, 550);
+  acs712.readSensor(millis());
+  assertEquals(100, acs712.getFixedValue());
+  SimPins::instance.setAnalogValue(0, 474);
+  acs712.readSensor(millis());
+  assertEquals(-100, acs712.getFixedValue());
+}
+
+test(accuracy) {
+  assertTrue(maxError(1.0, 0) <= 0.0051);
+  assertTrue(maxError(0.9, 7) <= 0.0051);
+  assertTrue(maxError(1.23, -12) <= 0.0051);
+  acs712.setCalibration(0, 1.0);
+}
@@ -0,0 +1,106 @@
+/*
+ * Tests the continuous sampling of the ACS712 with a simulated AC current, i.e. only runs on the
+ * host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <ACS712.h>
+#include <HostSim.h>
+#include <math.h>
+
+TestSuite suite;
+
+ACS712 acs712;
+
+// ADC steps per A of the 5 A version: 0.185 V/A * 1024 / 5 V
+#define STEPS_PER_AMP 37.888
+
+float amplitude;    // A
+float dcCurrent;    // A
+int frequency;      // Hz
+
+int acCurrent(uint8_t channel, unsigned long long wallMicros) {
+  float current = dcCurrent + amplitude * sin(2 * M_PI * frequency * wallMicros / 1000000.0);
+
+  return (int)floor(512 + current * STEPS_PER_AMP + 0.5);
+}
+
+void setup() {
+  Serial.begin(9600);
+  acs712.initialize(0);
+  SimPins::instance.setAnalogSource(0, acCurrent);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(window) {
+  assertEquals(9615, (int)ACS712::SAMPLE_RATE);
+  assertEquals(1923, (int)ACS712::windowSamples(10, 50));
+  assertEquals(1603, (int)ACS712::windowSamples(10, 60));
+  assertEquals(Sensor::UNKNOWN_CONFIG, acs712.startContinuous(ACS712::MAX_WINDOW + 1));
+  assertEquals(Sensor::FUNCTION_NOT_SUPPORTED, acs712.readSensor(millis(), ACS712::Rms));
+}
+
+test(rms) {
+  unsigned long start;
+
+  amplitude = 10.0;
+  dcCurrent = 0;
+  frequency = 50;
+  assertEquals(Sensor::NO_ERROR, acs712.startContinuous(ACS712::windowSamples(10, 50)));
+  assertTrue(acs712.isContinuous());
+  assertEquals(Sensor::MEASUREMENT_PENDING, acs712.readSensor(millis(), ACS712::Rms));
+
+  delay(210);
+  assertUnsignedLongEquals(1, acs712.windows());
+
+  // Reading does not wait for the ADC
+  start = micros();
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::Rms));
+  assertUnsignedLongEquals(start, micros());
+  // The next window is not complete yet
+  assertEquals(Sensor::MEASUREMENT_PENDING, acs712.readSensor(millis(), ACS712::Rms));
+
+  // 10 A / sqrt(2), within the quantization of the ADC
+  assertTrue(abs(acs712.getFixedValue(ACS712::Rms) - 707) <= 3);
+  assertTrue(abs(acs712.getFixedValue(ACS712::AcRms) - 707) <= 3);
+  assertTrue(abs(acs712.getFixedValue(ACS712::Peak) - 1000) <= 3);
+  assertTrue(abs(acs712.getFixedValue(ACS712::DcOffset)) <= 1);
+  assertTrue(fabs(acs712.getFloatValue(ACS712::Rms) - 7.07) < 0.04);
+
+  // The latest sample
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::Current));
+  assertTrue(abs(acs712.getFixedValue(ACS712::Current)) <= 1003);
+
+  acs712.stopContinuous();
+  assertTrue(!acs712.isContinuous());
+}
+
+test(dcOffset) {
+  amplitude = 3.0;
+  dcCurrent = 2.0;
+  frequency = 60;
+  assertEquals(Sensor::NO_ERROR, acs712.startContinuous(ACS712::windowSamples(6, 60)));
+
+  delay(250);
+  assertTrue(acs712.windows() >= 2);
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::DcOffset));
+
+  // sqrt(2^2 + 3^2 / 2) = 2.915
+  assertTrue(abs(acs712.getFixedValue(ACS712::Rms) - 292) <= 3);
+  assertTrue(abs(acs712.getFixedValue(ACS712::AcRms) - 212) <= 3);
+  assertTrue(abs(acs712.getFixedValue(ACS712::Peak) - 500) <= 3);
+  assertTrue(abs(acs712.getFixedValue(ACS712::DcOffset) - 200) <= 2);
+
+  // Relative to a calibrated zero of +1 A, 38 ADC steps
+  acs712.setCalibration(38);
+  delay(100);
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::DcOffset));
+  assertTrue(abs(acs712.getFixedValue(ACS712::DcOffset) - 100) <= 2);
+  assertTrue(abs(acs712.getFixedValue(ACS712::AcRms) - 212) <= 3);
+  acs712.setCalibration(0);
+
+  acs712.stopContinuous();
+}
@@ -0,0 +1,208 @@
+/*
+ * Tests the chip versions and the tracking and persistence of the zero of the ACS712 with a simulated
+ * current, i.e. only runs on the host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <ACS712.h>
+#include <EEPROM.h>
+#include <StorageDevice.h>
+#include <EEPROMStorage.h>
+#include <HostSim.h>
+#include <math.h>
+
+TestSuite suite;
+
+ACS712 acs712;
+
+float stepsPerAmp;  // ADC steps per A
+float zero;         // ADC value of 0 A
+float amplitude;    // A
+float dcCurrent;    // A
+
+int current(uint8_t channel, unsigned long long wallMicros) {
+  float value = dcCurrent + amplitude * sin(2 * M_PI * 50 * wallMicros / 1000000.0);
+
+  return (int)floor(zero + value * stepsPerAmp + 0.5);
+}
+
+void simulate(ACS712::Range range, float z, float ac, float dc) {
+  stepsPerAmp = range / 1000.0 * 1024 / 5;
+  zero = z;
+  amplitude = ac;
+  dcCurrent = dc;
+}
+
+void setup() {
+  Serial.begin(9600);
+  acs712.initialize(0);
+  SimPins::instance.setAnalogSource(0, current);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(ranges) {
+  ACS712 sensor30A(ACS712::Range30A);
+
+  assertEquals(ACS712::Range5A, acs712.getRange());
+  assertEquals(ACS712::Range30A, sensor30A.getRange());
+  sensor30A.initialize(0);
+
+  // 20 A on the 30 A version, 66 mV/A
+  simulate(ACS712::Range30A, 512, 0, 20.0);
+  assertEquals(Sensor::NO_ERROR, sensor30A.readSensor(millis()));
+  assertTrue(abs(sensor30A.getFixedValue() - 2000) <= 4);
+  assertTrue(fabs(sensor30A.getFloatValue() - 20.0) < 0.04);
+
+  // 10 A on the 20 A version, 100 mV/A
+  sensor30A.setRange(ACS712::Range20A);
+  simulate(ACS712::Range20A, 512, 0, 10.0);
+  assertEquals(Sensor::NO_ERROR, sensor30A.readSensor(millis()));
+  assertTrue(abs(sensor30A.getFixedValue() - 1000) <= 3);
+}
+
+test(loadOffSingle) {
+  unsigned long updates = acs712.zeroUpdates();
+
+  // The zero drifted by 2.5 ADC steps, with the load on the readings do not change it
+  simulate(ACS712::Range5A, 514.5, 0, 1.0);
+  acs712.setCalibration(0);
+  for(int i = 0; i < 10; i++) {
+    acs712.readSensor(millis());
+  }
+  assertEquals(512 * 16, acs712.getZero());
+  assertUnsignedLongEquals(updates, acs712.zeroUpdates());
+
+  // The load is off, the zero follows the readings
+  simulate(ACS712::Range5A, 514.5, 0, 0);
+  acs712.setLoadOff(true);
+  for(int i = 0; i < 100; i++) {
+    acs712.readSensor(millis());
+  }
+  acs712.setLoadOff(false);
+  assertTrue(acs712.zeroUpdates() >= updates + 100);
+  // Single readings only see whole ADC steps
+  assertTrue(abs(acs712.getZero() - 515 * 16) <= 16);
+
+  dcCurrent = 1.0;
+  acs712.readSensor(millis());
+  assertTrue(abs(acs712.getFixedValue() - 100) <= 5);
+  acs712.setCalibration(0);
+}
+
+test(loadOffContinuous) {
+  // 2.5 A AC with a zero of 509.25
+  simulate(ACS712::Range5A, 509.25, 2.5, 0);
+  acs712.setCalibration(0);
+  assertEquals(Sensor::NO_ERROR, acs712.startContinuous(ACS712::windowSamples(5, 50)));
+  delay(150);
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::DcOffset));
+  // Against the uncalibrated zero there is a DC offset of -0.074 A
+  assertTrue(abs(acs712.getFixedValue(ACS712::DcOffset) + 7) <= 2);
+  assertEquals(512 * 16, acs712.getZero());
+
+  // The window that is in progress when the load is switched off is not used
+  amplitude = 0;
+  acs712.setLoadOff(true);
+  assertEquals(Sensor::MEASUREMENT_PENDING, acs712.readSensor(millis(), ACS712::DcOffset));
+  assertEquals(512 * 16, acs712.getZero());
+  delay(250);
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::DcOffset));
+  acs712.setLoadOff(false);
+  assertTrue(abs(acs712.getZero() - 8148) <= 4);
+
+  amplitude = 2.5;
+  delay(150);
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::DcOffset));
+  assertTrue(abs(acs712.getFixedValue(ACS712::DcOffset)) <= 1);
+  assertTrue(abs(acs712.getFixedValue(ACS712::Rms) - 177) <= 3);
+
+  acs712.stopContinuous();
+  acs712.setCalibration(0);
+}
+
+// Read right after the window that was in progress when the load was switched off
+test(loadOffFirstWindow) {
+  unsigned long windows;
+
+  simulate(ACS712::Range5A, 513, 0, 5.0);
+  acs712.setCalibration(0);
+  assertEquals(Sensor::NO_ERROR, acs712.startContinuous(ACS712::windowSamples(5, 50)));
+  delay(150);
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::DcOffset));
+
+  // Half of the window sees 5 A
+  windows = acs712.windows();
+  delay(50);
+  assertUnsignedLongEquals(windows, acs712.windows());
+  dcCurrent = 0;
+  acs712.setLoadOff(true);
+  while(acs712.windows() == windows) {
+    delay(1);
+  }
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::DcOffset));
+  assertEquals(512 * 16, acs712.getZero());
+
+  // The next window is free of current
+  while(acs712.windows() == windows + 1) {
+    delay(1);
+  }
+  assertEquals(Sensor::NO_ERROR, acs712.readSensor(millis(), ACS712::DcOffset));
+  acs712.setLoadOff(false);
+  assertEquals(513 * 16, acs712.getZero());
+
+  acs712.stopContinuous();
+  acs712.setCalibration(0);
+}
+
+test(driftTracking) {
+  // AC only, the zero slowly moves away from the calibration
+  simulate(ACS712::Range5A, 512, 4.0, 0);
+  acs712.setCalibration(0);
+  acs712.setDriftTracking(2);
+  assertEquals(Sensor::NO_ERROR, acs712.startContinuous(ACS712::windowSamples(5, 50)));
+  zero = 513.5;
+  for(int i = 0; i < 20; i++) {
+    delay(100);
+    acs712.readSensor(millis(), ACS712::Rms);
+  }
+  assertTrue(abs(acs712.getZero() - 8216) <= 4);
+  assertTrue(abs(acs712.getFixedValue(ACS712::AcRms) - 283) <= 3);
+  assertTrue(abs(acs712.getFixedValue(ACS712::DcOffset)) <= 1);
+
+  acs712.setDriftTracking(0);
+  acs712.stopContinuous();
+  acs712.setCalibration(0);
+}
+
+test(persistence) {
+  ACS712 other(ACS712::Range5A);
+  ACS712 sensor20A(ACS712::Range20A);
+
+  acs712.setCalibration(0, 1.05);
+  acs712.setZero(8190);
+  assertTrue(acs712.saveCalibration(EEPROMStorage::instance, 100));
+
+  other.initialize(0);
+  assertTrue(other.loadCalibration(EEPROMStorage::instance, 100));
+  assertEquals(8190, other.getZero());
+
+  simulate(ACS712::Range5A, 511.875, 0, 2.0);
+  other.readSensor(millis());
+  acs712.readSensor(millis());
+  assertEquals(acs712.getFixedValue(), other.getFixedValue());
+
+  // Calibration of another version of the chip
+  sensor20A.initialize(0);
+  assertTrue(!sensor20A.loadCalibration(EEPROMStorage::instance, 100));
+  assertEquals(512 * 16, sensor20A.getZero());
+
+  // Corrupted record
+  EEPROM.write(101, EEPROM.read(101) ^ 0x01);
+  assertTrue(!other.loadCalibration(EEPROMStorage::instance, 100));
+  assertEquals(8190, other.getZero());
+
+  acs712.setCalibration(0);
+}
@@ -0,0 +1,266 @@
+/*
+ * Benchmark.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "Benchmark.h"
+
+#ifdef __AVR__
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#else
+#include <HostSim.h>
+#include <time.h>
+#endif
+
+#define CALIBRATION_RUNS 16
+
+BenchmarkStats::BenchmarkStats() {
+  clear();
+}
+
+void BenchmarkStats::clear() {
+  _count = 0;
+  _min = 0;
+  _max = 0;
+  for(int i = 0; i < BENCHMARK_BUCKETS; i++) {
+    _buckets[i] = 0;
+  }
+}
+
+void BenchmarkStats::add(unsigned long value) {
+  uint8_t bucket = bucketOf(value);
+
+  if(_count == 0 || value < _min) {
+    _min = value;
+  }
+  if(_count == 0 || value > _max) {
+    _max = value;
+  }
+  _count++;
+
+  if(_buckets[bucket] != 0xffff) {
+    _buckets[bucket]++;
+  }
+}
+
+unsigned long BenchmarkStats::percentile(uint8_t percent) {
+  unsigned long rank;
+  unsigned long seen = 0;
+  unsigned long value = _max;
+
+  if(_count == 0) {
+    return 0;
+  }
+
+  // The rank of the value within all values, rounded up
+  rank = (_count * percent + 99) / 100;
+  if(rank == 0) {
+    return _min;
+  }
+
+  for(uint8_t i = 0; i < BENCHMARK_BUCKETS; i++) {
+    seen += _buckets[i];
+    if(seen >= rank) {
+      value = upperBoundOf(i);
+      break;
+    }
+  }
+
+  if(value > _max) {
+    value = _max;
+  }
+  if(value < _min) {
+    value = _min;
+  }
+
+  return value;
+}
+
+/**
+ * Values below 8 have their own bucket. Above, each power of two 2^e is split into four
+ * buckets using the two bits following the highest bit.
+ */
+uint8_t BenchmarkStats::bucketOf(unsigned long value) {
+  uint8_t e = 0;
+  uint8_t bucket;
+
+  if(value < 4) {
+    return value;
+  }
+
+  for(unsigned long v = value; v > 1; v >>= 1) {
+    e++;
+  }
+
+  bucket = 4 * (e - 1) + ((value >> (e - 2)) & 3);
+
+  return bucket < BENCHMARK_BUCKETS ? bucket : BENCHMARK_BUCKETS - 1;
+}
+
+unsigned long BenchmarkStats::upperBoundOf(uint8_t bucket) {
+  uint8_t e;
+  unsigned long lower;
+
+  if(bucket < 4) {
+    return bucket;
+  }
+  if(bucket == BENCHMARK_BUCKETS - 1) {
+    return (unsigned long)-1;
+  }
+
+  e = bucket / 4 + 1;
+  lower = (4UL + bucket % 4) << (e - 2);
+
+  return lower + (1UL << (e - 2)) - 1;
+}
+
+
+unsigned long Benchmark::_overhead = 0;
+
+#ifdef __AVR__
+
+static volatile unsigned long timer1Overflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+  timer1Overflows++;
+}
+
+void Benchmark::begin() {
+  uint8_t oldSREG = SREG;
+
+  cli();
+  // Normal mode, no prescaler, i.e. the timer counts CPU cycles
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10);
+  TCNT1 = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+  timer1Overflows = 0;
+  SREG = oldSREG;
+
+  _overhead = 0;
+  for(int i = 0; i < CALIBRATION_RUNS; i++) {
+    unsigned long start = cycles();
+    unsigned long overhead = cycles() - start;
+    if(i == 0 || overhead < _overhead) {
+      _overhead = overhead;
+    }
+  }
+}
+
+unsigned long Benchmark::cycles() {
+  uint8_t oldSREG = SREG;
+  unsigned long high;
+  uint16_t low;
+
+  cli();
+  low = TCNT1;
+  high = timer1Overflows;
+  // The timer overflowed, but the interrupt has not been serviced yet
+  if((TIFR1 & _BV(TOV1)) && low < 0x8000) {
+    high++;
+  }
+  SREG = oldSREG;
+
+  return (high << 16) | low;
+}
+
+#else
+
+unsigned long Benchmark::_nanoOverhead = 0;
+
+void Benchmark::begin() {
+  // The simulated cycle counter does not charge anything for reading it
+  _overhead = 0;
+
+  _nanoOverhead = 0;
+  for(int i = 0; i < CALIBRATION_RUNS; i++) {
+    unsigned long start = nanos();
+    unsigned long overhead = nanos() - start;
+    if(i == 0 || overhead < _nanoOverhead) {
+      _nanoOverhead = overhead;
+    }
+  }
+}
+
+unsigned long Benchmark::cycles() {
+  return SimClock::instance.cycles();
+}
+
+unsigned long Benchmark::nanos() {
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1000000000UL + ts.tv_nsec;
+}
+
+#endif
+
+Benchmark::Benchmark(const char *name) {
+  _name = name;
+  _startCycles = 0;
+#ifndef __AVR__
+  _startNanos = 0;
+#endif
+}
+
+void Benchmark::clear() {
+  _cycles.clear();
+#ifndef __AVR__
+  _nanos.clear();
+#endif
+}
+
+void Benchmark::start() {
+  _startCycles = cycles();
+#ifndef __AVR__
+  _startNanos = nanos();
+#endif
+}
+
+void Benchmark::stop() {
+  unsigned long elapsed;
+
+#ifndef __AVR__
+  elapsed = nanos() - _startNanos;
+  _nanos.add(elapsed > _nanoOverhead ? elapsed - _nanoOverhead : 0);
+#endif
+  elapsed = cycles() - _startCycles;
+  _cycles.add(elapsed > _overhead ? elapsed - _overhead : 0);
+}
+
+void Benchmark::report() {
+  Serial.print(_name);
+  Serial.print(": ");
+  Serial.print(_cycles.count());
+  Serial.println(" calls");
+#ifdef __AVR__
+  report(_cycles, "cycles");
+#else
+  // Only what the simulated peripherals charge, see Benchmark.h
+  report(_cycles, "peripheral cycles");
+#endif
+  Serial.print(" (");
+  Serial.print(_cycles.maximum() / (F_CPU / 1000000L));
+  Serial.println(" us)");
+#ifndef __AVR__
+  report(_nanos, "native ns");
+  Serial.println();
+#endif
+}
+
+void Benchmark::report(BenchmarkStats &stats, const char *unit) {
+  Serial.print("  ");
+  Serial.print(unit);
+  Serial.print(": min ");
+  Serial.print(stats.minimum());
+  Serial.print(", median ");
+  Serial.print(stats.median());
+  Serial.print(", p99 ");
+  Serial.print(stats.percentile(99));
+  Serial.print(", max ");
+  Serial.print(stats.maximum());
+}
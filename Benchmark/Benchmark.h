@@ -0,0 +1,116 @@
+/*
+ * Benchmark.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ *
+ * Measures how long a piece of code takes per call and reports the minimum, median,
+ * 99th percentile and maximum. The samples are not stored, they are counted in a
+ * histogram with four buckets per power of two, so a sweep over a whole year of
+ * inputs fits into the RAM of an ATmega328. The percentiles are therefore the
+ * upper bound of the bucket they fall into (at most 25% above the exact value),
+ * minimum and maximum are exact.
+ * <p>
+ * On the target the cycles are counted with timer 1, which runs at the CPU clock.
+ * This takes over timer 1, i.e. the PWM on pins 9 and 10 is not available while
+ * benchmarking. On the host (see HostSim) every measurement is taken twice: with the
+ * simulated AVR cycle counter and natively in nanoseconds. The simulation has no cost
+ * model for instructions, its counter only advances by what the simulated peripherals
+ * (EEPROM, I2C, ADC, Serial, delays) charge, so pure computation reports 0 there and is
+ * only covered by the nanoseconds. The host report labels the column "peripheral cycles"
+ * accordingly.
+ */
+
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <WProgram.h>
+
+#define BENCHMARK_BUCKETS 124
+
+/**
+ * Histogram of measured values, see above.
+ */
+class BenchmarkStats {
+  public:
+    BenchmarkStats();
+
+    void clear();
+    void add(unsigned long value);
+
+    unsigned long count() { return _count; };
+    unsigned long minimum() { return _min; };
+    unsigned long maximum() { return _max; };
+
+    /**
+     * @return the value below or equal to which <code>percent</code> percent of the values are.
+     *         The value is the upper bound of the bucket, but never larger than the maximum.
+     */
+    unsigned long percentile(uint8_t percent);
+    unsigned long median() { return percentile(50); };
+
+    static uint8_t bucketOf(unsigned long value);
+    static unsigned long upperBoundOf(uint8_t bucket);
+
+  private:
+    unsigned long _count;
+    unsigned long _min;
+    unsigned long _max;
+    // Saturates at 65535 samples per bucket
+    uint16_t _buckets[BENCHMARK_BUCKETS];
+};
+
+class Benchmark {
+  public:
+    /**
+     * Starts the cycle counter and measures its own overhead, which is subtracted from
+     * every measurement. Has to be called once before the first measurement.
+     */
+    static void begin();
+
+    /**
+     * @return the current value of the cycle counter.
+     */
+    static unsigned long cycles();
+
+    Benchmark(const char *name);
+
+    void clear();
+
+    /**
+     * Starts a measurement. Everything between <code>start</code> and <code>stop</code> is
+     * counted as one call.
+     */
+    void start();
+    void stop();
+
+    const char *getName() { return _name; };
+    BenchmarkStats &getCycles() { return _cycles; };
+#ifndef __AVR__
+    BenchmarkStats &getNanos() { return _nanos; };
+#endif
+
+    /**
+     * Prints a line with count, min, median, p99 and max to <code>Serial</code>. The worst-case
+     * is also printed in microseconds.
+     */
+    void report();
+
+  private:
+    static void report(BenchmarkStats &stats, const char *unit);
+
+    static unsigned long _overhead;
+
+    const char *_name;
+    unsigned long _startCycles;
+    BenchmarkStats _cycles;
+#ifndef __AVR__
+    static unsigned long nanos();
+    static unsigned long _nanoOverhead;
+
+    unsigned long _startNanos;
+    BenchmarkStats _nanos;
+#endif
+};
+
+#endif /* BENCHMARK_H_ */
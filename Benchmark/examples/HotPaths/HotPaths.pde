@@ -0,0 +1,200 @@
+/*
+ * HotPaths.pde
+ *
+ * Measures the code that runs in the control loop of the thermostat: the set point
+ * lookups of the TemperatureManager for a whole year and every profile size, breakTime
+ * and makeTime over the range of the Time library, the time accessors of a clock that is
+ * read every second, PIDController::calculateOutput with and without its debug output and
+ * the decoding of the edges of a DHT22 transfer.
+ *
+ * Runs on the board and on the host, see HostSim/readme.txt. Note that benchmarking
+ * takes over timer 1 on the board.
+ */
+
+#include <Benchmark.h>
+#include <Time.h>
+#include <EEPROM.h>
+#include <WriteBackCache.h>
+#include <TemperatureProfile.h>
+#include <TemperatureProfileManager.h>
+#include <TemperatureManager.h>
+#include <PIDController.h>
+#include <Sensor.h>
+#include <DHT22.h>
+
+#define MEM_ADDR 0x100
+#define DHT22_PIN 7
+
+// Jan 1st 2011, 00:00:00
+#define YEAR_START 1293840000UL
+// 61 minutes, so every quarter of an hour is hit
+#define YEAR_STEP (61UL * 60UL)
+// Jan 1st 2100, 00:00:00
+#define TIME_END 4102444800UL
+// A week and an hour, so every day of the week and every hour is hit
+#define TIME_STEP (7UL * SECS_PER_DAY + 3601UL)
+
+boolean done = false;
+
+void setup() {
+  Serial.begin(9600);
+  Serial.println("====== Hot Path Benchmarks ======");
+
+  TemperatureProfileManager::setMemoryInfo(MEM_ADDR + 0x50, TemperatureProfile::MAX_SIZE);
+  TemperatureManager::setMemoryInfo(MEM_ADDR);
+  TPM.format();
+
+  // One profile for every number of entries, the entries evenly spread over 12 hours
+  for(int size = 1; size <= TemperatureProfile::MAX_SIZE; size++) {
+    TPROFILE.clear();
+    TPROFILE.setId(size);
+    TPROFILE.setName("BM");
+    for(int i = 0; i < size; i++) {
+      TPROFILE.add(i * 48 / size + size, 60 + i);
+    }
+    TPM.save();
+  }
+
+  Benchmark::begin();
+}
+
+void benchmarkSetPoints(int size) {
+  Benchmark getSetPointFor("getSetPointFor");
+  Benchmark nextSetPointChange("nextSetPointChange");
+
+  for(int day = TemperatureManager::SUNDAY; day < TemperatureManager::MAX_DAYS; day++) {
+    TEMPMGR.setProfile(size, (TemperatureManager::Days)day, TemperatureManager::AM, TemperatureManager::WINTER);
+    TEMPMGR.setProfile(size, (TemperatureManager::Days)day, TemperatureManager::PM, TemperatureManager::WINTER);
+  }
+  TEMPMGR.setTimeOfYear(TemperatureManager::WINTER);
+
+  for(unsigned long t = YEAR_START; t < YEAR_START + SECS_PER_YEAR; t += YEAR_STEP) {
+    getSetPointFor.start();
+    TEMPMGR.getSetPointFor(t);
+    getSetPointFor.stop();
+
+    nextSetPointChange.start();
+    TEMPMGR.nextSetPointChange(t);
+    nextSetPointChange.stop();
+  }
+
+  Serial.print("--- Profiles with ");
+  Serial.print(size);
+  Serial.println(" entries");
+  getSetPointFor.report();
+  nextSetPointChange.report();
+}
+
+void benchmarkTime() {
+  Benchmark breakTimeBench("breakTime");
+  Benchmark makeTimeBench("makeTime");
+  tmElements_t te;
+
+  for(unsigned long t = 0; t < TIME_END; t += TIME_STEP) {
+    breakTimeBench.start();
+    breakTime(t, te);
+    breakTimeBench.stop();
+
+    makeTimeBench.start();
+    makeTime(te);
+    makeTimeBench.stop();
+  }
+
+  Serial.println("--- Time");
+  breakTimeBench.report();
+  makeTimeBench.report();
+
+  // A clock shown every second, over a day
+  Benchmark accessorsBench("hour/minute/second");
+  for(unsigned long t = YEAR_START; t < YEAR_START + SECS_PER_DAY; t++) {
+    accessorsBench.start();
+    hour(t);
+    minute(t);
+    second(t);
+    accessorsBench.stop();
+  }
+  accessorsBench.report();
+}
+
+// The controller traces its terms to Serial, which costs far more than the math
+void benchmarkPID(const char *name, bool debugOutput) {
+  Benchmark bench(name);
+  PIDController pid(0.0, 100.0, 2.0, 0.5, 1.0, 68.0, 60.0);
+
+  pid.setDebugOutput(debugOutput);
+  pid.calculateOutput(60.0);
+  for(int i = 0; i < 200; i++) {
+    delay(10);
+    bench.start();
+    pid.calculateOutput(60.0 + (i % 20) * 0.5);
+    bench.stop();
+  }
+  bench.report();
+}
+
+void benchmarkDHT22() {
+  Benchmark bench("DHT22 decoder");
+  DHT22 dht(DHT22_PIN);
+  DHT22Decoder decoder;
+  uint8_t edges[3 + 2 * DHT22_DATA_BIT_COUNT];
+  uint8_t frame[5];
+  int errors = 0;
+
+  for(int i = 0; i < 1000; i++) {
+    unsigned int humidity = (i * 7) % 1000;
+    int temperature = (i * 13) % 1200 - 400;
+    unsigned int rawTemperature = temperature < 0 ? (0x8000 | -temperature) : temperature;
+    int n = 0;
+
+    frame[0] = humidity >> 8;
+    frame[1] = humidity & 0xff;
+    frame[2] = rawTemperature >> 8;
+    frame[3] = rawTemperature & 0xff;
+    frame[4] = frame[0] + frame[1] + frame[2] + frame[3];
+
+    // Edges as captured by the interrupt: bit 7 the level, bits 0..6 the width of the previous level
+    edges[n++] = 28;
+    edges[n++] = 0x80 | 80;
+    edges[n++] = 80;
+    for(int bit = 0; bit < DHT22_DATA_BIT_COUNT; bit++) {
+      edges[n++] = 0x80 | 50;
+      edges[n++] = (frame[bit / 8] & (0x80 >> (bit % 8))) ? 70 : 27;
+    }
+
+    bench.start();
+    decoder.reset();
+    for(int e = 0; e < n; e++) {
+      decoder.edge(edges[e] & 0x7f, edges[e] >> 7);
+    }
+    if((decoder.error() != DHT_ERROR_NONE) || (dht.decode(decoder.frame()) != Sensor::NO_ERROR)) {
+      errors++;
+    }
+    bench.stop();
+  }
+  Serial.println("--- Sensors");
+  bench.report();
+  if(errors > 0) {
+    Serial.print("DHT22 decoder failed for ");
+    Serial.print(errors);
+    Serial.println(" frames");
+  }
+}
+
+void loop() {
+  // Run the benchmarks only once
+  if(done) {
+    return;
+  }
+
+  for(int size = 1; size <= TemperatureProfile::MAX_SIZE; size++) {
+    benchmarkSetPoints(size);
+  }
+  benchmarkTime();
+  Serial.println("--- Controller");
+  benchmarkPID("PIDController::calculateOutput", false);
+  benchmarkPID("PIDController::calculateOutput with debug output", true);
+  benchmarkDHT22();
+
+  Serial.println("====== Done ======");
+  done = true;
+}
@@ -0,0 +1,207 @@
+/*
+ * SensorDispatch.pde
+ *
+ * Compares the virtual Sensor framework (SensorImpl, SensorAdapter) with the compile time
+ * variant (StaticSensorImpl, StaticSensorAdapter, see Sensor/StaticSensor.h) for an SHT21, an
+ * ACS712 and a DHT22: the latency of the calls and the RAM of the objects. The drivers of the
+ * library are SensorImpl drivers, the compile time variant calls them qualified. A thin DHT22 frame
+ * driver is built on both bases, so the difference of a driver without virtual methods shows as well.
+ * <p>
+ * The flash a variant costs is compared by building the sketch three times and comparing
+ * the output of avr-size:
+ * <pre>
+ *   SENSORDISPATCH_VARIANT 0   both variants (default)
+ *   SENSORDISPATCH_VARIANT 1   only the virtual variant
+ *   SENSORDISPATCH_VARIANT 2   only the compile time variant
+ * </pre>
+ * Runs on the board and on the host, see HostSim/readme.txt. On the board an SHT21 has to be
+ * connected to the I2C bus and an ACS712 to analog pin 0. Note that benchmarking takes over
+ * timer 1 on the board.
+ */
+
+#include <Benchmark.h>
+#include <Wire.h>
+#include <Sensor.h>
+#include <StaticSensor.h>
+#include <SHT21.h>
+#include <ACS712.h>
+#include <DHT22.h>
+
+#ifndef __AVR__
+#include <SimI2C.h>
+SimSHT21 sht21Chip;
+#endif
+
+#ifndef SENSORDISPATCH_VARIANT
+#define SENSORDISPATCH_VARIANT 0
+#endif
+
+#define VIRTUAL_VARIANT (SENSORDISPATCH_VARIANT != 2)
+#define STATIC_VARIANT (SENSORDISPATCH_VARIANT != 1)
+
+#define DHT22_PIN 7
+#define CALLS 500
+
+// The values of a DHT22 frame, decoded like DHT22::decode. The transfer is the same for both
+// variants, so the frame drivers below only differ in how they are called.
+class DHT22Values {
+  public:
+    DHT22Values() { _humidity = 0; _temperature = 0; };
+
+    Sensor::Error decode(const uint8_t *frame) {
+      if(frame[4] != ((frame[0] + frame[1] + frame[2] + frame[3]) & 0xff)) {
+        return Sensor::CHECKSUM_ERROR;
+      }
+      _humidity = ((frame[0] << 8) | frame[1]) & 0x7fff;
+      _temperature = ((frame[2] & 0x7f) << 8) | frame[3];
+      if(frame[2] & 0x80) {
+        _temperature = -_temperature;
+      }
+      return Sensor::NO_ERROR;
+    };
+
+    float value(int config) {
+      if(config == DHT22::Humidity) {
+        return _humidity / 10.0;
+      }
+      if(config == DHT22::TemperatureF) {
+        return _temperature / 10.0 * 1.8 + 32;
+      }
+      return _temperature / 10.0;
+    };
+
+  private:
+    int _humidity;
+    int _temperature;
+};
+
+class VirtualDHT22: public SensorImpl {
+  public:
+    DHT22Values values;
+
+    float getFloatValue(int config = 0) { return values.value(config); };
+
+  protected:
+    Sensor::Error readSensorImpl(unsigned long, int = 0) { return NO_ERROR; };
+};
+
+class StaticDHT22: public StaticSensorImpl<StaticDHT22> {
+  public:
+    DHT22Values values;
+
+    float getFloatValue(int config = 0) { return values.value(config); };
+    Sensor::Error readSensorImpl(unsigned long, int = 0) { return Sensor::NO_ERROR; };
+};
+
+SHT21 sht21;
+ACS712 acs712;
+DHT22 dht22(DHT22_PIN);
+// A valid frame, so the DHT22 returns real values
+const uint8_t dhtFrame[5] = { 0x02, 0x8c, 0x00, 0xe7, 0x75 };
+
+#if VIRTUAL_VARIANT
+SensorAdapter humidity(&sht21, SHT21::Humidity);
+SensorAdapter current(&acs712, 0);
+SensorAdapter dhtHumidity(&dht22, DHT22::Humidity);
+// Called through Sensor pointers, like the SensorScheduler does
+Sensor *virtualHumidity = &humidity;
+Sensor *virtualCurrent = &current;
+Sensor *virtualDHTHumidity = &dhtHumidity;
+VirtualDHT22 virtualDHT22;
+SensorAdapter dhtFrameHumidity(&virtualDHT22, DHT22::Humidity);
+Sensor *virtualDHTFrameHumidity = &dhtFrameHumidity;
+#endif
+
+#if STATIC_VARIANT
+StaticSensorAdapter<SHT21, SHT21::Humidity> staticHumidity(sht21);
+StaticSensorAdapter<ACS712, 0> staticCurrent(acs712);
+StaticSensorAdapter<DHT22, DHT22::Humidity> staticDHTHumidity(dht22);
+StaticDHT22 staticDHT22;
+StaticSensorAdapter<StaticDHT22, DHT22::Humidity> staticDHTFrameHumidity(staticDHT22);
+#endif
+
+boolean done = false;
+volatile float sink;
+
+void setup() {
+  Serial.begin(9600);
+  Serial.println("====== Sensor Dispatch Benchmarks ======");
+
+#ifndef __AVR__
+  SimI2CBus::instance.attach(&sht21Chip);
+#endif
+  Wire.begin();
+  sht21.initialize();
+  acs712.initialize(0);
+  dht22.decode(dhtFrame);
+#if VIRTUAL_VARIANT
+  virtualDHT22.values.decode(dhtFrame);
+#endif
+#if STATIC_VARIANT
+  staticDHT22.values.decode(dhtFrame);
+#endif
+
+  Benchmark::begin();
+}
+
+void printSize(const char *name, int size) {
+  Serial.print("  sizeof(");
+  Serial.print(name);
+  Serial.print("): ");
+  Serial.println(size);
+}
+
+// The IDE generates prototypes for all functions of a sketch, which does not work for function
+// templates, so the loop is a macro. It is used with getFloatValue, which only returns the last
+// value, i.e. mostly measures the cost of the call, and with readSensor of the ACS712, which
+// adds an ADC conversion.
+#define BENCHMARK_CALLS(name, call) \
+  { \
+    Benchmark bench(name); \
+    for(int i = 0; i < CALLS; i++) { \
+      bench.start(); \
+      call; \
+      bench.stop(); \
+    } \
+    bench.report(); \
+  }
+
+void loop() {
+  // Run the benchmarks only once
+  if(done) {
+    return;
+  }
+
+#if VIRTUAL_VARIANT
+  Serial.println("--- Virtual (SensorAdapter -> SensorImpl)");
+  BENCHMARK_CALLS("SHT21 getFloatValue", sink = virtualHumidity->getFloatValue());
+  BENCHMARK_CALLS("ACS712 getFloatValue", sink = virtualCurrent->getFloatValue());
+  BENCHMARK_CALLS("DHT22 getFloatValue", sink = virtualDHTHumidity->getFloatValue());
+  BENCHMARK_CALLS("ACS712 readSensor", virtualCurrent->readSensor(millis()));
+  BENCHMARK_CALLS("DHT22 frame getFloatValue", sink = virtualDHTFrameHumidity->getFloatValue());
+  BENCHMARK_CALLS("DHT22 frame readSensor", virtualDHTFrameHumidity->readSensor(millis()));
+  printSize("SensorAdapter", sizeof(SensorAdapter));
+  printSize("VirtualDHT22 (SensorImpl)", sizeof(VirtualDHT22));
+#endif
+
+#if STATIC_VARIANT
+  Serial.println("--- Compile time (StaticSensorAdapter)");
+  BENCHMARK_CALLS("SHT21 getFloatValue", sink = staticHumidity.getFloatValue());
+  BENCHMARK_CALLS("ACS712 getFloatValue", sink = staticCurrent.getFloatValue());
+  BENCHMARK_CALLS("DHT22 getFloatValue", sink = staticDHTHumidity.getFloatValue());
+  BENCHMARK_CALLS("ACS712 readSensor", staticCurrent.readSensor(millis()));
+  BENCHMARK_CALLS("DHT22 frame getFloatValue", sink = staticDHTFrameHumidity.getFloatValue());
+  BENCHMARK_CALLS("DHT22 frame readSensor", staticDHTFrameHumidity.readSensor(millis()));
+  printSize("StaticSensorAdapter", sizeof(staticHumidity));
+  printSize("StaticDHT22 (StaticSensorImpl)", sizeof(StaticDHT22));
+
+  // Erased back to a Sensor, e.g. for the SensorScheduler
+  ErasedSensor<StaticSensorAdapter<SHT21, SHT21::Humidity> > erased(staticHumidity);
+  Sensor *erasedHumidity = &erased;
+  BENCHMARK_CALLS("SHT21 getFloatValue (erased)", sink = erasedHumidity->getFloatValue());
+#endif
+
+  printSize("DHT22", sizeof(DHT22));
+  Serial.println("====== Done ======");
+  done = true;
+}
@@ -0,0 +1,85 @@
+#include <ArduinoUnit.h>
+#include <Benchmark.h>
+
+TestSuite suite;
+
+void setup() {
+  Serial.begin(9600);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(empty) {
+  BenchmarkStats stats;
+
+  assertUnsignedLongEquals(0, stats.count());
+  assertUnsignedLongEquals(0, stats.median());
+  assertUnsignedLongEquals(0, stats.percentile(99));
+}
+
+test(buckets) {
+  // Small values have their own bucket
+  for(unsigned long v = 0; v < 8; v++) {
+    assertEquals(v, BenchmarkStats::bucketOf(v));
+    assertUnsignedLongEquals(v, BenchmarkStats::upperBoundOf(v));
+  }
+  assertEquals(8, BenchmarkStats::bucketOf(8));
+  assertEquals(8, BenchmarkStats::bucketOf(9));
+  assertEquals(9, BenchmarkStats::bucketOf(10));
+  assertUnsignedLongEquals(9, BenchmarkStats::upperBoundOf(8));
+  assertUnsignedLongEquals(15, BenchmarkStats::upperBoundOf(11));
+  assertEquals(12, BenchmarkStats::bucketOf(16));
+
+  // Every value is within its bucket and the buckets are contiguous
+  for(unsigned long v = 1; v < 100000; v++) {
+    uint8_t bucket = BenchmarkStats::bucketOf(v);
+    assertTrue(v <= BenchmarkStats::upperBoundOf(bucket));
+    assertTrue(v > BenchmarkStats::upperBoundOf(bucket - 1));
+  }
+  assertEquals(BENCHMARK_BUCKETS - 1, BenchmarkStats::bucketOf(0xffffffffUL));
+}
+
+test(percentiles) {
+  BenchmarkStats stats;
+
+  for(unsigned long v = 1; v <= 100; v++) {
+    stats.add(v);
+  }
+
+  assertUnsignedLongEquals(100, stats.count());
+  assertUnsignedLongEquals(1, stats.minimum());
+  assertUnsignedLongEquals(100, stats.maximum());
+  // 50 is in bucket 48...55, 99 in bucket 96...111, which is capped by the maximum
+  assertUnsignedLongEquals(55, stats.median());
+  assertUnsignedLongEquals(100, stats.percentile(99));
+  assertUnsignedLongEquals(1, stats.percentile(1));
+}
+
+test(outlier) {
+  BenchmarkStats stats;
+
+  for(int i = 0; i < 999; i++) {
+    stats.add(20);
+  }
+  stats.add(5000);
+
+  // 20 is in bucket 20...23
+  assertUnsignedLongEquals(23, stats.median());
+  assertUnsignedLongEquals(23, stats.percentile(99));
+  assertUnsignedLongEquals(5000, stats.maximum());
+}
+
+test(clear) {
+  BenchmarkStats stats;
+
+  stats.add(10);
+  stats.add(20);
+  stats.clear();
+  stats.add(30);
+
+  assertUnsignedLongEquals(1, stats.count());
+  assertUnsignedLongEquals(30, stats.minimum());
+  assertUnsignedLongEquals(30, stats.median());
+}
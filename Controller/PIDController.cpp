@@ -16,6 +16,7 @@ PIDController::PIDController(float uMin, float uMax,
   updateSetpoint(setpoint);
   
 	reset(y);
+  debugOutput = true;
 }
 
 
@@ -55,31 +56,32 @@ float PIDController::calculateOutput(float y) {
   
   // Proportional term
   p = pGain * e;
-  Serial.print("p:");
-  Serial.print(p);
   
   // We forward calucalated the integral part
   i = iGain * integral;
-  Serial.print(", i:");
-  Serial.print(i);
   
   // Backward calculation of differential part
   d = dGain * (y - lastY) / h;
-  Serial.print(", d:");
-	Serial.print(d);
   
   // Calculate new u value 
   // d is negative, b/c a positive gain means we need to slow down
 	v = p + i - d;
   
-  Serial.print(", v");
-	Serial.print(v);
-  
   // limit the control value
   u = limitControl(v);
-  Serial.print(", u");
-	Serial.println(u);
-  
+
+  if(debugOutput) {
+    Serial.print("p:");
+    Serial.print(p);
+    Serial.print(", i:");
+    Serial.print(i);
+    Serial.print(", d:");
+    Serial.print(d);
+    Serial.print(", v");
+    Serial.print(v);
+    Serial.print(", u");
+    Serial.println(u);
+  }
 
   // Avoid integral windup. If the we reached max output,
   // we suspend further integration, i.e. the integral part
@@ -126,6 +128,10 @@ float PIDController::getLastY() {
   return lastY;
 }
 
+void PIDController::setDebugOutput(bool on) {
+  debugOutput = on;
+}
+
 void PIDController::printDebug() {
   Serial.print(" setpoint:");
   Serial.print(setpoint);
@@ -26,6 +26,11 @@ public:
   
   void printDebug();
 
+  /**
+   * Turns the trace of the terms that calculateOutput prints to Serial on or off. It is on by default.
+   */
+  void setDebugOutput(bool on);
+
 private:
   // Limits for controll function
   float uMin;
@@ -43,6 +48,7 @@ private:
   // running parameters
   float integral;
   int state;
+  bool debugOutput;
   
   float lastY;
   
@@ -56,190 +56,567 @@ extern "C" {
 #define DIRECT_WRITE_LOW(base, mask)	((*(base+2)) &= ~(mask))
 //#define DIRECT_WRITE_HIGH(base, mask)	((*(base+2)) |= (mask))
 
-// This should be 40, but the sensor is adding an extra bit at the start
-#define DHT22_DATA_BIT_COUNT 41
+DHT22 *DHT22::_receivers[2] = { 0, 0 };
 
 DHT22::DHT22(uint8_t pin)
 {
     _bitmask =  digitalPinToBitMask(pin);
     _baseReg = portInputRegister(digitalPinToPort(pin));
-    _lastReadTime = millis();
-    _lastHumidity = DHT22_ERROR_VALUE;
-    _lastTemperature = DHT22_ERROR_VALUE;
+    // External interrupts INT0 and INT1 are on pin 2 and 3
+    _interrupt = ((pin == 2) || (pin == 3)) ? pin - 2 : -1;
+    _async = false;
+    _reading = false;
+    _edgeHead = _edgeTail = 0;
+    initialize();
+}
+
+Sensor::Error DHT22::initialize()
+{
+  if(_reading)
+  {
+    stopReading(NO_ERROR);
+  }
+  _lastHumidity = (int)(DHT22_ERROR_VALUE * 10);
+  _lastTemperature = (int)(DHT22_ERROR_VALUE * 10);
+  _valid = false;
+  _result = NO_ERROR;
+
+  SensorImpl::initialize();
+  // The sensor needs 2 s after power up as well
+  clockReset(millis());
+
+  return NO_ERROR;
+}
+
+Sensor::Error DHT22::reset()
+{
+  return initialize();
 }
 
 //
-// Read the 40 bit data stream from the DHT 22
-// Store the results in private member data to be read by public member functions
+// Read the 40 bit data stream from the DHT 22, both values come with one transfer
+//
+Sensor::Error DHT22::readSensorImpl(unsigned long timeInMillis, int config)
+{
+  Sensor::Error err;
+
+  if(!_reading && _valid && (timeInMillis - lastReadTime() < READ_INTERVAL))
+  {
+    // Too early for the next transfer, the last values are still good
+    reuseValues();
+    return NO_ERROR;
+  }
+
+  if(_async)
+  {
+    return _reading ? poll() : startReading(timeInMillis);
+  }
+
+  err = startReading(timeInMillis);
+  while(err == MEASUREMENT_PENDING)
+  {
+    // The edges are captured in the background, there is no need to poll faster
+    delayMicroseconds(10);
+    err = poll();
+  }
+
+  return err;
+}
+
 //
-int DHT22::readSensor(unsigned long currentTime)
+// Send the start pulse and start capturing the edges of the transfer
+//
+Sensor::Error DHT22::startReading(unsigned long timeInMillis)
 {
-  uint8_t bitmask = _bitmask;
-  volatile uint8_t *reg asm("r30") = _baseReg;
   uint8_t retryCount;
-  uint8_t bitTimes[DHT22_DATA_BIT_COUNT];
-  int currentHumidity;
-  int currentTemperature;
-  uint8_t checkSum, csPart1, csPart2, csPart3, csPart4;
-  int i;
 
-  currentHumidity = 0;
-  currentTemperature = 0;
-  checkSum = 0;
-  currentTime = millis();
-  for(i = 0; i < DHT22_DATA_BIT_COUNT; i++)
+  if(_reading)
   {
-    bitTimes[i] = 0;
+    stopReading(NO_ERROR);
   }
 
-  if(currentTime - _lastReadTime < 2000)
+  if(timeInMillis - lastReadTime() < READ_INTERVAL)
   {
     // Caller needs to wait 2 seconds between each call to readData
-    return DHT_ERROR_TOOQUICK;
+    return TOO_QUICK;
   }
-  _lastReadTime = currentTime;
+  clockReset(timeInMillis);
 
   // Pin needs to start HIGH, wait until it is HIGH with a timeout
   cli();
-  DIRECT_MODE_INPUT(reg, bitmask);
+  DIRECT_MODE_INPUT(_baseReg, _bitmask);
   sei();
   retryCount = 0;
   do
   {
     if (retryCount > 125)
     {
-      return DHT_BUS_HUNG;
+      return BUS_ERROR;
     }
     retryCount++;
     delayMicroseconds(2);
-  } while(!DIRECT_READ(reg, bitmask));
+  } while(!DIRECT_READ(_baseReg, _bitmask));
   // Send the activate pulse
   cli();
-  DIRECT_WRITE_LOW(reg, bitmask);
-  DIRECT_MODE_OUTPUT(reg, bitmask); // Output Low
+  DIRECT_WRITE_LOW(_baseReg, _bitmask);
+  DIRECT_MODE_OUTPUT(_baseReg, _bitmask); // Output Low
   sei();
   delayMicroseconds(1100); // 1.1 ms
+
+  _decoder.reset();
+  _edgeHead = _edgeTail = 0;
+  _reading = true;
+
   cli();
-  DIRECT_MODE_INPUT(reg, bitmask);	// Switch back to input so pin can float
+  DIRECT_MODE_INPUT(_baseReg, _bitmask);	// Switch back to input so pin can float
+  _lastEdge = micros();
+  _readStart = _lastEdge;
   sei();
-  // Find the start of the ACK Pulse
-  retryCount = 0;
-  do
+
+  if(_interrupt >= 0)
+  {
+#ifdef __AVR__
+    // Forget the edges of the start pulse
+    EIFR = _BV(_interrupt);
+#endif
+    _receivers[_interrupt] = this;
+    attachInterrupt(_interrupt, _interrupt ? edgeInterrupt1 : edgeInterrupt0, CHANGE);
+  }
+
+  return MEASUREMENT_PENDING;
+}
+
+//
+// Decode the edges captured so far
+//
+Sensor::Error DHT22::poll()
+{
+  uint8_t edge;
+
+  if(!_reading)
   {
-    if (retryCount > 25) //(Spec is 20 to 40 us, 25*2 == 50 us)
+    return _result;
+  }
+
+  if(_interrupt < 0)
+  {
+    capturePolling();
+  }
+
+  while((_edgeTail != _edgeHead) && !_decoder.isDone())
+  {
+    edge = _edges[_edgeTail];
+    _edgeTail = (_edgeTail + 1) % DHT22_EDGE_BUFFER;
+    _decoder.edge(edge & 0x7f, edge >> 7);
+  }
+
+  if(_decoder.isDone())
+  {
+    if(_decoder.error() != DHT_ERROR_NONE)
     {
-      return DHT_ERROR_NOT_PRESENT;
+      return stopReading(sensorError(_decoder.error()));
     }
-    retryCount++;
-    delayMicroseconds(2);
-  } while(!DIRECT_READ(reg, bitmask));
-  // Find the end of the ACK Pulse
-  retryCount = 0;
-  do
+    return stopReading(decode(_decoder.frame()));
+  }
+
+  if(micros() - _readStart > TRANSFER_TIMEOUT)
+  {
+    return stopReading(_decoder.isAcknowledged() ? DATA_TIMEOUT : SENSOR_NOT_PRESENT);
+  }
+
+  return MEASUREMENT_PENDING;
+}
+
+//
+// Converts the frame to humidity and temperature
+// Store the results in private member data to be read by public member functions
+//
+Sensor::Error DHT22::decode(const uint8_t *frame)
+{
+  unsigned int currentHumidity = (frame[0] << 8) | frame[1];
+  unsigned int currentTemperature = (frame[2] << 8) | frame[3];
+
+  // The check sum covers the raw data, including the sign bit of the temperature
+  if(frame[4] != ((frame[0] + frame[1] + frame[2] + frame[3]) & 0xFF))
+  {
+    return CHECKSUM_ERROR;
+  }
+
+  _lastHumidity = currentHumidity & 0x7FFF;
+  if(currentTemperature & 0x8000)
+  {
+   // Below zero, non standard way of encoding negative numbers!
+    currentTemperature &= 0x7FFF;
+    _lastTemperature = -(int)currentTemperature;
+  }
+  else
+  {
+    _lastTemperature = currentTemperature;
+  }
+  _valid = true;
+
+  return NO_ERROR;
+}
+
+int DHT22::getIntegerValue(int config)
+{
+  if(config == Humidity)
+  {
+    return _lastHumidity;
+  }
+  if(config == TemperatureF)
+  {
+    return fixedDivide(getTemperatureFixed(false), 10);
+  }
+  return _lastTemperature;
+}
+
+byte DHT22::getByteValue(int config)
+{
+  return (byte)fixedDivide(getFixedValue(config), FIXED_SCALE);
+}
+
+float DHT22::getFloatValue(int config)
+{
+  if(config == Humidity)
+  {
+    return float(_lastHumidity) / 10.0;
+  }
+  if(config == TemperatureF)
+  {
+    return (float(_lastTemperature) / 10.0) * 1.8 + 32;
+  }
+  return float(_lastTemperature) / 10.0;
+}
+
+int DHT22::getFixedValue(int config)
+{
+  if(config == Humidity)
+  {
+    return getHumidityFixed();
+  }
+  return getTemperatureFixed(config != TemperatureF);
+}
+
+int DHT22::getTemperatureFixed(bool celsius)
+{
+  if(!celsius) {
+    // 0.1 C is 0.18 F, i.e. 18 hundredths
+    return _lastTemperature * 18 + 3200;
+  }
+  return _lastTemperature * 10;
+}
+
+Sensor::Error DHT22::sensorError(DHT22_ERROR_t error)
+{
+  switch(error)
+  {
+    case DHT_ERROR_NONE:
+      return NO_ERROR;
+    case DHT_BUS_HUNG:
+      return BUS_ERROR;
+    case DHT_ERROR_NOT_PRESENT:
+      return SENSOR_NOT_PRESENT;
+    case DHT_ERROR_ACK_TOO_LONG:
+    case DHT_ERROR_SYNC_TIMEOUT:
+      return SYNC_TIMEOUT;
+    case DHT_ERROR_DATA_TIMEOUT:
+      return DATA_TIMEOUT;
+    case DHT_ERROR_CHECKSUM:
+      return CHECKSUM_ERROR;
+    case DHT_ERROR_TOOQUICK:
+      return TOO_QUICK;
+    case DHT_ERROR_PENDING:
+      return MEASUREMENT_PENDING;
+  }
+  return FUNCTION_NOT_SUPPORTED;
+}
+
+//
+// Edge capture
+//
+
+void DHT22::edgeInterrupt0()
+{
+  DHT22 *receiver = _receivers[0];
+
+  if(receiver)
+  {
+    receiver->captureEdge(DIRECT_READ(receiver->_baseReg, receiver->_bitmask));
+  }
+}
+
+void DHT22::edgeInterrupt1()
+{
+  DHT22 *receiver = _receivers[1];
+
+  if(receiver)
+  {
+    receiver->captureEdge(DIRECT_READ(receiver->_baseReg, receiver->_bitmask));
+  }
+}
+
+//
+// Store the time since the previous edge and the new level in the ring buffer
+//
+void DHT22::captureEdge(uint8_t level)
+{
+  unsigned long now = micros();
+  unsigned long width = now - _lastEdge;
+  uint8_t next = (_edgeHead + 1) % DHT22_EDGE_BUFFER;
+
+  _lastEdge = now;
+  if(next != _edgeTail)
   {
-    if (retryCount > 50) //(Spec is 80 us, 50*2 == 100 us)
+    _edges[_edgeHead] = (level ? 0x80 : 0) | (width > 127 ? 127 : width);
+    _edgeHead = next;
+  }
+}
+
+//
+// Without an interrupt the pin is sampled until the frame is complete
+//
+void DHT22::capturePolling()
+{
+  uint8_t level = DIRECT_READ(_baseReg, _bitmask);
+  uint8_t edge;
+
+  while(!_decoder.isDone() && (micros() - _readStart <= TRANSFER_TIMEOUT))
+  {
+    if(DIRECT_READ(_baseReg, _bitmask) != level)
     {
-      return DHT_ERROR_ACK_TOO_LONG;
+      level = !level;
+      captureEdge(level);
+      edge = _edges[_edgeTail];
+      _edgeTail = (_edgeTail + 1) % DHT22_EDGE_BUFFER;
+      _decoder.edge(edge & 0x7f, edge >> 7);
     }
-    retryCount++;
-    delayMicroseconds(2);
-  } while(DIRECT_READ(reg, bitmask));
-  // Read the 40 bit data stream
-  for(i = 0; i < DHT22_DATA_BIT_COUNT; i++)
+    // Paced like the sampling of DHT22Group, which also lets the simulated time pass on the host
+    delayMicroseconds(DHT22Group::SAMPLE_MICROS);
+  }
+}
+
+Sensor::Error DHT22::stopReading(Sensor::Error error)
+{
+  if((_interrupt >= 0) && (_receivers[_interrupt] == this))
   {
-    // Find the start of the sync pulse
-    retryCount = 0;
-    do
+    detachInterrupt(_interrupt);
+    _receivers[_interrupt] = 0;
+  }
+  _reading = false;
+  _result = error;
+
+  return error;
+}
+
+// ---- DHT22Group ------
+
+DHT22Group::DHT22Group()
+{
+  _count = 0;
+  _baseReg = 0;
+}
+
+bool DHT22Group::add(DHT22 *sensor)
+{
+  if((_count == MAX_SENSORS) || (_count && (sensor->_baseReg != _baseReg)))
+  {
+    return false;
+  }
+  _baseReg = sensor->_baseReg;
+  _sensors[_count++] = sensor;
+
+  return true;
+}
+
+Sensor::Error DHT22Group::readSensors(unsigned long timeInMillis)
+{
+  unsigned long lastEdge[MAX_SENSORS];
+  unsigned long start;
+  unsigned long now;
+  unsigned long width;
+  uint8_t mask = 0;
+  uint8_t pending;
+  uint8_t sample;
+  uint8_t last;
+  uint8_t changed;
+  uint8_t retryCount;
+  DHT22 *sensor;
+  Sensor::Error err = Sensor::NO_ERROR;
+
+  for(uint8_t i = 0; i < _count; i++)
+  {
+    sensor = _sensors[i];
+    if(sensor->_reading)
     {
-      if (retryCount > 35) //(Spec is 50 us, 35*2 == 70 us)
-      {
-        return DHT_ERROR_SYNC_TIMEOUT;
-      }
-      retryCount++;
-      delayMicroseconds(2);
-    } while(!DIRECT_READ(reg, bitmask));
-    // Measure the width of the data pulse
-    retryCount = 0;
-    do
+      sensor->stopReading(Sensor::NO_ERROR);
+    }
+    if(timeInMillis - sensor->lastReadTime() >= DHT22::READ_INTERVAL)
     {
-      if (retryCount > 50) //(Spec is 80 us, 50*2 == 100 us)
-      {
-        return DHT_ERROR_DATA_TIMEOUT;
-      }
-      retryCount++;
-      delayMicroseconds(2);
-    } while(DIRECT_READ(reg, bitmask));
-    bitTimes[i] = retryCount;
-  }
-  // Now bitTimes have the number of retries (us *2)
-  // that were needed to find the end of each data bit
-  // Spec: 0 is 26 to 28 us
-  // Spec: 1 is 70 us
-  // bitTimes[x] <= 11 is a 0
-  // bitTimes[x] >  11 is a 1
-  // Note: the bits are offset by one from the data sheet, not sure why
-  for(i = 0; i < 16; i++)
-  {
-    if(bitTimes[i + 1] > 11)
+      mask |= sensor->_bitmask;
+      sensor->clockReset(timeInMillis);
+      sensor->_decoder.reset();
+    }
+    else if(!sensor->_valid && (err == Sensor::NO_ERROR))
     {
-      currentHumidity |= (1 << (15 - i));
+      err = Sensor::TOO_QUICK;
     }
   }
-  for(i = 0; i < 16; i++)
+  if(!mask)
   {
-    if(bitTimes[i + 17] > 11)
-    {
-      currentTemperature |= (1 << (15 - i));
-    }
+    return err;
   }
-  for(i = 0; i < 8; i++)
+
+  // All lines need to start HIGH, wait until they are HIGH with a timeout
+  cli();
+  DIRECT_MODE_INPUT(_baseReg, mask);
+  sei();
+  retryCount = 0;
+  while((*_baseReg & mask) != mask)
   {
-    if(bitTimes[i + 33] > 11)
+    if(retryCount > 125)
     {
-      checkSum |= (1 << (7 - i));
+      return Sensor::BUS_ERROR;
     }
+    retryCount++;
+    delayMicroseconds(2);
   }
+  // Send the activate pulse to all sensors at once
+  cli();
+  DIRECT_WRITE_LOW(_baseReg, mask);
+  DIRECT_MODE_OUTPUT(_baseReg, mask);
+  sei();
+  delayMicroseconds(1100); // 1.1 ms
 
-  _lastHumidity = (float(currentHumidity & 0x7FFF) / 10.0);
-  if(currentTemperature & 0x8000)
+  cli();
+  DIRECT_MODE_INPUT(_baseReg, mask);
+  start = micros();
+  sei();
+  for(uint8_t i = 0; i < _count; i++)
   {
-   // Below zero, non standard way of encoding negative numbers!
-    currentTemperature &= 0x7FFF;
-    _lastTemperature = (float(currentTemperature) / 10.0) * -1.0;
+    lastEdge[i] = start;
   }
-  else
+
+  // Sample the port until all frames are complete. The pause paces the sampling, which also lets
+  // the simulated time pass on the host.
+  pending = mask;
+  last = *_baseReg;
+  while(pending && (micros() - start <= DHT22::TRANSFER_TIMEOUT))
   {
-    _lastTemperature = float(currentTemperature) / 10.0;
+    sample = *_baseReg;
+    changed = (sample ^ last) & pending;
+    if(changed)
+    {
+      now = micros();
+      for(uint8_t i = 0; i < _count; i++)
+      {
+        sensor = _sensors[i];
+        if(changed & sensor->_bitmask)
+        {
+          width = now - lastEdge[i];
+          lastEdge[i] = now;
+          if(sensor->_decoder.edge(width > 127 ? 127 : width, (sample & sensor->_bitmask) ? 1 : 0))
+          {
+            pending &= ~sensor->_bitmask;
+          }
+        }
+      }
+      last = sample;
+    }
+    delayMicroseconds(SAMPLE_MICROS);
   }
 
-  csPart1 = currentHumidity >> 8;
-  csPart2 = currentHumidity & 0xFF;
-  csPart3 = currentTemperature >> 8;
-  csPart4 = currentTemperature & 0xFF;
-  if(checkSum == ((csPart1 + csPart2 + csPart3 + csPart4) & 0xFF))
+  // Demultiplexed, now each sensor converts its own frame
+  for(uint8_t i = 0; i < _count; i++)
   {
-    return DHT_ERROR_NONE;
+    sensor = _sensors[i];
+    if(!(mask & sensor->_bitmask))
+    {
+      continue;
+    }
+    if(!sensor->_decoder.isDone())
+    {
+      sensor->_result = sensor->_decoder.isAcknowledged() ? Sensor::DATA_TIMEOUT : Sensor::SENSOR_NOT_PRESENT;
+    }
+    else if(sensor->_decoder.error() != DHT_ERROR_NONE)
+    {
+      sensor->_result = DHT22::sensorError(sensor->_decoder.error());
+    }
+    else
+    {
+      sensor->_result = sensor->decode(sensor->_decoder.frame());
+    }
+    if((sensor->_result != Sensor::NO_ERROR) && (err == Sensor::NO_ERROR))
+    {
+      err = sensor->_result;
+    }
   }
-  return DHT_ERROR_CHECKSUM;
+
+  return err;
 }
 
-float DHT22::getHumidity()
+// ---- DHT22Decoder ------
+
+void DHT22Decoder::reset()
 {
-  return _lastHumidity;
+  _state = WAIT_ACK;
+  _bitCount = 0;
+  _error = DHT_ERROR_NONE;
+  for(uint8_t i = 0; i < DHT22_DATA_BIT_COUNT / 8; i++)
+  {
+    _frame[i] = 0;
+  }
 }
 
-float DHT22::getTemperature(bool celsius)
+bool DHT22Decoder::edge(uint8_t width, uint8_t level)
 {
-  if(!celsius) {
-    return _lastTemperature * 1.8 + 32;
+  switch(_state)
+  {
+    case WAIT_ACK:
+      // The line goes high at the end of the low part of the acknowledge
+      if(level && (width >= ACK_LOW_MIN) && (width <= PULSE_MAX))
+      {
+        _state = ACK;
+      }
+      return false;
+    case ACK:
+      // Spec is 80 us for the high part
+      if(!level)
+      {
+        if(width > PULSE_MAX)
+        {
+          return fail(DHT_ERROR_ACK_TOO_LONG);
+        }
+        _state = DATA;
+      }
+      return false;
+    case DATA:
+      if(width > PULSE_MAX)
+      {
+        // The sync pulse (low, 50 us) or the data pulse (high) is too long
+        return fail(level ? DHT_ERROR_SYNC_TIMEOUT : DHT_ERROR_DATA_TIMEOUT);
+      }
+      if(!level)
+      {
+        // End of a data pulse, 26 to 28 us is a 0, 70 us a 1
+        _frame[_bitCount >> 3] = (_frame[_bitCount >> 3] << 1) | (width >= ONE_MIN ? 1 : 0);
+        _bitCount++;
+        if(_bitCount == DHT22_DATA_BIT_COUNT)
+        {
+          _state = DONE;
+          return true;
+        }
+      }
+      return false;
   }
-  return _lastTemperature;
+
+  return true;
 }
 
-//
-// This is used when the millis clock rolls over to zero
-//
-void DHT22::clockReset(unsigned long timeInMillis)
+bool DHT22Decoder::fail(DHT22_ERROR_t error)
 {
-  _lastReadTime = timeInMillis;
+  _error = error;
+  _state = DONE;
+
+  return true;
 }
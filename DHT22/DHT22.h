@@ -2,9 +2,19 @@
 #define _DHT22_H_
 
 #include <WProgram.h>
+#include <Sensor.h>
 
 #define DHT22_ERROR_VALUE -99.5
 
+// Humidity (16), temperature (16) and check sum (8)
+#define DHT22_DATA_BIT_COUNT 40
+
+// Edges captured during one transfer: start, acknowledge and two per bit
+#ifndef DHT22_EDGE_BUFFER
+#define DHT22_EDGE_BUFFER 96
+#endif
+
+// Errors of a transfer as the decoder reports them, readSensor maps them onto Sensor::Error
 typedef enum
 {
   DHT_ERROR_NONE = 0,
@@ -14,28 +24,181 @@ typedef enum
   DHT_ERROR_SYNC_TIMEOUT,
   DHT_ERROR_DATA_TIMEOUT,
   DHT_ERROR_CHECKSUM,
-  DHT_ERROR_TOOQUICK
+  DHT_ERROR_TOOQUICK,
+  DHT_ERROR_PENDING
 } DHT22_ERROR_t;
 
-class DHT22
+//
+// Assembles the 40 bits of a transfer edge by edge. Each edge is passed as the time in us the line
+// had the previous level (saturated at 127) and the new level. The decoder waits for the acknowledge
+// pulse (low for ~80 us), then skips its high part and reads one bit per high pulse:
+// 26-28 us is a 0, 70 us a 1.
+//
+class DHT22Decoder
+{
+  public:
+    // Width of the low part of the acknowledge
+    static const uint8_t ACK_LOW_MIN = 60;
+    // High pulses longer than this are a 1
+    static const uint8_t ONE_MIN = 48;
+    // No pulse of a transfer is longer than this
+    static const uint8_t PULSE_MAX = 110;
+
+    DHT22Decoder() { reset(); };
+
+    void reset();
+
+    // Feeds one edge, returns true if the frame is complete or the transfer failed
+    bool edge(uint8_t width, uint8_t level);
+
+    bool isDone() { return _state >= DONE; };
+    bool isAcknowledged() { return _state > WAIT_ACK; };
+    DHT22_ERROR_t error() { return _error; };
+    uint8_t bitCount() { return _bitCount; };
+
+    // The 5 bytes of the frame: humidity, temperature, check sum
+    const uint8_t *frame() { return _frame; };
+
+  private:
+    enum State { WAIT_ACK, ACK, DATA, DONE };
+
+    uint8_t _state;
+    uint8_t _bitCount;
+    uint8_t _frame[DHT22_DATA_BIT_COUNT / 8];
+    DHT22_ERROR_t _error;
+
+    bool fail(DHT22_ERROR_t error);
+};
+
+//
+// Reads a DHT22. The edges of a transfer are captured by an interrupt into a ring buffer if the
+// sensor is connected to pin 2 or 3 (INT0, INT1), so the CPU is free during the ~5 ms of the
+// transfer and the timing does not depend on the speed of a polling loop. On other pins the edges
+// are captured by polling the pin, timed with micros().
+//
+// One transfer contains humidity and temperature, so every readSensor reads both, whatever the
+// config. The sensor must not be read more often than every 2 s. Within that time readSensor
+// returns the values of the last good reading, TOO_QUICK is only returned if there is none yet.
+//
+// By default readSensor() blocks until the transfer is done. In asynchronous mode (setAsync(true))
+// the first call sends the start pulse (1.1 ms) and later calls return MEASUREMENT_PENDING until the
+// frame is complete. startReading() and poll() do the same explicitly.
+//
+class DHT22: public SensorImpl
 {
+  friend class DHT22Group;
+
   private:
     uint8_t _bitmask;
     volatile uint8_t *_baseReg;
-    unsigned long _lastReadTime;
-    float _lastHumidity;
-    float _lastTemperature;
+    int8_t _interrupt;
+    // In tenths, as sent by the sensor
+    int _lastHumidity;
+    int _lastTemperature;
+    bool _valid;
+    bool _async;
+
+    DHT22Decoder _decoder;
+    bool _reading;
+    unsigned long _readStart;
+    Sensor::Error _result;
+
+    // Ring buffer of edges: bit 7 the level after the edge, bits 0..6 the time since the
+    // previous edge in us
+    volatile uint8_t _edges[DHT22_EDGE_BUFFER];
+    volatile uint8_t _edgeHead;
+    uint8_t _edgeTail;
+    volatile unsigned long _lastEdge;
+
+    static DHT22 *_receivers[2];
+    static void edgeInterrupt0();
+    static void edgeInterrupt1();
+
+    void captureEdge(uint8_t level);
+    void capturePolling();
+    Sensor::Error stopReading(Sensor::Error error);
+
+  protected:
+    Sensor::Error readSensorImpl(unsigned long timeInMillis, int config = 0);
 
   public:
+    enum Mode {
+      TemperatureF = 0x00,
+      TemperatureC = 0x01,
+      Humidity = 0x02
+    };
+
+    // Maximum time of a transfer, from the end of the start pulse to the last bit
+    static const unsigned long TRANSFER_TIMEOUT = 10000;
+    // Minimum time between two transfers in ms
+    static const unsigned long READ_INTERVAL = 2000;
+
     DHT22(uint8_t pin);
 
-    int readSensor() { return readSensor(millis()); };
-    int readSensor(unsigned long timeInMillis);
-    float getHumidity();
-    float getTemperature(bool celsius);
+    Sensor::Error initialize();
+    Sensor::Error reset();
+
+    void setAsync(bool async) { _async = async; };
+    bool isAsync() { return _async; };
+
+    Sensor::Error startReading(unsigned long timeInMillis);
+    Sensor::Error poll();
+    bool isReading() { return _reading; };
 
-    void clockReset() { clockReset(millis()); };
-    void clockReset(unsigned long timeInMillis);
+    // Temperature and humidity in tenths, as sent by the sensor
+    int getIntegerValue(int config = 0);
+    // Temperature and humidity in whole units, rounded
+    byte getByteValue(int config = 0);
+    float getFloatValue(int config = 0);
+    // Temperature and humidity in hundredths
+    int getFixedValue(int config = 0);
+
+    float getHumidity() { return getFloatValue(Humidity); };
+    float getTemperature(bool celsius) { return getFloatValue(celsius ? TemperatureC : TemperatureF); };
+
+    // The values in hundredths, e.g. 2310 for 23.1 C, computed without floats
+    int getHumidityFixed() { return _lastHumidity * 10; };
+    int getTemperatureFixed(bool celsius);
+
+    // Converts the 5 bytes of a frame and verifies the check sum. The values are only taken over
+    // if the check sum matches.
+    Sensor::Error decode(const uint8_t *frame);
+
+    // The error of a transfer the decoder reports as Sensor::Error
+    static Sensor::Error sensorError(DHT22_ERROR_t error);
+};
+
+//
+// Reads several DHT22 that are connected to the same port at once. All sensors get the start pulse
+// at the same time and answer in parallel. The whole input register of the port is sampled in a loop
+// and the edges of each pin are fed to the decoder of its sensor, so reading N sensors takes one
+// transfer (~5 ms) instead of N. The values end up in the DHT22 objects, which return them from
+// readSensor until the next transfer is due, and poll() returns the result of the transfer of each
+// sensor.
+//
+class DHT22Group
+{
+  public:
+    // One port has 8 pins
+    static const uint8_t MAX_SENSORS = 8;
+    // Time between two samples of the port
+    static const uint8_t SAMPLE_MICROS = 2;
+
+    DHT22Group();
+
+    // Adds a sensor, returns false if the group is full or the sensor is on another port
+    bool add(DHT22 *sensor);
+    uint8_t count() { return _count; };
+
+    // Reads all sensors that may be read, i.e. were not read in the last 2 s. Returns NO_ERROR if all
+    // sensors have good values, otherwise the error of the first sensor that failed.
+    Sensor::Error readSensors() { return readSensors(millis()); };
+    Sensor::Error readSensors(unsigned long timeInMillis);
+
+  private:
+    DHT22 *_sensors[MAX_SENSORS];
+    uint8_t _count;
+    volatile uint8_t *_baseReg;
 };
 
 #endif /*_DHT22_H_*/
@@ -1,3 +1,4 @@
+#include <Sensor.h>
 #include <DHT22.h>
 
 // Data wire is plugged into port 7 on the Arduino
@@ -16,44 +17,39 @@ void setup(void)
 
 void loop(void)
 { 
-  DHT22_ERROR_t errorCode;
+  Sensor::Error errorCode;
 
   delay(2000);
   Serial.print("Requesting data...");
-  errorCode = myDHT22.readData();
+  errorCode = myDHT22.readSensor(millis());
   switch(errorCode)
   {
-    case DHT_ERROR_NONE:
+    case Sensor::NO_ERROR:
       Serial.print("Got Data ");
-      Serial.print(myDHT22.getTemperatureC());
+      Serial.print(myDHT22.getTemperature(true));
       Serial.print("C ");
       Serial.print(myDHT22.getHumidity());
       Serial.println("%");
       break;
-    case DHT_ERROR_CHECKSUM:
-      Serial.print("check sum error ");
-      Serial.print(myDHT22.getTemperatureC());
-      Serial.print("C ");
-      Serial.print(myDHT22.getHumidity());
-      Serial.println("%");
+    case Sensor::CHECKSUM_ERROR:
+      Serial.println("check sum error ");
       break;
-    case DHT_BUS_HUNG:
+    case Sensor::BUS_ERROR:
       Serial.println("BUS Hung ");
       break;
-    case DHT_ERROR_NOT_PRESENT:
+    case Sensor::SENSOR_NOT_PRESENT:
       Serial.println("Not Present ");
       break;
-    case DHT_ERROR_ACK_TOO_LONG:
-      Serial.println("ACK time out ");
-      break;
-    case DHT_ERROR_SYNC_TIMEOUT:
+    case Sensor::SYNC_TIMEOUT:
       Serial.println("Sync Timeout ");
       break;
-    case DHT_ERROR_DATA_TIMEOUT:
+    case Sensor::DATA_TIMEOUT:
       Serial.println("Data Timeout ");
       break;
-    case DHT_ERROR_TOOQUICK:
+    case Sensor::TOO_QUICK:
       Serial.println("Polled to quick ");
       break;
+    default:
+      break;
   }
 }
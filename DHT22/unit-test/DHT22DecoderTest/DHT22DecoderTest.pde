@@ -0,0 +1,275 @@
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <DHT22.h>
+#include <SampleHistory.h>
+#include <SensorHealth.h>
+#include <HostSim.h>
+
+TestSuite suite;
+
+#define DHT22_PIN 2
+// No external interrupt, the pin is polled
+#define POLLED_PIN 7
+
+// Transfer of 65.2 %RH and 23.1 C captured with the 4 us resolution of micros() on the board.
+// Bit 7 is the level after the edge, bits 0..6 the time in us the line had the previous level.
+const uint8_t capturedTrace[] = {
+  0x1c, 0xcc, 0x50, 0xb4, 0x18, 0xb0, 0x1c, 0xb4, 0x1c, 0xac, 0x1c, 0xac,
+  0x1c, 0xb4, 0x18, 0xb4, 0x44, 0xb0, 0x1c, 0xb4, 0x44, 0xb4, 0x18, 0xb4,
+  0x1c, 0xb0, 0x18, 0xb0, 0x48, 0xb4, 0x44, 0xac, 0x1c, 0xac, 0x18, 0xac,
+  0x18, 0xac, 0x1c, 0xb0, 0x18, 0xb4, 0x1c, 0xb4, 0x18, 0xb4, 0x18, 0xb0,
+  0x18, 0xac, 0x18, 0xb4, 0x44, 0xb0, 0x48, 0xb4, 0x48, 0xb0, 0x18, 0xb4,
+  0x1c, 0xb4, 0x44, 0xb0, 0x44, 0xb4, 0x44, 0xb0, 0x18, 0xac, 0x48, 0xb0,
+  0x44, 0xb0, 0x48, 0xb0, 0x1c, 0xac, 0x48, 0xb0, 0x1c, 0xb0, 0x44, 0xb0,
+};
+
+DHT22 dht(DHT22_PIN);
+DHT22 polled(POLLED_PIN);
+SimDHT22 chip;
+DHT22Decoder decoder;
+uint8_t trace[3 + 2 * DHT22_DATA_BIT_COUNT + 1];
+
+/**
+ * Builds the trace of a transfer of the given frame with nominal timing.
+ */
+int buildTrace(const uint8_t *frame) {
+  int n = 0;
+
+  trace[n++] = 30;
+  trace[n++] = 0x80 | 80;
+  trace[n++] = 80;
+  for(int bit = 0; bit < DHT22_DATA_BIT_COUNT; bit++) {
+    trace[n++] = 0x80 | 50;
+    trace[n++] = (frame[bit / 8] & (0x80 >> (bit % 8))) ? 70 : 27;
+  }
+  trace[n++] = 0x80 | 50;
+
+  return n;
+}
+
+int replay(const uint8_t *edges, int count) {
+  int i;
+
+  decoder.reset();
+  for(i = 0; i < count; i++) {
+    if(decoder.edge(edges[i] & 0x7f, edges[i] >> 7)) {
+      break;
+    }
+  }
+
+  return i;
+}
+
+void setup() {
+  Serial.begin(9600);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(capturedTransfer) {
+  // The last edge, the release of the line, is not needed
+  assertEquals(sizeof(capturedTrace) - 2, replay(capturedTrace, sizeof(capturedTrace)));
+  assertTrue(decoder.isDone());
+  assertEquals(DHT_ERROR_NONE, decoder.error());
+  assertEquals(Sensor::NO_ERROR, dht.decode(decoder.frame()));
+  assertTrue(fabs(dht.getHumidity() - 65.2) < 0.01);
+  assertTrue(fabs(dht.getTemperature(true) - 23.1) < 0.01);
+}
+
+test(negativeTemperature) {
+  // -10.5 C
+  uint8_t frame[5] = { 0x01, 0x90, 0x80, 0x69, 0 };
+
+  frame[4] = frame[0] + frame[1] + frame[2] + frame[3];
+  replay(trace, buildTrace(frame));
+  assertEquals(Sensor::NO_ERROR, dht.decode(decoder.frame()));
+  assertTrue(fabs(dht.getTemperature(true) + 10.5) < 0.01);
+  assertTrue(fabs(dht.getHumidity() - 40.0) < 0.01);
+}
+
+test(fixedValues) {
+  // 40.0 %RH, -10.5 C and 65.2 %RH, 23.1 C
+  uint8_t negative[5] = { 0x01, 0x90, 0x80, 0x69, 0x7a };
+  uint8_t positive[5] = { 0x02, 0x8c, 0x00, 0xe7, 0x75 };
+
+  assertEquals(Sensor::NO_ERROR, dht.decode(negative));
+  assertEquals(4000, dht.getHumidityFixed());
+  assertEquals(-1050, dht.getTemperatureFixed(true));
+  assertEquals(1310, dht.getTemperatureFixed(false));
+  assertTrue(fabs(dht.getTemperature(false) - 13.1) < 0.01);
+
+  assertEquals(Sensor::NO_ERROR, dht.decode(positive));
+  assertEquals(6520, dht.getHumidityFixed());
+  assertEquals(2310, dht.getTemperatureFixed(true));
+  assertEquals(7358, dht.getTemperatureFixed(false));
+  assertTrue(fabs(dht.getTemperature(false) - 73.58) < 0.01);
+}
+
+test(checksum) {
+  uint8_t frame[5] = { 0x01, 0x90, 0x00, 0xe7, 0x00 };
+
+  replay(trace, buildTrace(frame));
+  assertEquals(DHT_ERROR_NONE, decoder.error());
+  assertEquals(Sensor::CHECKSUM_ERROR, dht.decode(decoder.frame()));
+  // The values of the broken frame are not taken over
+  assertTrue(fabs(dht.getHumidity() - 40.0) > 0.01);
+}
+
+test(brokenTransfers) {
+  // A truncated transfer is not done
+  replay(capturedTrace, 40);
+  assertTrue(!decoder.isDone());
+  assertTrue(decoder.isAcknowledged());
+  assertEquals(18, decoder.bitCount());
+
+  // The edges before the acknowledge are ignored
+  uint8_t noAck[] = { 0x7f, 0xff, 30, 0x80 | 30, 27 };
+  replay(noAck, sizeof(noAck));
+  assertTrue(!decoder.isAcknowledged());
+
+  // The sensor keeps the line high after the acknowledge
+  uint8_t ackTooLong[] = { 30, 0x80 | 80, 127 };
+  replay(ackTooLong, sizeof(ackTooLong));
+  assertEquals(DHT_ERROR_ACK_TOO_LONG, decoder.error());
+
+  uint8_t dataTooLong[] = { 30, 0x80 | 80, 80, 0x80 | 50, 127 };
+  replay(dataTooLong, sizeof(dataTooLong));
+  assertEquals(DHT_ERROR_DATA_TIMEOUT, decoder.error());
+}
+
+test(errorMapping) {
+  assertEquals(Sensor::NO_ERROR, DHT22::sensorError(DHT_ERROR_NONE));
+  assertEquals(Sensor::BUS_ERROR, DHT22::sensorError(DHT_BUS_HUNG));
+  assertEquals(Sensor::SYNC_TIMEOUT, DHT22::sensorError(DHT_ERROR_ACK_TOO_LONG));
+  assertEquals(Sensor::DATA_TIMEOUT, DHT22::sensorError(DHT_ERROR_DATA_TIMEOUT));
+  assertEquals(Sensor::CHECKSUM_ERROR, DHT22::sensorError(DHT_ERROR_CHECKSUM));
+}
+
+#ifndef __AVR__
+#include <HostSim.h>
+
+// Drives the data line from the outside, as the sensor does
+void replayOnPin(const uint8_t *edges, int count) {
+  for(int i = 0; i < count; i++) {
+    SimClock::instance.advance(edges[i] & 0x7f);
+    SimPins::instance.setInput(DHT22_PIN, edges[i] >> 7);
+  }
+}
+
+test(interruptCapture) {
+  SimPins::instance.setInput(DHT22_PIN, HIGH);
+  SimClock::instance.advance(3000000UL);
+
+  assertEquals(Sensor::MEASUREMENT_PENDING, dht.startReading(millis()));
+  assertTrue(dht.isReading());
+  assertEquals(Sensor::MEASUREMENT_PENDING, dht.poll());
+
+  // The edges are captured while the CPU does other things
+  replayOnPin(capturedTrace, 50);
+  assertEquals(Sensor::MEASUREMENT_PENDING, dht.poll());
+  replayOnPin(capturedTrace + 50, sizeof(capturedTrace) - 50);
+  assertEquals(Sensor::NO_ERROR, dht.poll());
+  assertTrue(!dht.isReading());
+  assertTrue(fabs(dht.getHumidity() - 65.2) < 0.01);
+  assertTrue(fabs(dht.getTemperature(true) - 23.1) < 0.01);
+
+  // 2 s between two readings
+  assertEquals(Sensor::TOO_QUICK, dht.startReading(millis()));
+}
+
+test(notPresent) {
+  SimPins::instance.setInput(DHT22_PIN, HIGH);
+  SimClock::instance.advance(3000000UL);
+
+  assertEquals(Sensor::MEASUREMENT_PENDING, dht.startReading(millis()));
+  SimClock::instance.advance(DHT22::TRANSFER_TIMEOUT + 1);
+  assertEquals(Sensor::SENSOR_NOT_PRESENT, dht.poll());
+  assertTrue(!dht.isReading());
+}
+
+test(sensor) {
+  SensorAdapter humidity(&dht, DHT22::Humidity);
+  SensorAdapter temperature(&dht, DHT22::TemperatureC);
+
+  SimPins::instance.setInput(DHT22_PIN, HIGH);
+  SimClock::instance.advance(3000000UL);
+  dht.setAsync(true);
+
+  // One transfer reads both values
+  assertEquals(Sensor::MEASUREMENT_PENDING, humidity.readSensor(millis()));
+  replayOnPin(capturedTrace, sizeof(capturedTrace));
+  assertEquals(Sensor::NO_ERROR, humidity.readSensor(millis()));
+  assertEquals(Sensor::NO_ERROR, temperature.readSensor(millis()));
+  assertTrue(!dht.isReading());
+  assertEquals(6520, humidity.getFixedValue());
+  assertEquals(2310, temperature.getFixedValue());
+  assertEquals(231, temperature.getIntegerValue());
+  assertEquals(65, humidity.getByteValue());
+  assertEquals(7358, dht.getFixedValue(DHT22::TemperatureF));
+
+  // Within 2 s the last values are returned without a transfer
+  SimClock::instance.advance(1000000UL);
+  assertEquals(Sensor::NO_ERROR, temperature.readSensor(millis()));
+  assertTrue(!dht.isReading());
+
+  // A failed transfer keeps the last good values
+  SimClock::instance.advance(1000000UL);
+  assertEquals(Sensor::MEASUREMENT_PENDING, temperature.readSensor(millis()));
+  SimClock::instance.advance(DHT22::TRANSFER_TIMEOUT + 1);
+  assertEquals(Sensor::SENSOR_NOT_PRESENT, temperature.readSensor(millis()));
+  assertEquals(2310, temperature.getFixedValue());
+
+  // Without a good value, reading too early is still an error
+  dht.initialize();
+  assertEquals(Sensor::TOO_QUICK, temperature.readSensor(millis()));
+  dht.setAsync(false);
+}
+#endif
+
+test(polling) {
+  unsigned long start;
+
+  SimPins::instance.attach(POLLED_PIN, &chip);
+  chip.setHumidity(48.5);
+  chip.setTemperature(-3.2);
+  SimClock::instance.advance(3000000UL);
+
+  start = micros();
+  assertEquals(Sensor::NO_ERROR, polled.readSensor(millis()));
+  assertTrue(micros() - start < DHT22::TRANSFER_TIMEOUT + 2000);
+  assertEquals(4850, polled.getFixedValue(DHT22::Humidity));
+  assertEquals(-320, polled.getFixedValue(DHT22::TemperatureC));
+  SimPins::instance.detach(POLLED_PIN);
+}
+
+// Reads within the 2 s of a transfer return its values and are not recorded again
+test(reusedValues) {
+  SensorHistory<4> history(DHT22::Humidity);
+  SensorHealth health;
+
+  SimPins::instance.attach(POLLED_PIN, &chip);
+  chip.setHumidity(55.0);
+  chip.setTemperature(21.5);
+  SimClock::instance.advance(3000000UL);
+  polled.attachHistory(&history);
+  polled.attachHealth(&health);
+
+  assertEquals(Sensor::NO_ERROR, polled.readSensor(millis(), Sensor::ALL_CHANNELS));
+  assertEquals(Sensor::NO_ERROR, polled.readSensor(millis(), Sensor::ALL_CHANNELS));
+  delay(1000);
+  assertEquals(Sensor::NO_ERROR, polled.readSensor(millis(), Sensor::ALL_CHANNELS));
+  assertEquals(5500, polled.getFixedValue(DHT22::Humidity));
+  assertEquals(1, history.count());
+  assertUnsignedLongEquals(1, health.reads());
+
+  delay(1000);
+  assertEquals(Sensor::NO_ERROR, polled.readSensor(millis(), Sensor::ALL_CHANNELS));
+  assertEquals(2, history.count());
+  assertUnsignedLongEquals(2, health.reads());
+
+  polled.detachHistory(&history);
+  polled.attachHealth(0);
+  SimPins::instance.detach(POLLED_PIN);
+}
@@ -0,0 +1,90 @@
+/*
+ * Tests reading several DHT22 on one port at once against simulated sensors, i.e. only runs on the
+ * host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <DHT22.h>
+#include <HostSim.h>
+
+TestSuite suite;
+
+// Pins 4...7 are on port D, pin 8 on port B
+SimDHT22 chips[4];
+DHT22 dht4(4);
+DHT22 dht5(5);
+DHT22 dht6(6);
+DHT22 dht7(7);
+DHT22 dht8(8);
+DHT22Group group;
+
+void setup() {
+  Serial.begin(9600);
+  for(int i = 0; i < 4; i++) {
+    chips[i].setHumidity(40.0 + i * 5);
+    chips[i].setTemperature(-5.5 + i * 10);
+    SimPins::instance.attach(4 + i, &chips[i]);
+  }
+  group.add(&dht4);
+  group.add(&dht5);
+  group.add(&dht6);
+  group.add(&dht7);
+  SimClock::instance.advance(3000000UL);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(add) {
+  DHT22Group other;
+
+  assertEquals(4, group.count());
+  assertTrue(other.add(&dht4));
+  assertTrue(!other.add(&dht8));
+  assertEquals(1, other.count());
+}
+
+test(parallel) {
+  unsigned long transfers = chips[0].transfers();
+  unsigned long start;
+
+  SimClock::instance.advance(2000000UL);
+  start = micros();
+  assertEquals(Sensor::NO_ERROR, group.readSensors());
+  // One transfer for all sensors: the start pulse and about 5 ms
+  assertTrue(micros() - start < 7000);
+  for(int i = 0; i < 4; i++) {
+    assertUnsignedLongEquals(transfers + 1, chips[i].transfers());
+  }
+  assertEquals(4000, dht4.getFixedValue(DHT22::Humidity));
+  assertEquals(-550, dht4.getFixedValue(DHT22::TemperatureC));
+  assertEquals(4500, dht5.getFixedValue(DHT22::Humidity));
+  assertEquals(450, dht5.getFixedValue(DHT22::TemperatureC));
+  assertEquals(5500, dht7.getFixedValue(DHT22::Humidity));
+  assertEquals(2450, dht7.getFixedValue(DHT22::TemperatureC));
+  assertEquals(Sensor::NO_ERROR, dht6.poll());
+
+  // The sensors return the values until the next transfer is due
+  assertEquals(Sensor::NO_ERROR, dht6.readSensor(millis(), DHT22::Humidity));
+  assertEquals(5000, dht6.getFixedValue(DHT22::Humidity));
+  assertEquals(Sensor::NO_ERROR, group.readSensors());
+  assertUnsignedLongEquals(transfers + 1, chips[0].transfers());
+}
+
+test(missingSensor) {
+  SimClock::instance.advance(2000000UL);
+  assertEquals(Sensor::NO_ERROR, group.readSensors());
+  chips[2].setPresent(false);
+  chips[1].setTemperature(30.0);
+  SimClock::instance.advance(2000000UL);
+
+  assertEquals(Sensor::SENSOR_NOT_PRESENT, group.readSensors());
+  assertEquals(Sensor::SENSOR_NOT_PRESENT, dht6.poll());
+  assertEquals(Sensor::NO_ERROR, dht5.poll());
+  assertEquals(3000, dht5.getFixedValue(DHT22::TemperatureC));
+  // The last good values are kept
+  assertEquals(5000, dht6.getFixedValue(DHT22::Humidity));
+  chips[2].setPresent(true);
+  chips[1].setTemperature(4.5);
+}
@@ -278,10 +278,50 @@ bool DS1307RTC::setTimeZone(int8_t tz) {
   return true;
 }
 
+/*
+ * writeTimeZone - the record takes the end of the RAM, behind the user memory (see USER_MEMORY_SIZE)
+ */
+bool DS1307RTC::writeTimeZone(TimeZone &zone) {
+  byte buffer[TimeZone::RECORD_SIZE];
+
+  if(!zone.encode(buffer)) {
+    return false;
+  }
+
+  return writeBytes(buffer, DS1307_MEMORY - TimeZone::RECORD_SIZE, TimeZone::RECORD_SIZE) == TimeZone::RECORD_SIZE;
+}
+
+/*
+ * readTimeZone - falls back to the hours written by setTimeZone if there is no record
+ */
+bool DS1307RTC::readTimeZone(TimeZone &zone) {
+  byte buffer[TimeZone::RECORD_SIZE];
+
+  if(readBytes(buffer, DS1307_MEMORY - TimeZone::RECORD_SIZE, TimeZone::RECORD_SIZE) != TimeZone::RECORD_SIZE) {
+    return false;
+  }
+  if(zone.decode(buffer)) {
+    return true;
+  }
+  if(!readTimeZone()) {
+    return false;
+  }
+  zone.setOffset(_timezone * SECS_PER_HOUR);
+
+  return true;
+}
+
 /*
  * writeUserMemory - the user memory starts at byte 0x09 (0x08 is used for the timezone)
  */
 int DS1307RTC::writeUserMemory(byte *data, int offset, int len) {
+  if((offset < 0) || (offset >= USER_MEMORY_SIZE)) {
+    return 0;
+  }
+  // The time zone record follows the user memory
+  if(len > USER_MEMORY_SIZE - offset) {
+    len = USER_MEMORY_SIZE - offset;
+  }
   return writeBytes(data, offset + DS1307_USERSPACE_START, len);
 }
 
@@ -289,6 +329,12 @@ int DS1307RTC::writeUserMemory(byte *data, int offset, int len) {
  * readUserMemory
  */
 int DS1307RTC::readUserMemory(byte *buffer, int offset, int len) {
+  if((offset < 0) || (offset >= USER_MEMORY_SIZE)) {
+    return 0;
+  }
+  if(len > USER_MEMORY_SIZE - offset) {
+    len = USER_MEMORY_SIZE - offset;
+  }
   return readBytes(buffer, offset + DS1307_USERSPACE_START, len);
 }
 
@@ -8,6 +8,7 @@
 
 #include <WProgram.h>
 #include <Time.h>
+#include <TimeZone.h>
 
 #define RTC DS1307RTC::instance
 
@@ -95,6 +96,29 @@ class DS1307RTC {
 
 	  bool setTimeZone(int8_t tz);
 
+    /**
+     * Stores the zone, including its daylight saving rule, in the last <code>TimeZone::RECORD_SIZE</code>
+     * bytes of the RAM (0x34 ... 0x3f), behind the user memory.
+     *
+     * @return <code>true</code> if the zone was written;<code>false</code> otherwise.
+     */
+    bool writeTimeZone(TimeZone &zone);
+
+    /**
+     * Reads the zone stored by <code>writeTimeZone</code>. Clocks that only hold the hours set by
+     * <code>setTimeZone</code> give a zone without daylight saving.
+     *
+     * @return <code>true</code> if the zone was read;<code>false</code> otherwise.
+     */
+    bool readTimeZone(TimeZone &zone);
+
+    /*
+     * The RAM is split into the time zone hours (0x08), the user memory (0x09 ... 0x33) and the time
+     * zone record of writeTimeZone (0x34 ... 0x3f). Reads and writes of the user memory stop at
+     * USER_MEMORY_SIZE and return the number of bytes transferred.
+     */
+    static const int USER_MEMORY_SIZE = 0x40 - 0x09 - TimeZone::RECORD_SIZE;
+
 	  int writeUserMemory(byte *buffer, int offset, int len);
 
 	  int readUserMemory(byte *buffer, int offset, int len);
@@ -31,14 +31,17 @@
 // Memory related constants
 #define DS1339_MEMORY           0x40
 #define DS1339_USERSPACE_START  0x09
-#define DS1339_CONTROL_REG      0x07
+#define DS1339_CONTROL_REG      0x0e
 #define DS1339_TIME_ZONE_REG    0x08
 
 // Bit masks
 #define DS1339_CLOCKHALT  0x80
-#define DS1339_CTRL_OUT   0x80
-#define DS1339_CTRL_SQWE  0x10
-#define DS1339_CTRL_RS    0x03
+#define DS1339_CTRL_EOSC  0x80
+#define DS1339_CTRL_RS    0x18
+#define DS1339_CTRL_INTCN 0x04
+
+// The rate select bits RS2 and RS1 are bits 4 and 3 of the control register
+#define DS1339_CTRL_RS_SHIFT 3
 
 #define DS1339_BCD_LO     0x0f
 #define DS1339_BCD_HI     0xf0
@@ -265,10 +268,16 @@ byte DS1339::readControlRegister() {
 }
 
 /*
- * startSquareWave
+ * startSquareWave - the square wave is on the SQW/INT pin as long as INTCN is cleared. The
+ * EOSC bit is kept, so a stopped oscillator is not started.
  */
 bool DS1339::startSquareWave(SquareWaveRate rate) {
-  byte ctrlReg = DS1339_CTRL_SQWE | rate;
+  byte ctrlReg;
+
+  if(readBytes(&ctrlReg, DS1339_CONTROL_REG, 1) != 1) {
+    return false;
+  }
+  ctrlReg = (ctrlReg & DS1339_CTRL_EOSC) | (rate << DS1339_CTRL_RS_SHIFT);
 
   if(writeBytes(&ctrlReg, DS1339_CONTROL_REG, 1) != 1) {
     return false;
@@ -280,10 +289,16 @@ bool DS1339::startSquareWave(SquareWaveRate rate) {
 }
 
 /*
- * stopSquarWave
+ * stopSquarWave - setting INTCN turns the SQW/INT pin into the alarm interrupt output. The pin
+ * is open drain, i.e. it is pulled high while no alarm is enabled, whatever <code>out</code> says.
  */
 bool DS1339::stopSquareWave(bool out) {
-  byte ctrlReg = (out) ? 0x80 : 0x00;
+  byte ctrlReg;
+
+  if(readBytes(&ctrlReg, DS1339_CONTROL_REG, 1) != 1) {
+    return false;
+  }
+  ctrlReg = (ctrlReg & DS1339_CTRL_EOSC) | DS1339_CTRL_INTCN;
 
   if(writeBytes(&ctrlReg, DS1339_CONTROL_REG, 1) != 1) {
     return false;
@@ -0,0 +1,30 @@
+/*
+ * HostMain.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ *
+ * Entry point of sketches that run on the host. Does what main() of the Arduino core
+ * does, except that loop() is not called forever. By default it is called once, which is
+ * all the unit test sketches need; define HOSTSIM_LOOPS to run it more often or to 0 to
+ * run it forever.
+ */
+
+#include "HostSim.h"
+
+#ifndef HOSTSIM_LOOPS
+#define HOSTSIM_LOOPS 1
+#endif
+
+int main(int argc, char **argv) {
+  init();
+
+  setup();
+
+  for(unsigned long i = 0; (HOSTSIM_LOOPS == 0) || (i < HOSTSIM_LOOPS); i++) {
+    loop();
+  }
+
+  fflush(stdout);
+  return 0;
+}
@@ -0,0 +1,763 @@
+/*
+ * HostSim.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ *
+ * Simulated clock, pins and EEPROM plus the implementation of the Arduino core
+ * functions on top of them.
+ */
+
+#include "HostSim.h"
+#include <EEPROM.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <string.h>
+#include <math.h>
+
+volatile uint8_t SimPortRegisters[3][3];
+volatile uint8_t SREG = _BV(SREG_I);
+volatile uint8_t ADMUX;
+volatile uint8_t ADCSRA;
+volatile uint8_t ADCSRB;
+volatile uint8_t DIDR0;
+volatile uint16_t SimADCResult;
+
+// Only defined if a library handles the ADC interrupt
+extern "C" void ADC_vect(void) __attribute__((weak));
+
+SimClock SimClock::instance = SimClock();
+SimPins SimPins::instance = SimPins();
+SimEEPROM SimEEPROM::instance = SimEEPROM();
+SimADC SimADC::instance = SimADC();
+
+HardwareSerial Serial;
+EEPROMClass EEPROM;
+
+static uint8_t sleepMode = SLEEP_MODE_IDLE;
+static bool sleepEnabled = false;
+
+// ---- SimClock ------
+
+void SimClock::reset() {
+  _wallCycles = 0;
+  _timerCycles = 0;
+  _sleepMicros = 0;
+  _sleepCount = 0;
+}
+
+void SimClock::charge(unsigned long long cycles) {
+  // The ADC may have been started and the pins may have been changed since time passed the last time
+  SimADC::instance.run(_wallCycles);
+  SimPins::instance.run(wallMicros());
+  _wallCycles += cycles;
+  _timerCycles += cycles;
+  SimADC::instance.run(_wallCycles);
+  SimPins::instance.run(wallMicros());
+}
+
+void SimClock::sleep(uint8_t mode) {
+  unsigned long long cycles = _sleepMicros * SIM_CYCLES_PER_MICROSECOND;
+
+  _sleepCount++;
+  SimADC::instance.run(_wallCycles);
+  SimPins::instance.run(wallMicros());
+  _wallCycles += cycles;
+  SimPins::instance.run(wallMicros());
+
+  // Timer 0 is clocked from the I/O clock, which is stopped in power-down
+  // and power-save mode.
+  if((mode != SLEEP_MODE_PWR_DOWN) && (mode != SLEEP_MODE_PWR_SAVE)) {
+    _timerCycles += cycles;
+    SimADC::instance.run(_wallCycles);
+  }
+}
+
+// ---- SimPins ------
+
+void SimPins::reset() {
+  for(int i = 0; i < NUM_ANALOG_INPUTS; i++) {
+    _analogValues[i] = 0;
+    _analogSources[i] = 0;
+  }
+  for(int i = 0; i < 3; i++) {
+    _external[i] = 0;
+    for(int j = 0; j < 3; j++) {
+      SimPortRegisters[i][j] = 0;
+    }
+  }
+  for(int i = 0; i < MAX_INTERRUPTS; i++) {
+    _handlers[i] = 0;
+  }
+  for(int i = 0; i < NUM_DIGITAL_PINS; i++) {
+    _devices[i] = 0;
+  }
+  _deviceCount = 0;
+}
+
+void SimPins::setAnalogValue(uint8_t channel, int value) {
+  if(channel < NUM_ANALOG_INPUTS) {
+    _analogValues[channel] = value & 0x3ff;
+    _analogSources[channel] = 0;
+  }
+}
+
+void SimPins::setAnalogSource(uint8_t channel, AnalogSource source) {
+  if(channel < NUM_ANALOG_INPUTS) {
+    _analogSources[channel] = source;
+  }
+}
+
+int SimPins::analogValue(uint8_t channel, unsigned long long wallMicros) {
+  if(channel >= NUM_ANALOG_INPUTS) {
+    return 0;
+  }
+
+  if(_analogSources[channel]) {
+    return _analogSources[channel](channel, wallMicros) & 0x3ff;
+  }
+
+  return _analogValues[channel];
+}
+
+void SimPins::setInput(uint8_t pin, uint8_t level) {
+  uint8_t port, mask, before;
+
+  if(pin >= NUM_DIGITAL_PINS) {
+    return;
+  }
+
+  port = digitalPinToPort(pin) - PB;
+  mask = digitalPinToBitMask(pin);
+  before = this->level(pin);
+
+  if(level) {
+    _external[port] |= mask;
+  }
+  else {
+    _external[port] &= ~mask;
+  }
+  update();
+
+  // External interrupts INT0 and INT1 are on pin 2 and 3
+  if(((pin == 2) || (pin == 3)) && (SREG & _BV(SREG_I))) {
+    int irq = pin - 2;
+    uint8_t after = this->level(pin);
+
+    if(_handlers[irq] && (before != after)) {
+      if((_modes[irq] == CHANGE) ||
+         ((_modes[irq] == RISING) && after) ||
+         ((_modes[irq] == FALLING) && !after)) {
+        _handlers[irq]();
+      }
+    }
+  }
+}
+
+uint8_t SimPins::level(uint8_t pin) {
+  if(pin >= NUM_DIGITAL_PINS) {
+    return LOW;
+  }
+  return (*portInputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+uint8_t SimPins::mode(uint8_t pin) {
+  if(pin >= NUM_DIGITAL_PINS) {
+    return INPUT;
+  }
+  return (*portModeRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin)) ? OUTPUT : INPUT;
+}
+
+void SimPins::attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode) {
+  if(interrupt < MAX_INTERRUPTS) {
+    _handlers[interrupt] = handler;
+    _modes[interrupt] = mode;
+  }
+}
+
+void SimPins::detachInterrupt(uint8_t interrupt) {
+  if(interrupt < MAX_INTERRUPTS) {
+    _handlers[interrupt] = 0;
+  }
+}
+
+void SimPins::attach(uint8_t pin, SimPinDevice *device) {
+  if(pin < NUM_DIGITAL_PINS) {
+    detach(pin);
+    _devices[pin] = device;
+    _deviceCount++;
+    setInput(pin, device->level(pin, SimClock::instance.wallMicros()));
+  }
+}
+
+void SimPins::detach(uint8_t pin) {
+  if((pin < NUM_DIGITAL_PINS) && _devices[pin]) {
+    _devices[pin] = 0;
+    _deviceCount--;
+  }
+}
+
+void SimPins::run(unsigned long long wallMicros) {
+  uint8_t level;
+
+  if(_deviceCount == 0) {
+    return;
+  }
+
+  for(uint8_t pin = 0; pin < NUM_DIGITAL_PINS; pin++) {
+    if(_devices[pin]) {
+      level = _devices[pin]->level(pin, wallMicros) ? HIGH : LOW;
+      if(level != ((_external[digitalPinToPort(pin) - PB] & digitalPinToBitMask(pin)) ? HIGH : LOW)) {
+        setInput(pin, level);
+      }
+    }
+  }
+}
+
+void SimPins::update() {
+  for(int i = 0; i < 3; i++) {
+    uint8_t ddr = SimPortRegisters[i][1];
+    SimPortRegisters[i][0] = (SimPortRegisters[i][2] & ddr) | (_external[i] & ~ddr);
+  }
+}
+
+// ---- SimDHT22 ------
+
+SimDHT22::SimDHT22() {
+  _humidity = 0;
+  _temperature = 0;
+  _present = true;
+  _pulled = false;
+  _sending = false;
+  _pullStart = 0;
+  _start = 0;
+  _transfers = 0;
+}
+
+void SimDHT22::setHumidity(float relativeHumidity) {
+  _humidity = (int)floor(relativeHumidity * 10 + 0.5);
+}
+
+void SimDHT22::setTemperature(float celsius) {
+  _temperature = (int)floor(celsius * 10 + 0.5);
+}
+
+uint8_t SimDHT22::level(uint8_t pin, unsigned long long wallMicros) {
+  unsigned long long t;
+  unsigned int temperature;
+
+  // Drivers often write the registers directly, so the output register is checked, not the level
+  if((SimPins::instance.mode(pin) == OUTPUT) && !(*portOutputRegister(digitalPinToPort(pin)) & digitalPinToBitMask(pin))) {
+    // The MCU pulls the line low, a running transfer is abandoned
+    if(!_pulled) {
+      _pulled = true;
+      _pullStart = wallMicros;
+    }
+    _sending = false;
+    return HIGH;
+  }
+
+  if(_pulled) {
+    _pulled = false;
+    if(_present && (wallMicros - _pullStart >= 1000)) {
+      // Negative temperatures are sent as sign and magnitude
+      temperature = _temperature < 0 ? (0x8000 | -_temperature) : _temperature;
+      _frame[0] = _humidity >> 8;
+      _frame[1] = _humidity & 0xff;
+      _frame[2] = temperature >> 8;
+      _frame[3] = temperature & 0xff;
+      _frame[4] = _frame[0] + _frame[1] + _frame[2] + _frame[3];
+      _sending = true;
+      _start = wallMicros;
+      _transfers++;
+    }
+  }
+
+  if(!_sending) {
+    return HIGH;
+  }
+
+  t = wallMicros - _start;
+  if(t < 30) {
+    return HIGH;
+  }
+  t -= 30;
+  if(t < 80) {
+    return LOW;
+  }
+  t -= 80;
+  if(t < 80) {
+    return HIGH;
+  }
+  t -= 80;
+  for(uint8_t bit = 0; bit < 40; bit++) {
+    unsigned long long high = (_frame[bit / 8] & (0x80 >> (bit % 8))) ? 70 : 27;
+
+    if(t < 50) {
+      return LOW;
+    }
+    t -= 50;
+    if(t < high) {
+      return HIGH;
+    }
+    t -= high;
+  }
+  if(t < 50) {
+    return LOW;
+  }
+
+  _sending = false;
+
+  return HIGH;
+}
+
+// ---- SimADC ------
+
+void SimADC::reset() {
+  _running = false;
+  _next = 0;
+  _conversions = 0;
+  ADMUX = ADCSRA = ADCSRB = DIDR0 = 0;
+  SimADCResult = 0;
+}
+
+void SimADC::run(unsigned long long wallCycles) {
+  const uint8_t freeRunning = _BV(ADEN) | _BV(ADATE) | _BV(ADSC);
+  unsigned long long period;
+
+  if(((ADCSRA & freeRunning) != freeRunning) || (ADCSRB & 0x07)) {
+    _running = false;
+    return;
+  }
+
+  // 13 ADC clock cycles per conversion, the ADC clock is the CPU clock divided by the prescaler
+  period = 13ULL * ((ADCSRA & 0x07) ? 1 << (ADCSRA & 0x07) : 2);
+  if(!_running) {
+    _running = true;
+    _next = wallCycles + period;
+    return;
+  }
+
+  while(_next <= wallCycles) {
+    SimADCResult = SimPins::instance.analogValue(ADMUX & 0x0f, _next / SIM_CYCLES_PER_MICROSECOND);
+    _next += period;
+    _conversions++;
+    ADCSRA |= _BV(ADIF);
+    if((ADCSRA & _BV(ADIE)) && (SREG & _BV(SREG_I)) && ADC_vect) {
+      ADCSRA &= ~_BV(ADIF);
+      ADC_vect();
+    }
+  }
+}
+
+// ---- SimEEPROM ------
+
+SimEEPROM::SimEEPROM() {
+  _file = 0;
+  _reads = _writes = 0;
+  erase();
+}
+
+bool SimEEPROM::open(const char *fileName) {
+  close();
+
+  _file = fopen(fileName, "r+b");
+  if(_file) {
+    if(fread(_memory, 1, SIZE, _file) != (size_t)SIZE) {
+      // A short file is treated as erased beyond its end
+      fseek(_file, 0, SEEK_END);
+      for(long i = ftell(_file); i < SIZE; i++) {
+        _memory[i] = 0xff;
+      }
+    }
+  }
+  else {
+    _file = fopen(fileName, "w+b");
+    erase();
+  }
+
+  if(_file) {
+    fseek(_file, 0, SEEK_SET);
+    fwrite(_memory, 1, SIZE, _file);
+    fflush(_file);
+    return true;
+  }
+
+  return false;
+}
+
+void SimEEPROM::close() {
+  if(_file) {
+    fclose(_file);
+    _file = 0;
+  }
+}
+
+void SimEEPROM::erase() {
+  memset(_memory, 0xff, SIZE);
+}
+
+uint8_t SimEEPROM::read(int addr) {
+  _reads++;
+  SimClock::instance.charge(READ_CYCLES);
+
+  // The address register only has as many bits as needed for the size
+  return _memory[addr & (SIZE - 1)];
+}
+
+void SimEEPROM::write(int addr, uint8_t value) {
+  addr &= SIZE - 1;
+
+  _writes++;
+  _memory[addr] = value;
+  SimClock::instance.advance(WRITE_MICROS);
+
+  if(_file) {
+    fseek(_file, addr, SEEK_SET);
+    fputc(value, _file);
+    fflush(_file);
+  }
+}
+
+uint8_t EEPROMClass::read(int addr) {
+  return SimEEPROM::instance.read(addr);
+}
+
+void EEPROMClass::write(int addr, uint8_t value) {
+  SimEEPROM::instance.write(addr, value);
+}
+
+// ---- Arduino core ------
+
+void init(void) {
+  SREG |= _BV(SREG_I);
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+  if(pin < NUM_DIGITAL_PINS) {
+    if(mode == OUTPUT) {
+      *portModeRegister(digitalPinToPort(pin)) |= digitalPinToBitMask(pin);
+    }
+    else {
+      *portModeRegister(digitalPinToPort(pin)) &= ~digitalPinToBitMask(pin);
+    }
+    SimPins::instance.update();
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if(pin < NUM_DIGITAL_PINS) {
+    if(value) {
+      *portOutputRegister(digitalPinToPort(pin)) |= digitalPinToBitMask(pin);
+    }
+    else {
+      *portOutputRegister(digitalPinToPort(pin)) &= ~digitalPinToBitMask(pin);
+    }
+    SimPins::instance.update();
+  }
+}
+
+int digitalRead(uint8_t pin) {
+  return SimPins::instance.level(pin);
+}
+
+int analogRead(uint8_t pin) {
+  // Pins A0...A5 are mapped to channels 0...5
+  if(pin >= 14) {
+    pin -= 14;
+  }
+
+  SimClock::instance.advance(SimPins::ANALOG_READ_MICROS);
+  return SimPins::instance.analogValue(pin);
+}
+
+void analogReference(uint8_t mode) {
+}
+
+void analogWrite(uint8_t pin, int value) {
+  pinMode(pin, OUTPUT);
+  digitalWrite(pin, value >= 128 ? HIGH : LOW);
+}
+
+// unsigned long has 64 bits on most hosts, so the counters must not wrap at 32 bits,
+// otherwise the usual (millis() - start) arithmetic breaks after 49.7 days
+unsigned long millis(void) {
+  return SimClock::instance.timerMicros() / 1000ULL;
+}
+
+unsigned long micros(void) {
+  return SimClock::instance.timerMicros();
+}
+
+void delay(unsigned long ms) {
+  SimClock::instance.advance(ms * 1000ULL);
+}
+
+void delayMicroseconds(unsigned int us) {
+  SimClock::instance.advance(us);
+}
+
+unsigned long pulseIn(uint8_t pin, uint8_t state, unsigned long timeout) {
+  // Nothing drives the pins while the CPU is waiting, so there never is a pulse
+  SimClock::instance.advance(timeout);
+  return 0;
+}
+
+void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode) {
+  SimPins::instance.attachInterrupt(interrupt, handler, mode);
+}
+
+void detachInterrupt(uint8_t interrupt) {
+  SimPins::instance.detachInterrupt(interrupt);
+}
+
+void set_sleep_mode(uint8_t mode) {
+  sleepMode = mode;
+}
+
+void sleep_enable(void) {
+  sleepEnabled = true;
+}
+
+void sleep_disable(void) {
+  sleepEnabled = false;
+}
+
+void sleep_cpu(void) {
+  if(sleepEnabled) {
+    SimClock::instance.sleep(sleepMode);
+  }
+}
+
+void sleep_mode(void) {
+  sleep_enable();
+  sleep_cpu();
+  sleep_disable();
+}
+
+uint16_t makeWord(uint16_t w) {
+  return w;
+}
+
+uint16_t makeWord(byte h, byte l) {
+  return (h << 8) | l;
+}
+
+long random(long howbig) {
+  if(howbig == 0) {
+    return 0;
+  }
+  return ::random() % howbig;
+}
+
+long random(long howsmall, long howbig) {
+  if(howsmall >= howbig) {
+    return howsmall;
+  }
+  return random(howbig - howsmall) + howsmall;
+}
+
+void randomSeed(unsigned int seed) {
+  if(seed != 0) {
+    srandom(seed);
+  }
+}
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+char *ultoa(unsigned long value, char *string, int radix) {
+  char buffer[8 * sizeof(long) + 1];
+  int i = 0;
+
+  do {
+    int digit = value % radix;
+    buffer[i++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+    value /= radix;
+  } while(value);
+
+  for(int j = 0; j < i; j++) {
+    string[j] = buffer[i - j - 1];
+  }
+  string[i] = 0;
+
+  return string;
+}
+
+char *ltoa(long value, char *string, int radix) {
+  if((value < 0) && (radix == 10)) {
+    string[0] = '-';
+    ultoa(-(unsigned long)value, string + 1, radix);
+    return string;
+  }
+
+  return ultoa((unsigned long)value, string, radix);
+}
+
+char *utoa(unsigned int value, char *string, int radix) {
+  return ultoa(value, string, radix);
+}
+
+char *itoa(int value, char *string, int radix) {
+  if(radix != 10) {
+    // avr-libc prints the 16 bit two's complement for other radices
+    return ultoa((unsigned int)value, string, radix);
+  }
+  return ltoa(value, string, radix);
+}
+
+// ---- HardwareSerial ------
+
+void HardwareSerial::write(uint8_t c) {
+  putchar(c);
+  charge(1);
+}
+
+void HardwareSerial::write(const char *str) {
+  fputs(str, stdout);
+  charge(strlen(str));
+}
+
+void HardwareSerial::write(const uint8_t *buffer, size_t size) {
+  fwrite(buffer, 1, size, stdout);
+  charge(size);
+}
+
+void HardwareSerial::charge(size_t bytes) {
+  // Start bit, 8 data bits and stop bit
+  if(_speed > 0) {
+    SimClock::instance.charge(bytes * 10ULL * F_CPU / _speed);
+  }
+}
+
+void HardwareSerial::print(const char str[]) {
+  write(str);
+}
+
+void HardwareSerial::print(char c, int base) {
+  print((long)c, base);
+}
+
+void HardwareSerial::print(unsigned char b, int base) {
+  print((unsigned long)b, base);
+}
+
+void HardwareSerial::print(int n, int base) {
+  print((long)n, base);
+}
+
+void HardwareSerial::print(unsigned int n, int base) {
+  print((unsigned long)n, base);
+}
+
+void HardwareSerial::print(long n, int base) {
+  if(base == 0) {
+    write((uint8_t)n);
+  }
+  else if((base == 10) && (n < 0)) {
+    write('-');
+    printNumber(-(unsigned long)n, 10);
+  }
+  else {
+    printNumber((unsigned long)n, base);
+  }
+}
+
+void HardwareSerial::print(unsigned long n, int base) {
+  if(base == 0) {
+    write((uint8_t)n);
+  }
+  else {
+    printNumber(n, base);
+  }
+}
+
+void HardwareSerial::print(double n, int digits) {
+  printFloat(n, digits);
+}
+
+void HardwareSerial::println(void) {
+  write('\r');
+  write('\n');
+}
+
+void HardwareSerial::println(const char c[]) {
+  print(c);
+  println();
+}
+
+void HardwareSerial::println(char c, int base) {
+  print(c, base);
+  println();
+}
+
+void HardwareSerial::println(unsigned char b, int base) {
+  print(b, base);
+  println();
+}
+
+void HardwareSerial::println(int n, int base) {
+  print(n, base);
+  println();
+}
+
+void HardwareSerial::println(unsigned int n, int base) {
+  print(n, base);
+  println();
+}
+
+void HardwareSerial::println(long n, int base) {
+  print(n, base);
+  println();
+}
+
+void HardwareSerial::println(unsigned long n, int base) {
+  print(n, base);
+  println();
+}
+
+void HardwareSerial::println(double n, int digits) {
+  print(n, digits);
+  println();
+}
+
+void HardwareSerial::printNumber(unsigned long n, uint8_t base) {
+  char buffer[8 * sizeof(long) + 1];
+
+  write(ultoa(n, buffer, base));
+}
+
+void HardwareSerial::printFloat(double number, uint8_t digits) {
+  double rounding = 0.5;
+  unsigned long intPart;
+  double remainder;
+
+  if(number < 0.0) {
+    write('-');
+    number = -number;
+  }
+
+  for(uint8_t i = 0; i < digits; ++i) {
+    rounding /= 10.0;
+  }
+  number += rounding;
+
+  intPart = (unsigned long)number;
+  remainder = number - (double)intPart;
+  printNumber(intPart, 10);
+
+  if(digits > 0) {
+    write('.');
+  }
+
+  while(digits-- > 0) {
+    int digit;
+
+    remainder *= 10.0;
+    digit = (int)remainder;
+    printNumber(digit, 10);
+    remainder -= digit;
+  }
+}
@@ -0,0 +1,296 @@
+/*
+ * HostSim.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ *
+ * Host-side simulation of the hardware the libraries depend on. Together with the
+ * stand-in headers in <code>HostSim/include</code> (WProgram.h, Wire.h, EEPROM.h, ...)
+ * it allows to compile the libraries, their unit tests and sketches with the
+ * native compiler and to run them on the development machine.
+ * <p>
+ * Nothing in the simulation happens in the background. Time only passes if the
+ * code under test waits (<code>delay</code>, <code>delayMicroseconds</code>, sleep
+ * modes), uses a peripheral that costs time (ADC conversions, EEPROM writes, I2C
+ * transfers) or if the test advances the clock explicitly. A year of wall time
+ * is therefore simulated in fractions of a second.
+ */
+
+#ifndef HOSTSIM_H_
+#define HOSTSIM_H_
+
+#include <WProgram.h>
+#include <pins_arduino.h>
+#include <stdio.h>
+
+#define SIM_CYCLES_PER_MICROSECOND (F_CPU / 1000000L)
+
+/**
+ * The simulated time base of the MCU. The clock keeps two times:
+ * <ul>
+ *  <li><b>wall time</b> - the real time that passed since the start of the simulation.
+ *      Simulated devices, e.g. an RTC, use the wall time.
+ *  <li><b>timer time</b> - the time seen by timer 0 of the MCU, i.e. <code>millis()</code> and
+ *      <code>micros()</code>. It runs with the wall time, except in the power-down and power-save
+ *      sleep modes, which stop the timer.
+ * </ul>
+ * Both are kept in CPU cycles, so code can be charged with the cycles an operation takes
+ * on the target.
+ */
+class SimClock {
+  public:
+    static SimClock instance;
+
+    /**
+     * Resets wall time, timer time and the cycle counter to zero.
+     */
+    void reset();
+
+    unsigned long long wallMicros() { return _wallCycles / SIM_CYCLES_PER_MICROSECOND; };
+    unsigned long long wallCycles() { return _wallCycles; };
+    unsigned long long timerMicros() { return _timerCycles / SIM_CYCLES_PER_MICROSECOND; };
+
+    /**
+     * @return the number of CPU cycles executed since the start of the simulation. Cycles are
+     *         only counted if the CPU is not sleeping.
+     */
+    unsigned long long cycles() { return _timerCycles; };
+
+    /**
+     * Lets <code>us</code> microseconds pass with the CPU running.
+     */
+    void advance(unsigned long long us) { charge(us * SIM_CYCLES_PER_MICROSECOND); };
+
+    /**
+     * Charges <code>cycles</code> CPU cycles, i.e. lets the time pass that the CPU needs
+     * to execute them. Used by the simulated peripherals to model their cost.
+     */
+    void charge(unsigned long long cycles);
+
+    /**
+     * Sets how long the next sleep (<code>sleep_mode()</code>) lasts before the MCU wakes up
+     * again. The default is zero, i.e. the MCU wakes up immediately.
+     */
+    void sleepFor(unsigned long long us) { _sleepMicros = us; };
+
+    /**
+     * Called by <code>sleep_cpu()</code>. Lets the time scheduled with <code>sleepFor</code>
+     * pass on the wall clock and, if <code>mode</code> keeps timer 0 running, on the timer.
+     */
+    void sleep(uint8_t mode);
+
+    /**
+     * @return the number of times the simulated MCU went to sleep.
+     */
+    unsigned long sleepCount() { return _sleepCount; };
+
+  private:
+    unsigned long long _wallCycles;
+    unsigned long long _timerCycles;
+    unsigned long long _sleepMicros;
+    unsigned long _sleepCount;
+};
+
+/**
+ * A device that drives a digital pin depending on the time, e.g. a sensor with a single wire protocol.
+ * Whenever time passes, the attached devices are asked for the level of their pins.
+ */
+class SimPinDevice {
+  public:
+    /**
+     * @return the level the device drives the pin to at the given wall time. The MCU may drive the pin
+     *         itself, see <code>SimPins::mode</code>.
+     */
+    virtual uint8_t level(uint8_t pin, unsigned long long wallMicros) = 0;
+};
+
+/**
+ * The simulated I/O pins of the MCU. Pins that are configured as input read the level
+ * set with <code>setInput</code>; pins that are configured as output read what the MCU
+ * writes. Analog channels either return a fixed value or the value of a source function
+ * that is evaluated at the time of the conversion.
+ */
+class SimPins {
+  public:
+    /**
+     * Function that produces the ADC value (0...1023) of an analog channel for the given
+     * wall time.
+     */
+    typedef int (*AnalogSource)(uint8_t channel, unsigned long long wallMicros);
+
+    static SimPins instance;
+    static const unsigned long ANALOG_READ_MICROS = 112;
+
+    void reset();
+
+    void setAnalogValue(uint8_t channel, int value);
+    void setAnalogSource(uint8_t channel, AnalogSource source);
+
+    /**
+     * Performs a conversion of the given channel, which does not cost any time. Used by
+     * <code>analogRead</code>, which charges the conversion time.
+     */
+    int analogValue(uint8_t channel) { return analogValue(channel, SimClock::instance.wallMicros()); };
+    int analogValue(uint8_t channel, unsigned long long wallMicros);
+
+    /**
+     * Drives the given pin from the outside. If an interrupt is attached to the pin and the
+     * level change matches its mode, the interrupt handler is called.
+     */
+    void setInput(uint8_t pin, uint8_t level);
+
+    /**
+     * @return the level the pin currently has, regardless of its direction.
+     */
+    uint8_t level(uint8_t pin);
+
+    /**
+     * @return <code>OUTPUT</code> if the MCU configured the pin as output; <code>INPUT</code> otherwise.
+     */
+    uint8_t mode(uint8_t pin);
+
+    void attachInterrupt(uint8_t interrupt, void (*handler)(void), int mode);
+    void detachInterrupt(uint8_t interrupt);
+
+    /**
+     * Connects a device to the given pin, which from now on drives the pin like <code>setInput</code>.
+     */
+    void attach(uint8_t pin, SimPinDevice *device);
+    void detach(uint8_t pin);
+
+    /**
+     * Lets the attached devices drive their pins for the given wall time. Called by <code>SimClock</code>
+     * whenever time passes.
+     */
+    void run(unsigned long long wallMicros);
+
+    /**
+     * Recalculates the input registers after the direction or output registers have been
+     * changed, e.g. through <code>pinMode</code> or <code>digitalWrite</code>.
+     */
+    void update();
+
+  private:
+    enum { MAX_INTERRUPTS = 2 };
+
+    int _analogValues[NUM_ANALOG_INPUTS];
+    AnalogSource _analogSources[NUM_ANALOG_INPUTS];
+    uint8_t _external[3];
+    void (*_handlers[MAX_INTERRUPTS])(void);
+    int _modes[MAX_INTERRUPTS];
+    SimPinDevice *_devices[NUM_DIGITAL_PINS];
+    uint8_t _deviceCount;
+};
+
+/**
+ * DHT22 humidity and temperature sensor on a digital pin. The sensor answers after the MCU pulled the
+ * line low for at least 1 ms and released it: 30 us later it acknowledges with 80 us low and 80 us high,
+ * then sends 40 bits, each 50 us low and 27 us (0) or 70 us (1) high, and a final 50 us low. Otherwise
+ * the line is high (pull up).
+ */
+class SimDHT22: public SimPinDevice {
+  public:
+    SimDHT22();
+
+    void setHumidity(float relativeHumidity);
+    void setTemperature(float celsius);
+
+    /**
+     * A sensor that is not present never answers.
+     */
+    void setPresent(bool present) { _present = present; };
+
+    /**
+     * @return the number of transfers the sensor started.
+     */
+    unsigned long transfers() { return _transfers; };
+
+    uint8_t level(uint8_t pin, unsigned long long wallMicros);
+
+  private:
+    int _humidity;        // in tenths
+    int _temperature;     // in tenths
+    bool _present;
+    bool _pulled;
+    bool _sending;
+    unsigned long long _pullStart;
+    unsigned long long _start;
+    uint8_t _frame[5];
+    unsigned long _transfers;
+};
+
+/**
+ * The ADC of the MCU in free running mode. <code>analogRead</code> does its single conversions itself.
+ * Once a sketch starts the free running mode (<code>ADEN</code>, <code>ADATE</code> and <code>ADSC</code>
+ * set in <code>ADCSRA</code>, trigger source 0 in <code>ADCSRB</code>), the ADC converts the channel selected
+ * in <code>ADMUX</code> every 13 ADC clock cycles while time passes and calls the <code>ADC_vect</code>
+ * handler if <code>ADIE</code> is set and interrupts are enabled. The value of a conversion is taken at the
+ * time the conversion completes.
+ */
+class SimADC {
+  public:
+    static SimADC instance;
+
+    void reset();
+
+    /**
+     * Performs the conversions that completed up to the given wall time. Called by <code>SimClock</code>
+     * whenever time passes.
+     */
+    void run(unsigned long long wallCycles);
+
+    /**
+     * @return the number of conversions in free running mode.
+     */
+    unsigned long conversions() { return _conversions; };
+
+  private:
+    bool _running;
+    unsigned long long _next;
+    unsigned long _conversions;
+};
+
+/**
+ * The simulated EEPROM of an ATmega328. The content can be backed by a file, in which
+ * case every write goes through to the file, so the EEPROM survives the simulation run
+ * just like it survives a power cycle of the board. Each write costs the 3.3 ms the real
+ * EEPROM needs for the erase/write cycle.
+ */
+class SimEEPROM {
+  public:
+    static SimEEPROM instance;
+    static const int SIZE = 1024;
+    static const unsigned long WRITE_MICROS = 3300;
+    static const unsigned long READ_CYCLES = 8;
+
+    SimEEPROM();
+
+    /**
+     * Backs the EEPROM with the given file. If the file exists its content is loaded; otherwise
+     * the EEPROM is erased and the file is created.
+     *
+     * @return <code>true</code> if the file could be opened or created;<code>false</code> otherwise.
+     */
+    bool open(const char *fileName);
+    void close();
+
+    /**
+     * Sets all bytes to <code>0xff</code>, the value of an erased EEPROM cell.
+     */
+    void erase();
+
+    uint8_t read(int addr);
+    void write(int addr, uint8_t value);
+
+    unsigned long reads() { return _reads; };
+    unsigned long writes() { return _writes; };
+    void resetCounters() { _reads = _writes = 0; };
+
+  private:
+    uint8_t _memory[SIZE];
+    FILE *_file;
+    unsigned long _reads;
+    unsigned long _writes;
+};
+
+#endif /* HOSTSIM_H_ */
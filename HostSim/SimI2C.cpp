@@ -0,0 +1,571 @@
+/*
+ * SimI2C.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "SimI2C.h"
+#include <Wire.h>
+
+#define SHT21_ADDRESS 0x40
+#define RTC_ADDRESS   0x68
+
+#define SHT21_DEFAULT_USER_REGISTER 0x02
+
+#define DS1307_CLOCKHALT 0x80
+#define DS1307_CONTROL_REG 0x07
+#define DS1307_CTRL_OUT 0x80
+#define DS1307_CTRL_SQWE 0x10
+#define DS1307_CTRL_RS 0x03
+#define DS1339_CONTROL_REG 0x0e
+#define DS1339_EOSC 0x80
+#define DS1339_CTRL_RS 0x18
+#define DS1339_CTRL_INTCN 0x04
+
+SimI2CBus SimI2CBus::instance = SimI2CBus();
+
+TwoWire Wire = TwoWire();
+
+// The simulation keeps its own calendar conversion, so it does not depend on
+// the Time library it is used to test.
+static long daysFromCivil(int y, int m, int d) {
+  y -= m <= 2;
+  long era = y / 400;
+  long yoe = y - era * 400;
+  long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+  long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + doe - 719468;
+}
+
+static void civilFromDays(long z, int &y, int &m, int &d) {
+  z += 719468;
+  long era = z / 146097;
+  long doe = z - era * 146097;
+  long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  long mp = (5 * doy + 2) / 153;
+  d = doy - (153 * mp + 2) / 5 + 1;
+  m = mp < 10 ? mp + 3 : mp - 9;
+  y = yoe + era * 400 + (m <= 2);
+}
+
+static uint8_t dec2bcd(uint8_t num) {
+  return ((num / 10) << 4) | (num % 10);
+}
+
+static uint8_t bcd2dec(uint8_t num) {
+  return (num >> 4) * 10 + (num & 0x0f);
+}
+
+// ---- SimI2CDevice ------
+
+SimI2CDevice::SimI2CDevice(uint8_t address) {
+  _address = address;
+  _present = true;
+}
+
+// ---- SimI2CBus ------
+
+bool SimI2CBus::attach(SimI2CDevice *device) {
+  for(int i = 0; i < MAX_DEVICES; i++) {
+    if(!_devices[i] || (_devices[i] == device)) {
+      _devices[i] = device;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void SimI2CBus::detach(SimI2CDevice *device) {
+  for(int i = 0; i < MAX_DEVICES; i++) {
+    if(_devices[i] == device) {
+      _devices[i] = 0;
+    }
+  }
+}
+
+void SimI2CBus::detachAll() {
+  for(int i = 0; i < MAX_DEVICES; i++) {
+    _devices[i] = 0;
+  }
+}
+
+SimI2CDevice *SimI2CBus::find(uint8_t address) {
+  for(int i = 0; i < MAX_DEVICES; i++) {
+    if(_devices[i] && (_devices[i]->address() == address) && _devices[i]->isPresent()) {
+      return _devices[i];
+    }
+  }
+
+  return 0;
+}
+
+uint8_t SimI2CBus::write(uint8_t address, const uint8_t *data, uint8_t len) {
+  SimI2CDevice *device = find(address);
+
+  _transactions++;
+  _bytes++;
+  SimClock::instance.advance(BYTE_MICROS);
+
+  if(!device) {
+    return 2;
+  }
+
+  _bytes += len;
+  SimClock::instance.advance(BYTE_MICROS * len);
+
+  return device->receive(data, len) ? 0 : 3;
+}
+
+uint8_t SimI2CBus::read(uint8_t address, uint8_t *buffer, uint8_t len) {
+  SimI2CDevice *device = find(address);
+  uint8_t received;
+
+  _transactions++;
+  _bytes++;
+  SimClock::instance.advance(BYTE_MICROS);
+
+  if(!device) {
+    return 0;
+  }
+
+  received = device->transmit(buffer, len);
+  _bytes += received;
+  SimClock::instance.advance(BYTE_MICROS * received);
+
+  return received;
+}
+
+// ---- TwoWire ------
+
+TwoWire::TwoWire() {
+  _rxBufferIndex = _rxBufferLength = 0;
+  _txBufferLength = 0;
+  _transmitting = false;
+}
+
+void TwoWire::begin() {
+  _rxBufferIndex = _rxBufferLength = 0;
+  _txBufferLength = 0;
+}
+
+void TwoWire::begin(uint8_t address) {
+  begin();
+}
+
+void TwoWire::begin(int address) {
+  begin();
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity) {
+  if(quantity > BUFFER_LENGTH) {
+    quantity = BUFFER_LENGTH;
+  }
+
+  _rxBufferIndex = 0;
+  _rxBufferLength = SimI2CBus::instance.read(address, _rxBuffer, quantity);
+
+  return _rxBufferLength;
+}
+
+uint8_t TwoWire::requestFrom(int address, int quantity) {
+  return requestFrom((uint8_t)address, (uint8_t)quantity);
+}
+
+void TwoWire::beginTransmission(uint8_t address) {
+  _transmitting = true;
+  _txAddress = address;
+  _txBufferLength = 0;
+}
+
+void TwoWire::beginTransmission(int address) {
+  beginTransmission((uint8_t)address);
+}
+
+uint8_t TwoWire::endTransmission(void) {
+  uint8_t ret;
+
+  if(!_transmitting) {
+    // Like the real library, a second endTransmission sends an empty frame
+    _txBufferLength = 0;
+  }
+
+  ret = SimI2CBus::instance.write(_txAddress, _txBuffer, _txBufferLength);
+  _txBufferLength = 0;
+  _transmitting = false;
+
+  return ret;
+}
+
+void TwoWire::send(uint8_t data) {
+  if(_transmitting && (_txBufferLength < BUFFER_LENGTH)) {
+    _txBuffer[_txBufferLength++] = data;
+  }
+}
+
+void TwoWire::send(uint8_t *data, uint8_t quantity) {
+  for(uint8_t i = 0; i < quantity; i++) {
+    send(data[i]);
+  }
+}
+
+void TwoWire::send(int data) {
+  send((uint8_t)data);
+}
+
+void TwoWire::send(char *data) {
+  send((uint8_t *)data, strlen(data));
+}
+
+uint8_t TwoWire::available(void) {
+  return _rxBufferLength - _rxBufferIndex;
+}
+
+uint8_t TwoWire::receive(void) {
+  if(_rxBufferIndex < _rxBufferLength) {
+    return _rxBuffer[_rxBufferIndex++];
+  }
+
+  return 0;
+}
+
+// ---- SimSHT21 ------
+
+SimSHT21::SimSHT21()
+  : SimI2CDevice(SHT21_ADDRESS) {
+  _temperature = 20.0;
+  _humidity = 50.0;
+  _userRegister = SHT21_DEFAULT_USER_REGISTER;
+  _command = 0;
+  _readyAt = 0;
+  _conversions = 0;
+}
+
+unsigned long SimSHT21::conversionMicros(bool humidity) {
+  // Maximum conversion times of the data sheet, indexed by the resolution bits 7 and 0
+  static const unsigned long temperatureMillis[] = { 85, 22, 43, 11 };
+  static const unsigned long humidityMillis[] = { 29, 4, 9, 15 };
+  uint8_t res = ((_userRegister & 0x80) >> 6) | (_userRegister & 0x01);
+
+  return (humidity ? humidityMillis[res] : temperatureMillis[res]) * 1000UL;
+}
+
+bool SimSHT21::receive(const uint8_t *data, uint8_t len) {
+  if(len == 0) {
+    return true;
+  }
+
+  switch(data[0]) {
+    case 0xe3: // Temperature, hold master
+    case 0xf3: // Temperature, no hold master
+    case 0xe5: // Humidity, hold master
+    case 0xf5: // Humidity, no hold master
+      _command = data[0];
+      _conversions++;
+      _readyAt = SimClock::instance.wallMicros() + conversionMicros((_command & 0x0f) == 0x05);
+      break;
+    case 0xe6:
+      if(len > 1) {
+        // Bits 3..5 are reserved and keep their value
+        _userRegister = (_userRegister & 0x38) | (data[1] & ~0x38);
+      }
+      break;
+    case 0xe7:
+      _command = data[0];
+      break;
+    case 0xfe:
+      _userRegister = SHT21_DEFAULT_USER_REGISTER;
+      _command = 0;
+      SimClock::instance.advance(15000);
+      break;
+    default:
+      return false;
+  }
+
+  return true;
+}
+
+uint8_t SimSHT21::transmit(uint8_t *buffer, uint8_t len) {
+  uint8_t data[3];
+  uint16_t value;
+  unsigned long long now = SimClock::instance.wallMicros();
+
+  if(_command == 0xe7) {
+    if(len > 0) {
+      buffer[0] = _userRegister;
+      return 1;
+    }
+    return 0;
+  }
+
+  if(!_command) {
+    return 0;
+  }
+
+  if(now < _readyAt) {
+    if((_command & 0xf0) == 0xf0) {
+      // No hold master: the sensor does not acknowledge during the conversion
+      return 0;
+    }
+    // Hold master: the sensor stretches the clock until the conversion is done
+    SimClock::instance.advance(_readyAt - now);
+  }
+
+  if((_command & 0x0f) == 0x05) {
+    // RH = -6 + 125 * SRH / 2^16
+    value = (uint16_t)((_humidity + 6.0) * 65536.0 / 125.0);
+    value = (value & ~0x0003) | 0x02;
+  }
+  else {
+    // T = -46.85 + 175.72 * ST / 2^16
+    value = (uint16_t)((_temperature + 46.85) * 65536.0 / 175.72);
+    value &= ~0x0003;
+  }
+
+  data[0] = value >> 8;
+  data[1] = value & 0xff;
+  data[2] = crc(data, 2);
+  _command = 0;
+
+  for(uint8_t i = 0; i < len && i < 3; i++) {
+    buffer[i] = data[i];
+  }
+
+  return len < 3 ? len : 3;
+}
+
+uint8_t SimSHT21::crc(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0;
+
+  // Polynomial x^8 + x^5 + x^4 + 1
+  for(uint8_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for(uint8_t bit = 8; bit > 0; bit--) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x131 : (crc << 1);
+    }
+  }
+
+  return crc;
+}
+
+// ---- SimRTC ------
+
+SimRTC::SimRTC(uint8_t registerCount)
+  : SimI2CDevice(RTC_ADDRESS) {
+  _registerCount = registerCount;
+  _pointer = 0;
+  _time = 0;
+  _timeMicros = 0;
+  _secondMicros = 1000000UL;
+  memset(_registers, 0, sizeof(_registers));
+}
+
+void SimRTC::setTime(time_t t) {
+  _time = t;
+  _timeMicros = SimClock::instance.wallMicros();
+}
+
+time_t SimRTC::getTime() {
+  unsigned long long now = SimClock::instance.wallMicros();
+
+  if(isHalted()) {
+    _timeMicros = now;
+  }
+  else {
+    // Only whole seconds are counted, the phase of the second is kept
+    unsigned long long elapsed = (now - _timeMicros) / _secondMicros;
+    _time += elapsed;
+    _timeMicros += elapsed * _secondMicros;
+  }
+
+  return _time;
+}
+
+void SimRTC::setDrift(long ppm) {
+  // The seconds so far passed with the old rate
+  getTime();
+  _secondMicros = 1000000L - ppm;
+}
+
+uint8_t SimRTC::level(uint8_t pin, unsigned long long wallMicros) {
+  if(isHalted() || !isSquareWave1Hz()) {
+    return outputLevel();
+  }
+  if(wallMicros < _timeMicros) {
+    return HIGH;
+  }
+  return ((wallMicros - _timeMicros) % _secondMicros) < _secondMicros / 2 ? LOW : HIGH;
+}
+
+uint8_t SimRTC::getRegister(uint8_t reg) {
+  if(reg < 7) {
+    render();
+  }
+  return reg < _registerCount ? _registers[reg] : 0;
+}
+
+void SimRTC::setRegister(uint8_t reg, uint8_t value) {
+  if(reg < _registerCount) {
+    getTime();
+    _registers[reg] = value;
+    if(reg < 7) {
+      parse();
+    }
+  }
+}
+
+void SimRTC::render() {
+  time_t t = getTime();
+  long days = t / SECS_PER_DAY;
+  long secs = t % SECS_PER_DAY;
+  int y, m, d;
+
+  civilFromDays(days, y, m, d);
+
+  _registers[0] = (_registers[0] & clockHaltMask()) | dec2bcd(secs % 60);
+  _registers[1] = dec2bcd((secs / 60) % 60);
+  _registers[2] = dec2bcd(secs / 3600);
+  _registers[3] = ((days + 4) % 7) + 1;
+  _registers[4] = dec2bcd(d);
+  _registers[5] = dec2bcd(m);
+  _registers[6] = dec2bcd(y % 100);
+}
+
+void SimRTC::parse() {
+  long days;
+
+  days = daysFromCivil(2000 + bcd2dec(_registers[6]), bcd2dec(_registers[5] & 0x1f), bcd2dec(_registers[4] & 0x3f));
+  _time = days * SECS_PER_DAY +
+          bcd2dec(_registers[2] & 0x3f) * SECS_PER_HOUR +
+          bcd2dec(_registers[1] & 0x7f) * SECS_PER_MIN +
+          bcd2dec(_registers[0] & 0x7f);
+}
+
+bool SimRTC::receive(const uint8_t *data, uint8_t len) {
+  bool timeWritten = false;
+
+  if(len == 0) {
+    return true;
+  }
+
+  _pointer = data[0] % _registerCount;
+
+  if(len > 1) {
+    // Bring the time registers up to date, so a partial write keeps the other fields
+    render();
+
+    for(uint8_t i = 1; i < len; i++) {
+      _registers[_pointer] = data[i];
+      timeWritten |= (_pointer < 7);
+      _pointer = (_pointer + 1) % _registerCount;
+    }
+
+    if(timeWritten) {
+      parse();
+      // Writing the time resets the divider chain, i.e. a new second starts now
+      _timeMicros = SimClock::instance.wallMicros();
+    }
+  }
+
+  return true;
+}
+
+uint8_t SimRTC::transmit(uint8_t *buffer, uint8_t len) {
+  render();
+
+  for(uint8_t i = 0; i < len; i++) {
+    buffer[i] = _registers[_pointer];
+    _pointer = (_pointer + 1) % _registerCount;
+  }
+
+  return len;
+}
+
+// ---- SimDS1307 ------
+
+SimDS1307::SimDS1307()
+  : SimRTC(0x40) {
+}
+
+bool SimDS1307::isHalted() {
+  return _registers[0] & DS1307_CLOCKHALT;
+}
+
+uint8_t SimDS1307::clockHaltMask() {
+  return DS1307_CLOCKHALT;
+}
+
+bool SimDS1307::isSquareWave1Hz() {
+  return (_registers[DS1307_CONTROL_REG] & (DS1307_CTRL_SQWE | DS1307_CTRL_RS)) == DS1307_CTRL_SQWE;
+}
+
+uint8_t SimDS1307::outputLevel() {
+  return (_registers[DS1307_CONTROL_REG] & DS1307_CTRL_OUT) ? HIGH : LOW;
+}
+
+// ---- SimDS1339 ------
+
+SimDS1339::SimDS1339()
+  : SimRTC(0x11) {
+}
+
+bool SimDS1339::isHalted() {
+  return _registers[DS1339_CONTROL_REG] & DS1339_EOSC;
+}
+
+bool SimDS1339::isSquareWave1Hz() {
+  return (_registers[DS1339_CONTROL_REG] & (DS1339_CTRL_INTCN | DS1339_CTRL_RS)) == 0;
+}
+
+// ---- SimI2CEEPROM ------
+
+SimI2CEEPROM::SimI2CEEPROM(long size, uint8_t pageSize, uint8_t address)
+  : SimI2CDevice(address) {
+  _size = size > MAX_SIZE ? MAX_SIZE : size;
+  _pageSize = pageSize;
+  _pointer = 0;
+  _readyAt = 0;
+  _writeCycles = 0;
+  erase();
+}
+
+bool SimI2CEEPROM::isPresent() {
+  return SimI2CDevice::isPresent() && (SimClock::instance.wallMicros() >= _readyAt);
+}
+
+void SimI2CEEPROM::erase() {
+  memset(_memory, 0xff, sizeof(_memory));
+}
+
+bool SimI2CEEPROM::receive(const uint8_t *data, uint8_t len) {
+  int page;
+
+  if(len < 2) {
+    // Acknowledge polling
+    return true;
+  }
+
+  _pointer = ((data[0] << 8) | data[1]) % _size;
+  if(len > 2) {
+    page = _pointer - _pointer % _pageSize;
+    for(uint8_t i = 2; i < len; i++) {
+      _memory[_pointer] = data[i];
+      _pointer = page + (_pointer + 1 - page) % _pageSize;
+    }
+    _writeCycles++;
+    _readyAt = SimClock::instance.wallMicros() + WRITE_MICROS;
+  }
+
+  return true;
+}
+
+uint8_t SimI2CEEPROM::transmit(uint8_t *buffer, uint8_t len) {
+  for(uint8_t i = 0; i < len; i++) {
+    buffer[i] = _memory[_pointer];
+    _pointer = (_pointer + 1) % _size;
+  }
+
+  return len;
+}
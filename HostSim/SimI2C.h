@@ -0,0 +1,287 @@
+/*
+ * SimI2C.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ *
+ * Simulated I2C bus and the devices the libraries talk to. The <code>Wire</code>
+ * stand-in dispatches every transaction to the device attached with the matching
+ * address. Devices that are not attached, or not present, do not acknowledge
+ * their address, just like on the real bus.
+ */
+
+#ifndef SIMI2C_H_
+#define SIMI2C_H_
+
+#include "HostSim.h"
+#include <Time.h>
+
+/**
+ * Base class of all simulated I2C devices.
+ */
+class SimI2CDevice {
+  public:
+    SimI2CDevice(uint8_t address);
+
+    uint8_t address() { return _address; };
+
+    /**
+     * A device that is not present does not acknowledge its address. Used to script
+     * bus errors and missing sensors.
+     */
+    void setPresent(bool present) { _present = present; };
+    virtual bool isPresent() { return _present; };
+
+    /**
+     * Called for a write transaction addressed to this device.
+     *
+     * @return <code>true</code> if the device acknowledged all bytes;<code>false</code> otherwise.
+     */
+    virtual bool receive(const uint8_t *data, uint8_t len) = 0;
+
+    /**
+     * Called for a read transaction addressed to this device.
+     *
+     * @return the number of bytes the device sent, <code>0</code> if the device did not acknowledge
+     *         its address.
+     */
+    virtual uint8_t transmit(uint8_t *buffer, uint8_t len) = 0;
+
+  private:
+    uint8_t _address;
+    bool _present;
+};
+
+/**
+ * The bus the <code>Wire</code> stand-in is connected to. Every transferred byte, including
+ * the address byte, costs the time it takes at 100 kHz.
+ */
+class SimI2CBus {
+  public:
+    static SimI2CBus instance;
+    static const unsigned long BYTE_MICROS = 90;
+
+    bool attach(SimI2CDevice *device);
+    void detach(SimI2CDevice *device);
+    void detachAll();
+
+    /**
+     * @return <code>0</code> on success, <code>2</code> if no device acknowledged the address and
+     *         <code>3</code> if the device did not acknowledge the data (same as
+     *         <code>Wire.endTransmission</code>).
+     */
+    uint8_t write(uint8_t address, const uint8_t *data, uint8_t len);
+    uint8_t read(uint8_t address, uint8_t *buffer, uint8_t len);
+
+    unsigned long transactions() { return _transactions; };
+    unsigned long bytes() { return _bytes; };
+    void resetCounters() { _transactions = _bytes = 0; };
+
+  private:
+    enum { MAX_DEVICES = 8 };
+
+    SimI2CDevice *find(uint8_t address);
+
+    SimI2CDevice *_devices[MAX_DEVICES];
+    unsigned long _transactions;
+    unsigned long _bytes;
+};
+
+/**
+ * Sensirion SHT21 humidity and temperature sensor. Supports the hold and no-hold master
+ * measurement commands, the user register (resolution) and soft reset. A no-hold measurement
+ * is not acknowledged until the conversion time of the configured resolution has passed. A hold
+ * master measurement stretches the clock, i.e. the read costs the remaining conversion time.
+ */
+class SimSHT21: public SimI2CDevice {
+  public:
+    SimSHT21();
+
+    void setTemperature(float celsius) { _temperature = celsius; };
+    void setHumidity(float relativeHumidity) { _humidity = relativeHumidity; };
+
+    uint8_t userRegister() { return _userRegister; };
+
+    /**
+     * @return the number of measurements that were started.
+     */
+    unsigned long conversions() { return _conversions; };
+
+    bool receive(const uint8_t *data, uint8_t len);
+    uint8_t transmit(uint8_t *buffer, uint8_t len);
+
+    /**
+     * @return the conversion time in microseconds of a temperature or humidity measurement
+     *         with the current resolution.
+     */
+    unsigned long conversionMicros(bool humidity);
+
+    static uint8_t crc(const uint8_t *data, uint8_t len);
+
+  private:
+    float _temperature;
+    float _humidity;
+    uint8_t _userRegister;
+    uint8_t _command;
+    unsigned long long _readyAt;
+    unsigned long _conversions;
+};
+
+/**
+ * Common part of the simulated Maxim real time clocks. The clock keeps time with the wall
+ * time of the simulation; the time and date registers are rendered in BCD whenever they are
+ * read and parsed back whenever they are written. Only the 24 hour mode is supported.
+ * <p>
+ * Attached to a pin (<code>SimPins::attach</code>), the clock drives its square wave output. Only
+ * the 1 Hz rate is simulated: the output falls when a second starts and rises half a second
+ * later. Otherwise the output stays at the level the control register selects. The pins are only
+ * sampled when time passes, the simulation has to advance in steps of less than half a second.
+ */
+class SimRTC: public SimI2CDevice, public SimPinDevice {
+  public:
+    SimRTC(uint8_t registerCount);
+
+    /**
+     * Sets the time of the clock directly, i.e. without going through the bus.
+     */
+    void setTime(time_t t);
+
+    /**
+     * @return the current time of the clock.
+     */
+    time_t getTime();
+
+    /**
+     * Lets the crystal of the clock run <code>ppm</code> parts per million fast (positive) or slow
+     * (negative) compared to the wall time.
+     */
+    void setDrift(long ppm);
+
+    /**
+     * @return the wall time in microseconds at which the current second of the clock started.
+     */
+    unsigned long long secondStart() { getTime(); return _timeMicros; };
+
+    /**
+     * @return the length of a second of the clock in wall microseconds.
+     */
+    unsigned long secondMicros() { return _secondMicros; };
+
+    uint8_t getRegister(uint8_t reg);
+    void setRegister(uint8_t reg, uint8_t value);
+
+    bool receive(const uint8_t *data, uint8_t len);
+    uint8_t transmit(uint8_t *buffer, uint8_t len);
+
+    uint8_t level(uint8_t pin, unsigned long long wallMicros);
+
+  protected:
+    enum { MAX_REGISTERS = 0x40 };
+
+    virtual bool isHalted() = 0;
+
+    /**
+     * @return <code>true</code> if the control register enables the square wave with 1 Hz.
+     */
+    virtual bool isSquareWave1Hz() = 0;
+
+    /**
+     * @return the level of the square wave output if the square wave is off.
+     */
+    virtual uint8_t outputLevel() { return HIGH; };
+
+    /**
+     * @return the bits of the seconds register that are not part of the time, but keep
+     *         the value that was written.
+     */
+    virtual uint8_t clockHaltMask() { return 0; };
+
+    /**
+     * Renders the time into the time keeping registers.
+     */
+    void render();
+
+    /**
+     * Parses the time keeping registers after they have been written.
+     */
+    void parse();
+
+    uint8_t _registers[MAX_REGISTERS];
+    uint8_t _registerCount;
+    uint8_t _pointer;
+    time_t _time;
+    unsigned long long _timeMicros;
+    unsigned long _secondMicros;
+};
+
+/**
+ * Maxim DS1307: 7 time keeping registers, the control register at 0x07 and 56 bytes of
+ * battery backed RAM. The clock halt bit is bit 7 of the seconds register.
+ */
+class SimDS1307: public SimRTC {
+  public:
+    SimDS1307();
+
+  protected:
+    bool isHalted();
+    uint8_t clockHaltMask();
+    bool isSquareWave1Hz();
+    uint8_t outputLevel();
+};
+
+/**
+ * Maxim DS1339: 7 time keeping registers, two alarms, control (0x0e), status (0x0f) and
+ * trickle charger (0x10) registers. The oscillator is stopped with the EOSC bit (bit 7) of the
+ * control register. The SQW/INT output is the square wave unless the INTCN bit (bit 2) is set, in
+ * which case the open drain output is pulled up.
+ */
+class SimDS1339: public SimRTC {
+  public:
+    SimDS1339();
+
+  protected:
+    bool isHalted();
+    bool isSquareWave1Hz();
+};
+
+/**
+ * External I2C EEPROM with two address bytes, like the 24LC256. Supports random and sequential
+ * reads, byte and page writes. Within a page write the address wraps at the end of the page. After a
+ * write the EEPROM does not acknowledge its address until the write cycle of 5 ms is done.
+ */
+class SimI2CEEPROM: public SimI2CDevice {
+  public:
+    static const int MAX_SIZE = 0x8000;
+    static const unsigned long WRITE_MICROS = 5000;
+
+    SimI2CEEPROM(long size = MAX_SIZE, uint8_t pageSize = 64, uint8_t address = 0x50);
+
+    bool isPresent();
+
+    /**
+     * Sets all bytes to <code>0xff</code>.
+     */
+    void erase();
+
+    uint8_t getByte(int addr) { return _memory[addr % _size]; };
+    void setByte(int addr, uint8_t value) { _memory[addr % _size] = value; };
+
+    /**
+     * @return the number of write cycles, i.e. byte or page writes.
+     */
+    unsigned long writeCycles() { return _writeCycles; };
+    void resetCounters() { _writeCycles = 0; };
+
+    bool receive(const uint8_t *data, uint8_t len);
+    uint8_t transmit(uint8_t *buffer, uint8_t len);
+
+  private:
+    uint8_t _memory[MAX_SIZE];
+    long _size;
+    uint8_t _pageSize;
+    int _pointer;
+    unsigned long long _readyAt;
+    unsigned long _writeCycles;
+};
+
+#endif /* SIMI2C_H_ */
@@ -0,0 +1,151 @@
+/*
+ * SimulatedYear.pde
+ *
+ * Runs a thermostat through a whole year on the host. The sketch uses the real
+ * libraries (Time, DS1307RTC, SHT21, TemperatureMgmt, Controller) on top of the
+ * simulated DS1307, SHT21 and EEPROM, and a very simple thermal model of a room.
+ * It prints a summary per month and how long the host needed for the year.
+ *
+ * Only runs on the host, see HostSim/readme.txt for how to build it.
+ */
+
+#include <HostSim.h>
+#include <SimI2C.h>
+#include <Wire.h>
+#include <EEPROM.h>
+#include <WriteBackCache.h>
+#include <Time.h>
+#include <DS1307RTC.h>
+#include <Sensor.h>
+#include <SHT21.h>
+#include <TemperatureProfile.h>
+#include <TemperatureProfileManager.h>
+#include <TemperatureManager.h>
+#include <BBController.h>
+#include <time.h>
+
+#define MEM_ADDR 0x100
+#define NUM_PROFILES 3
+#define CONTROL_PERIOD 60L
+
+SimDS1307 rtcChip;
+SimSHT21 sht21Chip;
+
+SHT21 sht21;
+BBController controller(BBController::NORMAL);
+
+float roomTemperature = 65.0;
+
+time_t syncProvider() {
+  RTC.readTime();
+  return RTC.getTime();
+}
+
+void setup() {
+  tmElements_t te;
+
+  Serial.begin(9600);
+
+  SimEEPROM::instance.open("SimulatedYear.eeprom");
+  SimI2CBus::instance.attach(&rtcChip);
+  SimI2CBus::instance.attach(&sht21Chip);
+
+  // Jan 1, 2011 00:00:00
+  te.Year = CalendarYrToTm(2011);
+  te.Month = 1;
+  te.Day = 1;
+  te.Hour = te.Minute = te.Second = 0;
+  rtcChip.setTime(makeTime(te));
+
+  RTC.initialize(-1, true);
+  RTC.start();
+  setSyncProvider(syncProvider);
+
+  TemperatureProfileManager::setMemoryInfo(MEM_ADDR + 0x50, NUM_PROFILES);
+  TemperatureManager::setMemoryInfo(MEM_ADDR);
+  TPM.format();
+
+  // Work day morning: warm when getting up, cold while at work
+  TPROFILE.setId(1);
+  TPROFILE.add(0, 68);
+  TPROFILE.add(8, 60);
+  TPROFILE.add(40, 68);
+  TPM.save();
+
+  // Evening and night
+  TPROFILE.setId(2);
+  TPROFILE.add(0, 68);
+  TPROFILE.add(20, 60);
+  TPM.save();
+
+  // Weekend day
+  TPROFILE.setId(3);
+  TPROFILE.add(0, 69);
+  TPM.save();
+
+  TEMPMGR.clear();
+  for(int day = TemperatureManager::SUNDAY; day <= TemperatureManager::SATURDAY; day++) {
+    bool weekend = (day == TemperatureManager::SUNDAY) || (day == TemperatureManager::SATURDAY);
+
+    for(int season = TemperatureManager::SUMMER; season < TemperatureManager::MAX_TIME_OF_YEAR; season++) {
+      TEMPMGR.setProfile(weekend ? 3 : 1, (TemperatureManager::Days)day, TemperatureManager::AM,
+                         (TemperatureManager::TimeOfYear)season);
+      TEMPMGR.setProfile(2, (TemperatureManager::Days)day, TemperatureManager::PM,
+                         (TemperatureManager::TimeOfYear)season);
+    }
+  }
+  TEMPMGR.setTimeOfYear(TemperatureManager::WINTER);
+
+  sht21.initialize();
+  controller.setTolerance(1.0);
+}
+
+void loop() {
+  clock_t start = clock();
+  unsigned long heaterMinutes = 0;
+  int lastSetPoint = -1;
+  int lastMonth = month();
+
+  for(unsigned long step = 0; step < 365UL * SECS_PER_DAY / CONTROL_PERIOD; step++) {
+    time_t t;
+    int setPoint;
+    bool heating;
+    float outside;
+
+    SimClock::instance.advance(CONTROL_PERIOD * 1000000ULL);
+    t = now();
+
+    setPoint = TEMPMGR.getSetPointFor(t);
+    sht21Chip.setTemperature((roomTemperature - 32.0) / 1.8);
+    sht21.readSensor(millis(), SHT21::TemperatureF);
+
+    if(setPoint != lastSetPoint) {
+      heating = controller.updateSetpoint(setPoint, sht21.getTemperature(false));
+      lastSetPoint = setPoint;
+    }
+    else {
+      heating = controller.controlOn(sht21.getTemperature(false));
+    }
+
+    // Outside temperature between 20F in January and 80F in July
+    outside = 50.0 - 30.0 * cos(2.0 * PI * (month(t) - 1) / 12.0);
+    roomTemperature += (outside - roomTemperature) * 0.002;
+    if(heating) {
+      roomTemperature += 0.2;
+      heaterMinutes += CONTROL_PERIOD / 60;
+    }
+
+    if(month(t) != lastMonth) {
+      Serial.print(monthShortStr(lastMonth));
+      Serial.print(": heater on ");
+      Serial.print(heaterMinutes / 60);
+      Serial.println(" hours");
+      heaterMinutes = 0;
+      lastMonth = month(t);
+    }
+  }
+
+  Serial.print("Simulated 365 days in ");
+  Serial.print((double)(clock() - start) / CLOCKS_PER_SEC, 3);
+  Serial.println(" seconds");
+}
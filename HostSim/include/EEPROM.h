@@ -0,0 +1,21 @@
+/*
+ * EEPROM.h - host stand-in for the Arduino EEPROM library
+ *
+ * Same interface as the EEPROM library of Arduino 0022, backed by
+ * <code>SimEEPROM::instance</code> (see HostSim.h).
+ */
+
+#ifndef EEPROM_h
+#define EEPROM_h
+
+#include <inttypes.h>
+
+class EEPROMClass {
+  public:
+    uint8_t read(int);
+    void write(int, uint8_t);
+};
+
+extern EEPROMClass EEPROM;
+
+#endif
@@ -0,0 +1,64 @@
+/*
+ * HardwareSerial.h - host stand-in for the Arduino serial port
+ *
+ * Everything printed through <code>Serial</code> is written to the standard output
+ * of the host process, which makes the output of sketches and unit tests visible
+ * on the console. Nothing is ever received. Like the serial port of Arduino 0022,
+ * which has no transmit buffer, every byte costs the time it takes to send it with
+ * the speed passed to <code>begin</code>.
+ */
+
+#ifndef HardwareSerial_h
+#define HardwareSerial_h
+
+#include <inttypes.h>
+#include <stdio.h>
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+#define BYTE 0
+
+class HardwareSerial {
+  public:
+    void begin(long speed) { _speed = speed; };
+    void end() {};
+    uint8_t available(void) { return 0; };
+    int peek(void) { return -1; };
+    int read(void) { return -1; };
+    void flush(void) {};
+    void write(uint8_t c);
+    void write(const char *str);
+    void write(const uint8_t *buffer, size_t size);
+
+    void print(const char[]);
+    void print(char, int = BYTE);
+    void print(unsigned char, int = BYTE);
+    void print(int, int = DEC);
+    void print(unsigned int, int = DEC);
+    void print(long, int = DEC);
+    void print(unsigned long, int = DEC);
+    void print(double, int = 2);
+
+    void println(const char[]);
+    void println(char, int = BYTE);
+    void println(unsigned char, int = BYTE);
+    void println(int, int = DEC);
+    void println(unsigned int, int = DEC);
+    void println(long, int = DEC);
+    void println(unsigned long, int = DEC);
+    void println(double, int = 2);
+    void println(void);
+
+  private:
+    void charge(size_t bytes);
+    void printNumber(unsigned long, uint8_t);
+    void printFloat(double, uint8_t);
+
+    long _speed;
+};
+
+extern HardwareSerial Serial;
+
+#endif
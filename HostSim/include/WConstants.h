@@ -0,0 +1 @@
+#include "wiring.h"
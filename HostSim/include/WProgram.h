@@ -0,0 +1,31 @@
+/*
+ * WProgram.h - host stand-in for the Arduino core
+ *
+ * Include path order matters: HostSim/include has to come before any other
+ * Arduino installation, so that the libraries pick up the simulated core.
+ */
+
+#ifndef WProgram_h
+#define WProgram_h
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "wiring.h"
+
+#ifdef __cplusplus
+#include "HardwareSerial.h"
+
+uint16_t makeWord(uint16_t w);
+uint16_t makeWord(byte h, byte l);
+
+#define word(...) makeWord(__VA_ARGS__)
+
+long random(long);
+long random(long, long);
+void randomSeed(unsigned int);
+long map(long, long, long, long, long);
+#endif
+
+#endif
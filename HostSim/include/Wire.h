@@ -0,0 +1,49 @@
+/*
+ * Wire.h - host stand-in for the Arduino I2C library
+ *
+ * Same interface as the Wire library of Arduino 0022. Transactions are not sent
+ * on a wire, they are dispatched to the devices attached to
+ * <code>SimI2CBus::instance</code> (see SimI2C.h).
+ */
+
+#ifndef TwoWire_h
+#define TwoWire_h
+
+#include <inttypes.h>
+
+#define BUFFER_LENGTH 32
+
+class TwoWire {
+  public:
+    TwoWire();
+    void begin();
+    void begin(uint8_t);
+    void begin(int);
+    void beginTransmission(uint8_t);
+    void beginTransmission(int);
+    uint8_t endTransmission(void);
+    uint8_t requestFrom(uint8_t, uint8_t);
+    uint8_t requestFrom(int, int);
+    void send(uint8_t);
+    void send(uint8_t*, uint8_t);
+    void send(int);
+    void send(char*);
+    uint8_t available(void);
+    uint8_t receive(void);
+    void onReceive(void (*)(int)) {};
+    void onRequest(void (*)(void)) {};
+
+  private:
+    uint8_t _rxBuffer[BUFFER_LENGTH];
+    uint8_t _rxBufferIndex;
+    uint8_t _rxBufferLength;
+
+    uint8_t _txAddress;
+    uint8_t _txBuffer[BUFFER_LENGTH];
+    uint8_t _txBufferLength;
+    bool _transmitting;
+};
+
+extern TwoWire Wire;
+
+#endif
@@ -0,0 +1,25 @@
+/*
+ * avr/interrupt.h - host stand-in for the avr-libc interrupt macros
+ *
+ * The simulated MCU has a single thread, interrupt handlers are called by the
+ * simulator from the place that caused the event. <code>cli</code> and
+ * <code>sei</code> maintain the I-bit in <code>SREG</code> only.
+ */
+
+#ifndef _AVR_INTERRUPT_H_
+#define _AVR_INTERRUPT_H_
+
+#include <avr/io.h>
+
+#define SREG_I 7
+
+#define sei() (SREG |= _BV(SREG_I))
+#define cli() (SREG &= ~_BV(SREG_I))
+
+#ifdef __cplusplus
+#define ISR(vector, ...) extern "C" void vector(void); extern "C" void vector(void)
+#else
+#define ISR(vector, ...) void vector(void); void vector(void)
+#endif
+
+#endif
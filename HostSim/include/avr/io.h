@@ -0,0 +1,56 @@
+/*
+ * avr/io.h - host stand-in for the avr-libc register definitions
+ *
+ * Only the registers the libraries touch are defined. They are plain variables of
+ * the simulated MCU, i.e. writing them has no side effect.
+ */
+
+#ifndef _AVR_IO_H_
+#define _AVR_IO_H_
+
+#include <stdint.h>
+#include <pins_arduino.h>
+
+#define _BV(bit) (1 << (bit))
+
+// Last address of the EEPROM of an ATmega328
+#define E2END 0x3FF
+
+extern volatile uint8_t SREG;
+
+#define PINB  (SimPortRegisters[0][0])
+#define DDRB  (SimPortRegisters[0][1])
+#define PORTB (SimPortRegisters[0][2])
+#define PINC  (SimPortRegisters[1][0])
+#define DDRC  (SimPortRegisters[1][1])
+#define PORTC (SimPortRegisters[1][2])
+#define PIND  (SimPortRegisters[2][0])
+#define DDRD  (SimPortRegisters[2][1])
+#define PORTD (SimPortRegisters[2][2])
+
+// ADC, simulated by SimADC
+extern volatile uint8_t ADMUX;
+extern volatile uint8_t ADCSRA;
+extern volatile uint8_t ADCSRB;
+extern volatile uint8_t DIDR0;
+extern volatile uint16_t SimADCResult;
+#define ADC SimADCResult
+
+#define REFS1 7
+#define REFS0 6
+#define ADLAR 5
+
+#define ADEN  7
+#define ADSC  6
+#define ADATE 5
+#define ADIF  4
+#define ADIE  3
+#define ADPS2 2
+#define ADPS1 1
+#define ADPS0 0
+
+#define ADTS2 2
+#define ADTS1 1
+#define ADTS0 0
+
+#endif
@@ -0,0 +1,30 @@
+/*
+ * avr/pgmspace.h - host stand-in for the avr-libc program memory access
+ *
+ * The host has a single address space, so program memory is ordinary memory.
+ * <code>pgm_read_word</code> reads a whole pointer, as on the host a pointer
+ * does not fit into 16 bits.
+ */
+
+#ifndef __PGMSPACE_H_
+#define __PGMSPACE_H_
+
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+
+typedef const char *PGM_P;
+typedef const void *PGM_VOID_P;
+
+#define pgm_read_byte(address) (*(const uint8_t *)(address))
+#define pgm_read_word(address) (*(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+
+#define strcpy_P(dest, src) strcpy((dest), (src))
+#define strncpy_P(dest, src, n) strncpy((dest), (src), (n))
+#define strlen_P(src) strlen(src)
+#define memcpy_P(dest, src, n) memcpy((dest), (src), (n))
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * avr/sleep.h - host stand-in for the avr-libc sleep functions
+ *
+ * Entering a sleep mode hands control to the simulated clock, which lets the
+ * duration scheduled with <code>SimClock::sleepFor</code> pass. In power-down
+ * and power-save mode the timer behind <code>millis</code> is stopped, exactly
+ * like on the real MCU.
+ */
+
+#ifndef _AVR_SLEEP_H_
+#define _AVR_SLEEP_H_
+
+#include <stdint.h>
+
+#define SLEEP_MODE_IDLE         0
+#define SLEEP_MODE_ADC          1
+#define SLEEP_MODE_PWR_DOWN     2
+#define SLEEP_MODE_PWR_SAVE     3
+#define SLEEP_MODE_STANDBY      6
+#define SLEEP_MODE_EXT_STANDBY  7
+
+void set_sleep_mode(uint8_t mode);
+void sleep_enable(void);
+void sleep_disable(void);
+void sleep_cpu(void);
+void sleep_mode(void);
+
+#endif
@@ -0,0 +1,40 @@
+/*
+ * pins_arduino.h - host stand-in for the ATmega328 pin mapping
+ *
+ * The simulated MCU has the three ports of an ATmega328 (B, C, D). As on the real
+ * part, the PIN, DDR and PORT registers of a port are consecutive, so drivers that
+ * address them relative to the input register work unchanged. Digital pins 0..7
+ * are PORTD, 8..13 are PORTB and 14..19 (A0..A5) are PORTC.
+ */
+
+#ifndef Pins_Arduino_h
+#define Pins_Arduino_h
+
+#include <stdint.h>
+
+#define NOT_A_PIN 0
+#define NOT_A_PORT 0
+
+#define PB 2
+#define PC 3
+#define PD 4
+
+#define NUM_DIGITAL_PINS 20
+#define NUM_ANALOG_INPUTS 6
+
+// [port - PB][0 = PIN, 1 = DDR, 2 = PORT]
+extern volatile uint8_t SimPortRegisters[3][3];
+
+static inline uint8_t digitalPinToPort(uint8_t pin) {
+  return pin < 8 ? PD : (pin < 14 ? PB : (pin < NUM_DIGITAL_PINS ? PC : NOT_A_PIN));
+}
+
+static inline uint8_t digitalPinToBitMask(uint8_t pin) {
+  return 1 << (pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14));
+}
+
+#define portInputRegister(P) (&SimPortRegisters[(P) - PB][0])
+#define portModeRegister(P) (&SimPortRegisters[(P) - PB][1])
+#define portOutputRegister(P) (&SimPortRegisters[(P) - PB][2])
+
+#endif
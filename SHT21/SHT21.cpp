@@ -35,12 +35,21 @@
  **********************************************************/
 SHT21::SHT21() {
 //    Wire.begin();
-    readDelay = 100;
+    _resolution = RES_12_14;
+    _async = false;
+    _measuring = false;
+    _measuringHumidity = false;
+    _acquiring = false;
+    _measurementStart = 0;
+    _rawHumidity = 0;
+    _rawTemperature = 0;
+    _humidity = calculateFixedHumidity(0);
+    _temperature = calculateFixedTemperature(0);
 }
 
 Sensor::Error SHT21::initialize() {
-  readSensorImpl(millis(), Humidity);
-  readSensorImpl(millis(), TemperatureC);
+  measure(Humidity);
+  measure(TemperatureC);
 
   return SensorImpl::initialize();
 }
@@ -52,19 +61,150 @@ Sensor::Error SHT21::initialize() {
  */
 
 Sensor::Error SHT21::readSensorImpl(unsigned long timeInMillis, int config) {
-  if(config == Humidity) {
-    _humidity = calculateHumidity(readSensorValue(eRHumidityHoldCmd));
+  Sensor::Error err;
+  bool measuredHumidity;
+
+  if(!_async) {
+    if(config == ALL_CHANNELS) {
+      err = measure(Humidity);
+      return err == NO_ERROR ? measure(TemperatureC) : err;
+    }
+    return measure(config);
+  }
+
+  if(config == ALL_CHANNELS) {
+    return acquire(timeInMillis);
+  }
+
+  if(_measuring) {
+    measuredHumidity = _measuringHumidity;
+    err = completeMeasurement(timeInMillis);
+    if((err == MEASUREMENT_PENDING) || (measuredHumidity == (config == Humidity))) {
+      return err;
+    }
+    // The other value was measured, now start the one that was asked for
+  }
+
+  err = startMeasurement(timeInMillis, config);
+
+  return err == NO_ERROR ? MEASUREMENT_PENDING : err;
+}
+
+/**
+ * Asynchronous reading of both values: the humidity first, then the temperature.
+ */
+Sensor::Error SHT21::acquire(unsigned long timeInMillis) {
+  Sensor::Error err;
+  bool measuredHumidity;
+
+  if(_measuring) {
+    measuredHumidity = _measuringHumidity;
+    err = completeMeasurement(timeInMillis);
+    if(err == MEASUREMENT_PENDING) {
+      return err;
+    }
+    if(_acquiring) {
+      if((err != NO_ERROR) || !measuredHumidity) {
+        _acquiring = false;
+        return err;
+      }
+      err = startMeasurement(timeInMillis, TemperatureC);
+      _acquiring = err == NO_ERROR;
+      return _acquiring ? MEASUREMENT_PENDING : err;
+    }
+    // A single value was measured, the acquisition starts from the beginning
+  }
+
+  err = startMeasurement(timeInMillis, Humidity);
+  _acquiring = err == NO_ERROR;
+
+  return _acquiring ? MEASUREMENT_PENDING : err;
+}
+
+Sensor::Error SHT21::startMeasurement(unsigned long timeInMillis, int config) {
+  _measuring = false;
+  _acquiring = false;
+  _measuringHumidity = config == Humidity;
+
+  Wire.beginTransmission(eSHT21Address);
+  Wire.send(_measuringHumidity ? eRHumidityNoHoldCmd : eTempNoHoldCmd);
+  if(Wire.endTransmission() != 0) {
+    return SENSOR_NOT_PRESENT;
+  }
+
+  _measuring = true;
+  _measurementStart = timeInMillis;
+
+  return NO_ERROR;
+}
+
+bool SHT21::isMeasurementReady(unsigned long timeInMillis) {
+  return _measuring && (timeInMillis - _measurementStart >= conversionTime(_measuringHumidity));
+}
+
+Sensor::Error SHT21::completeMeasurement(unsigned long timeInMillis) {
+  uint8_t data[3];
+  uint16_t value;
+
+  if(!_measuring) {
+    return FUNCTION_NOT_SUPPORTED;
+  }
+
+  // Do not bother the bus before the conversion can be done. The sensor does not acknowledge
+  // the read before the conversion is done.
+  if(!isMeasurementReady(timeInMillis) || (Wire.requestFrom(eSHT21Address, 3) < 3)) {
+    if(timeInMillis - _measurementStart > 2UL * conversionTime(_measuringHumidity)) {
+      _measuring = false;
+      return DATA_TIMEOUT;
+    }
+    return MEASUREMENT_PENDING;
+  }
+
+  for(uint8_t i = 0; i < 3; i++) {
+    data[i] = Wire.receive();
+  }
+  _measuring = false;
+
+  if(crc(data, 2) != data[2]) {
+    return CHECKSUM_ERROR;
+  }
+
+  value = ((data[0] << 8) | data[1]) & ~0x0003;   // clear two low bits (status bits)
+  if(_measuringHumidity) {
+    _rawHumidity = value;
+    _humidity = calculateFixedHumidity(value);
   }
   else {
-    _temperature = calculateTemperature(readSensorValue(eTempHoldCmd));
+    _rawTemperature = value;
+    _temperature = calculateFixedTemperature(value);
   }
 
   return NO_ERROR;
 }
 
+uint8_t SHT21::conversionTime(bool humidity) {
+  // Maximum conversion times of the data sheet, indexed by the resolution bits 7 and 0
+  static const uint8_t temperatureTimes[] = { 85, 22, 43, 11 };
+  static const uint8_t humidityTimes[] = { 29, 4, 9, 15 };
+  uint8_t index = ((_resolution & 0x80) >> 6) | (_resolution & 0x01);
+
+  return humidity ? humidityTimes[index] : temperatureTimes[index];
+}
+
 float SHT21::getFloatValue(int config = 0) {
   if(config == TemperatureF) {
-    return _temperature * 1.8 + 32;
+    return calculateTemperature(_rawTemperature) * 1.8 + 32;
+  }
+  else if(config == Humidity) {
+    return calculateHumidity(_rawHumidity);
+  }
+
+  return calculateTemperature(_rawTemperature);
+}
+
+int SHT21::getFixedValue(int config = 0) {
+  if(config == TemperatureF) {
+    return fixedToFahrenheit(_temperature);
   }
   else if(config == Humidity) {
     return _humidity;
@@ -76,24 +216,24 @@ float SHT21::getFloatValue(int config = 0) {
 // return temperature time 8 => 0.125 degrees resolution
 int SHT21::getIntegerValue(int config = 0) {
   if(config == TemperatureF) {
-    return (int)round((_temperature * 1.8 + 32) * 3);
+    return fixedDivide((long)fixedToFahrenheit(_temperature) * 3, FIXED_SCALE);
   }
   else if(config == Humidity) {
-    return (int)round(_humidity * 3);
+    return fixedDivide((long)_humidity * 3, FIXED_SCALE);
   }
 
-  return (int)round(_temperature * 8);
+  return fixedDivide((long)_temperature * 8, FIXED_SCALE);
 }
 
 byte SHT21::getByteValue(int config = 0) {
   if(config == TemperatureF) {
-    return (byte)round(_temperature * 1.8 + 32);
+    return (byte)fixedDivide(fixedToFahrenheit(_temperature), FIXED_SCALE);
   }
   else if(config == Humidity) {
-    return (byte)round(_humidity);
+    return (byte)fixedDivide(_humidity, FIXED_SCALE);
   }
 
-  return (byte)round(_temperature);
+  return (byte)fixedDivide(_temperature, FIXED_SCALE);
 }
 
 
@@ -106,21 +246,7 @@ uint8_t SHT21::setResolution(SHT21::Resolution res) {
 	
 	reg = getUserRegister();
 	reg = (reg & RES_MASK) | res;
-		
-	switch(res) {
-		case RES_12_14:
-			readDelay = 85;
-			break;
-		case RES_10_13:
-			readDelay = 43;
-			break;
-		case RES_08_12:
-			readDelay = 29;
-			break;
-		case RES_11_11:
-			readDelay = 11;
-			break;
-	}
+	_resolution = res;
 	
 	writeUserRegister(reg);
 	
@@ -129,6 +255,9 @@ uint8_t SHT21::setResolution(SHT21::Resolution res) {
 
 Sensor::Error SHT21::reset() {
 	writeReset();
+	_resolution = RES_12_14;
+	_measuring = false;
+	_acquiring = false;
 
 	return SensorImpl::reset();
 ;
@@ -138,25 +267,20 @@ Sensor::Error SHT21::reset() {
  * Private Functions
  ******************************************************************************/
 
-uint16_t SHT21::readSensorValue(uint8_t command) {
-	uint16_t result;
-
-	Wire.beginTransmission(eSHT21Address);   //begin
-	Wire.send(command);                      //send the pointer location
-	delay(readDelay);
-	Wire.endTransmission();                  //end
-
-	Wire.requestFrom(eSHT21Address, 3);
-	while(Wire.available() < 3) {
-		delay(5);
-	}
-
-		//Store the result
-	result = ((Wire.receive()) << 8);
-	result += Wire.receive();
-	result &= ~0x0003;   // clear two low bits (status bits)
+/**
+ * Blocking measurement, waits for the conversion time and then polls for the result.
+ */
+Sensor::Error SHT21::measure(int config) {
+  Sensor::Error err = startMeasurement(millis(), config);
+
+  if(err == NO_ERROR) {
+    delay(conversionTime(_measuringHumidity));
+    do {
+      err = completeMeasurement(millis());
+    } while(err == MEASUREMENT_PENDING);
+  }
 
-	return result;
+  return err;
 }
 
 uint8_t SHT21::readUserRegister() {
@@ -199,6 +323,30 @@ float SHT21::calculateHumidity(uint16_t analogHumValue) {
   return -6.0 + 125.0 / 65536.0 * analogHumValue;
 }
 
+int SHT21::calculateFixedTemperature(uint16_t analogTempValue) {
+  // T[0.01 C] = -4685 + 17572 * ST/2^16, rounded
+  return (int)((17572UL * analogTempValue + 0x8000) >> 16) - 4685;
+}
+
+int SHT21::calculateFixedHumidity(uint16_t analogHumValue) {
+  // RH[0.01 %] = -600 + 12500 * SRH/2^16, rounded
+  return (int)((12500UL * analogHumValue + 0x8000) >> 16) - 600;
+}
+
+uint8_t SHT21::crc(const uint8_t *data, uint8_t len) {
+  uint8_t crc = 0;
+
+  // Polynomial x^8 + x^5 + x^4 + 1
+  for(uint8_t i = 0; i < len; i++) {
+    crc ^= data[i];
+    for(uint8_t bit = 8; bit > 0; bit--) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x131 : (crc << 1);
+    }
+  }
+
+  return crc;
+}
+
 void SHT21::printDebug() {
 	Serial.print(" userRegister:");
   Serial.print(getUserRegister(), BIN);
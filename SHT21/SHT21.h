@@ -31,6 +31,23 @@ Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301  USA
 #define RES_MASK 0x7E
 
 
+/**
+ * Sensirion SHT21 humidity and temperature sensor on the I2C bus.
+ * <p>
+ * Measurements use the no-hold master commands, so the bus is free while the sensor converts.
+ * A measurement goes through three steps: <code>startMeasurement</code> sends the command,
+ * <code>isMeasurementReady</code> tells if the conversion time of the configured resolution has
+ * passed and <code>completeMeasurement</code> reads the result. The sensor does not acknowledge its
+ * address before the conversion is done, so <code>completeMeasurement</code> can be polled.
+ * <p>
+ * By default <code>readSensor</code> runs through all three steps and waits for the conversion
+ * (11...85 ms). In asynchronous mode (<code>setAsync(true)</code>) <code>readSensor</code> never waits:
+ * the first call starts a measurement and returns <code>MEASUREMENT_PENDING</code>, later calls
+ * return <code>MEASUREMENT_PENDING</code> until the result has been read.
+ * <p>
+ * <code>readSensor</code> with <code>ALL_CHANNELS</code> measures the humidity and then the temperature, so
+ * adapters for humidity and temperature created with a maximum age share the reading.
+ */
 class SHT21 : public SensorImpl {
 	public:
     enum Address {
@@ -96,6 +113,17 @@ class SHT21 : public SensorImpl {
      */
     float getFloatValue(int config);
 
+    /**
+     * Returns the temperature (<code>TemperatureC</code>, <code>TemperatureF</code>) or the humidity
+     * (<code>Humidity</code>) of the last reading in hundredths, e.g. 2150 for 21.50 C. The values
+     * are computed with integer arithmetic when they are read.
+     *
+     * @param[IN] config the value to return
+     *
+     * @return the value in hundredths of C, F or %RH.
+     */
+    int getFixedValue(int config);
+
     /**
      * Gets the current humidity from the sensor.
      *
@@ -122,6 +150,47 @@ class SHT21 : public SensorImpl {
     //--- Methods specific to the SHT21 sensor
 		uint8_t getUserRegister(void);
 		uint8_t setResolution(SHT21::Resolution res);
+
+    /**
+     * Turns the asynchronous mode of <code>readSensor</code> on or off.
+     */
+    void setAsync(bool async) { _async = async; };
+    bool isAsync() { return _async; };
+
+    /**
+     * Sends the no-hold master command for the measurement selected by <code>config</code>. A
+     * measurement that is still running is abandoned.
+     *
+     * @return <code>NO_ERROR</code> if the sensor accepted the command;<code>SENSOR_NOT_PRESENT</code>
+     *         otherwise.
+     */
+    Sensor::Error startMeasurement(unsigned long timeInMillis, int config);
+
+    /**
+     * @return <code>true</code> if a measurement is running and the conversion time has passed.
+     */
+    bool isMeasurementReady(unsigned long timeInMillis);
+
+    /**
+     * Reads the result of the running measurement.
+     *
+     * @return <code>NO_ERROR</code> if the value was read, <code>MEASUREMENT_PENDING</code> if the
+     *         conversion is not done yet, <code>DATA_TIMEOUT</code> if the sensor did not deliver the value
+     *         in twice the conversion time, <code>CHECKSUM_ERROR</code> if the CRC of the value does not match
+     *         and <code>FUNCTION_NOT_SUPPORTED</code> if no measurement was started.
+     */
+    Sensor::Error completeMeasurement(unsigned long timeInMillis);
+
+    /**
+     * @return <code>true</code> if a measurement was started, but its result was not read yet.
+     */
+    bool isMeasuring() { return _measuring; };
+
+    /**
+     * @return the maximum conversion time in ms of a humidity or temperature measurement with the
+     *         current resolution.
+     */
+    uint8_t conversionTime(bool humidity);
 		
 		void printDebug();
 
@@ -130,16 +199,29 @@ class SHT21 : public SensorImpl {
 
 
 	private:
-    uint16_t readDelay;
+    uint8_t _resolution;
     float calculateHumidity(uint16_t analogHumValue);
     float calculateTemperature(uint16_t analogTempValue);
-    uint16_t readSensorValue(uint8_t command);
+    int calculateFixedHumidity(uint16_t analogHumValue);
+    int calculateFixedTemperature(uint16_t analogTempValue);
+    uint8_t crc(const uint8_t *data, uint8_t len);
+    Sensor::Error measure(int config);
+    Sensor::Error acquire(unsigned long timeInMillis);
     uint8_t readUserRegister();
     void writeUserRegister(uint8_t value);
     void writeReset();
 
-    float _humidity;
-    float _temperature;
+    // The raw values of the last readings, the floats are computed from them on demand
+    uint16_t _rawHumidity;
+    uint16_t _rawTemperature;
+    int _humidity;
+    int _temperature;
+
+    bool _async;
+    bool _measuring;
+    bool _measuringHumidity;
+    bool _acquiring;
+    unsigned long _measurementStart;
 };
 
 #endif
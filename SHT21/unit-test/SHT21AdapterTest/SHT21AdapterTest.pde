@@ -0,0 +1,118 @@
+/*
+ * Tests adapters that share the readings of the SHT21 against the simulated sensor, i.e. only runs
+ * on the host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Wire.h>
+#include <Sensor.h>
+#include <SHT21.h>
+#include <SimI2C.h>
+
+TestSuite suite;
+
+SimSHT21 chip;
+SHT21 sht21;
+SensorAdapter humidity(&sht21, SHT21::Humidity, 2000);
+SensorAdapter celsius(&sht21, SHT21::TemperatureC, 2000);
+SensorAdapter fahrenheit(&sht21, SHT21::TemperatureF, 2000);
+
+void setup() {
+  Serial.begin(9600);
+  Wire.begin();
+  SimI2CBus::instance.attach(&chip);
+  sht21.initialize();
+}
+
+void loop() {
+  suite.run();
+}
+
+test(shared) {
+  unsigned long conversions = chip.conversions();
+
+  sht21.setAsync(false);
+  chip.setTemperature(22.0);
+  chip.setHumidity(55.0);
+  delay(2000);
+
+  // The first adapter reads both values, the others use them
+  assertEquals(Sensor::NO_ERROR, humidity.readSensor(millis()));
+  assertUnsignedLongEquals(conversions + 2, chip.conversions());
+  assertEquals(Sensor::NO_ERROR, celsius.readSensor(millis()));
+  assertEquals(Sensor::NO_ERROR, fahrenheit.readSensor(millis()));
+  assertUnsignedLongEquals(conversions + 2, chip.conversions());
+  assertTrue(abs(humidity.getFixedValue() - 5500) <= 1);
+  assertTrue(abs(celsius.getFixedValue() - 2200) <= 1);
+  assertTrue(abs(fahrenheit.getFixedValue() - 7160) <= 2);
+
+  // Once the reading is too old, the next adapter reads again
+  chip.setTemperature(23.0);
+  delay(2000);
+  assertEquals(Sensor::NO_ERROR, celsius.readSensor(millis()));
+  assertEquals(Sensor::NO_ERROR, humidity.readSensor(millis()));
+  assertUnsignedLongEquals(conversions + 4, chip.conversions());
+  assertTrue(abs(celsius.getFixedValue() - 2300) <= 1);
+
+  // Reading a single value does not refresh the shared reading
+  delay(2000);
+  assertEquals(Sensor::NO_ERROR, sht21.readSensor(millis(), SHT21::TemperatureC));
+  assertTrue(!sht21.isAcquired(millis(), 2000));
+}
+
+test(async) {
+  unsigned long conversions;
+
+  sht21.setAsync(true);
+  chip.setTemperature(19.0);
+  chip.setHumidity(35.0);
+  delay(2000);
+  conversions = chip.conversions();
+
+  assertEquals(Sensor::MEASUREMENT_PENDING, celsius.readSensor(millis()));
+  delay(sht21.conversionTime(true));
+  // Humidity is done, temperature is started
+  assertEquals(Sensor::MEASUREMENT_PENDING, humidity.readSensor(millis()));
+  assertUnsignedLongEquals(conversions + 2, chip.conversions());
+  assertEquals(Sensor::MEASUREMENT_PENDING, fahrenheit.readSensor(millis()));
+  delay(sht21.conversionTime(false));
+  assertEquals(Sensor::NO_ERROR, celsius.readSensor(millis()));
+  assertEquals(Sensor::NO_ERROR, humidity.readSensor(millis()));
+  assertEquals(Sensor::NO_ERROR, fahrenheit.readSensor(millis()));
+  assertUnsignedLongEquals(conversions + 2, chip.conversions());
+  assertTrue(abs(humidity.getFixedValue() - 3500) <= 1);
+  assertTrue(abs(celsius.getFixedValue() - 1900) <= 1);
+
+  // A single value measurement in between starts the acquisition over
+  delay(2000);
+  assertEquals(Sensor::MEASUREMENT_PENDING, sht21.readSensor(millis(), SHT21::Humidity));
+  delay(sht21.conversionTime(true));
+  assertEquals(Sensor::MEASUREMENT_PENDING, celsius.readSensor(millis()));
+  delay(sht21.conversionTime(true));
+  assertEquals(Sensor::MEASUREMENT_PENDING, celsius.readSensor(millis()));
+  delay(sht21.conversionTime(false));
+  assertEquals(Sensor::NO_ERROR, celsius.readSensor(millis()));
+
+  sht21.setAsync(false);
+}
+
+// A read of both values through an adapter records each value in the history of its own channel
+test(history) {
+  SensorHistory<4> humidityHistory(SHT21::Humidity);
+  SensorHistory<4> celsiusHistory(SHT21::TemperatureC);
+
+  sht21.setAsync(false);
+  sht21.attachHistory(&humidityHistory);
+  sht21.attachHistory(&celsiusHistory);
+  chip.setTemperature(22.0);
+  chip.setHumidity(55.0);
+  delay(2000);
+
+  assertEquals(Sensor::NO_ERROR, humidity.readSensor(millis()));
+  assertEquals(1, humidityHistory.count());
+  assertEquals(1, celsiusHistory.count());
+  assertTrue(abs(humidityHistory.last() - 5500) <= 1);
+  assertTrue(abs(celsiusHistory.last() - 2200) <= 1);
+
+  sht21.detachHistory(&humidityHistory);
+  sht21.detachHistory(&celsiusHistory);
+}
@@ -0,0 +1,109 @@
+/*
+ * Tests the measurement state machine of the SHT21 against the simulated sensor, i.e. only runs
+ * on the host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Wire.h>
+#include <Sensor.h>
+#include <SHT21.h>
+#include <SimI2C.h>
+
+TestSuite suite;
+
+SimSHT21 chip;
+SHT21 sht21;
+
+void setup() {
+  Serial.begin(9600);
+  Wire.begin();
+  SimI2CBus::instance.attach(&chip);
+  chip.setTemperature(21.5);
+  chip.setHumidity(40.0);
+  sht21.initialize();
+}
+
+void loop() {
+  suite.run();
+}
+
+test(blocking) {
+  unsigned long start = millis();
+
+  sht21.setAsync(false);
+  chip.setTemperature(25.0);
+  assertEquals(Sensor::NO_ERROR, sht21.readSensor(millis(), SHT21::TemperatureC));
+  assertTrue(fabs(sht21.getTemperature(true) - 25.0) < 0.05);
+
+  // Only the conversion time is spent waiting
+  assertTrue(millis() - start <= (unsigned long)(sht21.conversionTime(false) + 1));
+}
+
+test(async) {
+  unsigned long conversions = chip.conversions();
+  unsigned long transactions;
+  unsigned long start;
+
+  sht21.setAsync(true);
+  chip.setTemperature(18.0);
+
+  start = millis();
+  assertEquals(Sensor::MEASUREMENT_PENDING, sht21.readSensor(millis(), SHT21::TemperatureC));
+  assertTrue(sht21.isMeasuring());
+  assertUnsignedLongEquals(conversions + 1, chip.conversions());
+
+  // The call returns right away and does not poll the bus before the conversion can be done
+  transactions = SimI2CBus::instance.transactions();
+  assertTrue(millis() - start < 2);
+  assertEquals(Sensor::MEASUREMENT_PENDING, sht21.readSensor(millis(), SHT21::TemperatureC));
+  assertUnsignedLongEquals(transactions, SimI2CBus::instance.transactions());
+  assertTrue(!sht21.isMeasurementReady(millis()));
+
+  SimClock::instance.advance(sht21.conversionTime(false) * 1000UL);
+  assertTrue(sht21.isMeasurementReady(millis()));
+  assertEquals(Sensor::NO_ERROR, sht21.readSensor(millis(), SHT21::TemperatureC));
+  assertTrue(!sht21.isMeasuring());
+  assertTrue(fabs(sht21.getTemperature(true) - 18.0) < 0.05);
+}
+
+test(asyncSwitchesValue) {
+  sht21.setAsync(true);
+  chip.setHumidity(65.0);
+
+  // A pending temperature measurement is completed before the humidity measurement starts
+  assertEquals(Sensor::MEASUREMENT_PENDING, sht21.readSensor(millis(), SHT21::TemperatureC));
+  SimClock::instance.advance(sht21.conversionTime(false) * 1000UL);
+  assertEquals(Sensor::MEASUREMENT_PENDING, sht21.readSensor(millis(), SHT21::Humidity));
+  SimClock::instance.advance(sht21.conversionTime(true) * 1000UL);
+  assertEquals(Sensor::NO_ERROR, sht21.readSensor(millis(), SHT21::Humidity));
+  assertTrue(fabs(sht21.getHumidity() - 65.0) < 0.1);
+}
+
+test(resolution) {
+  sht21.setAsync(true);
+  sht21.setResolution(SHT21::RES_11_11);
+  assertEquals(11, sht21.conversionTime(false));
+
+  // The sensor is not ready before its conversion time
+  assertEquals(Sensor::NO_ERROR, sht21.startMeasurement(millis(), SHT21::TemperatureC));
+  SimClock::instance.advance(5000);
+  assertEquals(Sensor::MEASUREMENT_PENDING, sht21.completeMeasurement(millis()));
+  SimClock::instance.advance(6000);
+  assertEquals(Sensor::NO_ERROR, sht21.completeMeasurement(millis()));
+
+  sht21.setResolution(SHT21::RES_12_14);
+}
+
+test(errors) {
+  sht21.setAsync(true);
+  assertEquals(Sensor::FUNCTION_NOT_SUPPORTED, sht21.completeMeasurement(millis()));
+
+  // The sensor is removed during the conversion
+  assertEquals(Sensor::NO_ERROR, sht21.startMeasurement(millis(), SHT21::TemperatureC));
+  chip.setPresent(false);
+  SimClock::instance.advance(sht21.conversionTime(false) * 1000UL);
+  assertEquals(Sensor::MEASUREMENT_PENDING, sht21.completeMeasurement(millis()));
+  SimClock::instance.advance(2000UL * sht21.conversionTime(false));
+  assertEquals(Sensor::DATA_TIMEOUT, sht21.completeMeasurement(millis()));
+  assertEquals(Sensor::SENSOR_NOT_PRESENT, sht21.readSensor(millis(), SHT21::TemperatureC));
+  chip.setPresent(true);
+}
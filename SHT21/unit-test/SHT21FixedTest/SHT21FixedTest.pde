@@ -0,0 +1,80 @@
+/*
+ * Compares the fixed point values of the SHT21 with the float values over the range of the
+ * sensor. Uses the simulated sensor, i.e. only runs on the host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Wire.h>
+#include <Sensor.h>
+#include <SHT21.h>
+#include <SimI2C.h>
+
+TestSuite suite;
+
+SimSHT21 chip;
+SHT21 sht21;
+
+void setup() {
+  Serial.begin(9600);
+  Wire.begin();
+  SimI2CBus::instance.attach(&chip);
+  sht21.initialize();
+}
+
+void loop() {
+  suite.run();
+}
+
+test(fahrenheit) {
+  assertEquals(3200, Sensor::fixedToFahrenheit(0));
+  assertEquals(21200, Sensor::fixedToFahrenheit(10000));
+  assertEquals(-4000, Sensor::fixedToFahrenheit(-4000));
+  // 21.51 C is 70.718 F, -0.01 C is 31.982 F
+  assertEquals(7072, Sensor::fixedToFahrenheit(2151));
+  assertEquals(3198, Sensor::fixedToFahrenheit(-1));
+
+  assertEquals(2, Sensor::fixedDivide(150, 100));
+  assertEquals(-2, Sensor::fixedDivide(-150, 100));
+  assertEquals(-1, Sensor::fixedDivide(-149, 100));
+}
+
+test(temperature) {
+  float maxError = 0;
+  float maxErrorF = 0;
+  float error;
+
+  // Over the whole range, including the 0.01 C steps of the 14 bit resolution
+  for(float t = -40.0; t < 125.0; t += 0.37) {
+    chip.setTemperature(t);
+    assertEquals(Sensor::NO_ERROR, sht21.readSensor(millis(), SHT21::TemperatureC));
+    error = fabs(sht21.getFixedValue(SHT21::TemperatureC) / 100.0 - sht21.getFloatValue(SHT21::TemperatureC));
+    if(error > maxError) {
+      maxError = error;
+    }
+    error = fabs(sht21.getFixedValue(SHT21::TemperatureF) / 100.0 - sht21.getFloatValue(SHT21::TemperatureF));
+    if(error > maxErrorF) {
+      maxErrorF = error;
+    }
+
+    // The integer values are rounded from the hundredths, i.e. differ at most by one at the boundaries
+    assertTrue(abs((int)round(sht21.getFloatValue(SHT21::TemperatureC) * 8) - sht21.getIntegerValue(SHT21::TemperatureC)) <= 1);
+  }
+  // Half a hundredth for rounding; in F the rounding error of the C value is scaled by 1.8 and the
+  // result rounded again
+  assertTrue(maxError <= 0.0051);
+  assertTrue(maxErrorF <= 0.0141);
+}
+
+test(humidity) {
+  float maxError = 0;
+
+  for(float rh = 0.0; rh <= 100.0; rh += 0.23) {
+    chip.setHumidity(rh);
+    assertEquals(Sensor::NO_ERROR, sht21.readSensor(millis(), SHT21::Humidity));
+    float error = fabs(sht21.getFixedValue(SHT21::Humidity) / 100.0 - sht21.getFloatValue(SHT21::Humidity));
+    if(error > maxError) {
+      maxError = error;
+    }
+    assertTrue(abs((int)round(sht21.getFloatValue(SHT21::Humidity)) - sht21.getByteValue(SHT21::Humidity)) <= 1);
+  }
+  assertTrue(maxError <= 0.0051);
+}
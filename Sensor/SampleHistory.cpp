@@ -0,0 +1,127 @@
+/*
+ * SampleHistory.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "SampleHistory.h"
+#include "Sensor.h"
+
+SampleHistory::SampleHistory(int *samples, uint8_t *minQueue, uint8_t *maxQueue, uint8_t capacity, int config) {
+  _samples = samples;
+  _minQueue = minQueue;
+  _maxQueue = maxQueue;
+  _capacity = capacity;
+  _config = config;
+  _shift = 3;
+  _nextHistory = 0;
+  clear();
+}
+
+void SampleHistory::clear() {
+  _head = 0;
+  _count = 0;
+  _minFirst = _minCount = 0;
+  _maxFirst = _maxCount = 0;
+  _sum = 0;
+  _squares = 0;
+  _movingAverage = 0;
+}
+
+void SampleHistory::add(int value) {
+  int last;
+
+  if(_count == _capacity) {
+    // The oldest sample is overwritten, it can only be at the front of the queues
+    int oldest = _samples[_head];
+
+    _sum -= oldest;
+    _squares -= (unsigned long long)((long)oldest * oldest);
+    if(_minCount && (_minQueue[_minFirst] == _head)) {
+      _minFirst = next(_minFirst);
+      _minCount--;
+    }
+    if(_maxCount && (_maxQueue[_maxFirst] == _head)) {
+      _maxFirst = next(_maxFirst);
+      _maxCount--;
+    }
+  }
+  else {
+    _count++;
+  }
+
+  if(_count == 1) {
+    _movingAverage = (long)value << 8;
+  }
+  else {
+    _movingAverage += (((long)value << 8) - _movingAverage) >> _shift;
+  }
+
+  _samples[_head] = value;
+  _sum += value;
+  _squares += (unsigned long long)((long)value * value);
+
+  // Samples that are not smaller (larger) than the new one can never be the minimum (maximum) again
+  while(_minCount) {
+    last = _minFirst + _minCount - 1;
+    if(last >= _capacity) {
+      last -= _capacity;
+    }
+    if(_samples[_minQueue[last]] < value) {
+      break;
+    }
+    _minCount--;
+  }
+  last = _minFirst + _minCount;
+  _minQueue[last >= _capacity ? last - _capacity : last] = _head;
+  _minCount++;
+
+  while(_maxCount) {
+    last = _maxFirst + _maxCount - 1;
+    if(last >= _capacity) {
+      last -= _capacity;
+    }
+    if(_samples[_maxQueue[last]] > value) {
+      break;
+    }
+    _maxCount--;
+  }
+  last = _maxFirst + _maxCount;
+  _maxQueue[last >= _capacity ? last - _capacity : last] = _head;
+  _maxCount++;
+
+  _head = next(_head);
+}
+
+int SampleHistory::sample(uint8_t age) {
+  // The latest sample is the one before the head
+  int index = (int)_head - 1 - age;
+
+  if(age >= _count) {
+    return 0;
+  }
+
+  return _samples[index < 0 ? index + _capacity : index];
+}
+
+int SampleHistory::average() {
+  return _count ? Sensor::fixedDivide(_sum, _count) : 0;
+}
+
+unsigned long SampleHistory::variance() {
+  long long squares;
+
+  if(!_count) {
+    return 0;
+  }
+
+  // n * sum(x^2) - sum(x)^2, divided by n^2
+  squares = (long long)_squares * _count - (long long)_sum * _sum;
+
+  return (unsigned long)((squares + ((long)_count * _count) / 2) / ((long)_count * _count));
+}
+
+int SampleHistory::standardDeviation() {
+  return (int)Sensor::squareRoot(variance());
+}
@@ -0,0 +1,130 @@
+/*
+ * SampleHistory.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef SAMPLEHISTORY_H_
+#define SAMPLEHISTORY_H_
+
+#include <WProgram.h>
+
+class SensorImpl;
+
+/**
+ * The last samples of a sensor value and their statistics. A history is attached to a sensor with
+ * <code>SensorImpl::attachHistory</code> and records the fixed point value (see
+ * <code>Sensor::getFixedValue</code>) of every successful <code>readSensor</code> with its config. The
+ * statistics cover the samples in the history and are updated with each sample, so all of them are
+ * available in constant time:
+ * <ul>
+ *  <li>minimum and maximum - kept in monotonic queues, a new sample removes the samples from the
+ *      queues that it makes irrelevant, and the oldest sample is removed from the front.
+ *  <li>sum, average and variance - kept as sum and sum of squares, the sample that drops out of
+ *      the history is subtracted.
+ *  <li>exponential moving average - over all samples, with a smoothing factor of 1/2^shift.
+ * </ul>
+ * This class does the work, <code>SensorHistory&lt;CAPACITY&gt;</code> provides the memory. A history costs
+ * 4 bytes of RAM per sample.
+ */
+class SampleHistory {
+  public:
+    SampleHistory(int *samples, uint8_t *minQueue, uint8_t *maxQueue, uint8_t capacity, int config = 0);
+
+    /**
+     * Removes all samples.
+     */
+    void clear();
+
+    /**
+     * Adds a sample, if the history is full the oldest sample is dropped.
+     */
+    void add(int value);
+
+    /**
+     * @return the config of the sensor value this history records.
+     */
+    int config() { return _config; };
+
+    uint8_t capacity() { return _capacity; };
+    uint8_t count() { return _count; };
+    bool isFull() { return _count == _capacity; };
+
+    /**
+     * @return the sample with the given age, <code>0</code> is the latest sample.
+     */
+    int sample(uint8_t age);
+    int last() { return sample(0); };
+
+    /**
+     * The statistics of the samples in the history; all return <code>0</code> if the history is empty.
+     */
+    int minimum() { return _count ? _samples[_minQueue[_minFirst]] : 0; };
+    int maximum() { return _count ? _samples[_maxQueue[_maxFirst]] : 0; };
+    long sum() { return _sum; };
+    int average();
+
+    /**
+     * @return the population variance in hundredths squared, i.e. 10000 is a variance of 1.
+     */
+    unsigned long variance();
+
+    /**
+     * @return the standard deviation, in hundredths like the samples.
+     */
+    int standardDeviation();
+
+    /**
+     * @return the exponential moving average of all samples since the last <code>clear</code>.
+     */
+    int movingAverage() { return (int)((_movingAverage + 128) >> 8); };
+
+    /**
+     * Sets the smoothing factor of the moving average to 1/2^shift, the default is 1/8.
+     */
+    void setSmoothing(uint8_t shift) { _shift = shift; };
+
+  private:
+    friend class SensorImpl;
+
+    uint8_t next(uint8_t index) { return index + 1 < _capacity ? index + 1 : 0; };
+    uint8_t previous(uint8_t index) { return index ? index - 1 : _capacity - 1; };
+
+    int *_samples;
+    uint8_t *_minQueue;
+    uint8_t *_maxQueue;
+    uint8_t _capacity;
+    int _config;
+
+    uint8_t _head;
+    uint8_t _count;
+    uint8_t _minFirst;
+    uint8_t _minCount;
+    uint8_t _maxFirst;
+    uint8_t _maxCount;
+
+    long _sum;
+    unsigned long long _squares;
+    long _movingAverage;    // times 256
+    uint8_t _shift;
+
+    // The histories attached to the same sensor
+    SampleHistory *_nextHistory;
+};
+
+/**
+ * A <code>SampleHistory</code> with room for <code>CAPACITY</code> samples (at most 255).
+ */
+template <uint8_t CAPACITY>
+class SensorHistory: public SampleHistory {
+  public:
+    SensorHistory(int config = 0) : SampleHistory(_buffer, _minBuffer, _maxBuffer, CAPACITY, config) {};
+
+  private:
+    int _buffer[CAPACITY];
+    uint8_t _minBuffer[CAPACITY];
+    uint8_t _maxBuffer[CAPACITY];
+};
+
+#endif /* SAMPLEHISTORY_H_ */
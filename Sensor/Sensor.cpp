@@ -6,14 +6,18 @@
  */
 
 #include "Sensor.h"
+#include "SensorHealth.h"
 
 SensorImpl::SensorImpl() {
+  _histories = 0;
+  _health = 0;
   initialize();
 }
 
 Sensor::Error SensorImpl::initialize() {
   _lastReadTime = 0;
   _sampling = false;
+  _acquired = false;
 
   return NO_ERROR;
 }
@@ -49,13 +53,79 @@ Sensor::Error SensorImpl::endSampling() {
 Sensor::Error SensorImpl::reset() {
   _sampling = false;
   _lastReadTime = 0;
+  _acquired = false;
 
   return NO_ERROR;
 }
 
+void SensorImpl::attachHistory(SampleHistory *history) {
+  history->_nextHistory = _histories;
+  _histories = history;
+}
+
+void SensorImpl::detachHistory(SampleHistory *history) {
+  SampleHistory **link = &_histories;
+
+  while(*link) {
+    if(*link == history) {
+      *link = history->_nextHistory;
+      history->_nextHistory = 0;
+      return;
+    }
+    link = &(*link)->_nextHistory;
+  }
+}
+
+void SensorImpl::record(int config) {
+  for(SampleHistory *history = _histories; history; history = history->_nextHistory) {
+    // A read of all channels gives every history the value of its own channel
+    if(config == ALL_CHANNELS) {
+      history->add(getFixedValue(history->config()));
+    }
+    else if(history->config() == config) {
+      history->add(getFixedValue(config));
+    }
+  }
+}
+
+void SensorImpl::recordHealth(Sensor::Error err, unsigned long timeInMillis, unsigned long latencyMicros) {
+  _health->record(err, timeInMillis, latencyMicros);
+}
+
+int Sensor::fixedDivide(long value, int divisor) {
+  // Integer division truncates towards zero, so half the divisor is added away from zero
+  if(value < 0) {
+    return (int)((value - divisor / 2) / divisor);
+  }
+  return (int)((value + divisor / 2) / divisor);
+}
+
+unsigned int Sensor::squareRoot(unsigned long value) {
+  unsigned long root = 0;
+  unsigned long bit = 1UL << 30;
+
+  // Bit by bit, from the highest power of four that is not larger than the value
+  while(bit > value) {
+    bit >>= 2;
+  }
+  while(bit) {
+    if(value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return (unsigned int)root;
+}
+
 // ---- SensorAdaptor ------
-SensorAdapter::SensorAdapter(Sensor *sensor, int config) {
+SensorAdapter::SensorAdapter(Sensor *sensor, int config, unsigned long maxAge) {
   _sensor = sensor;
   _config = config;
+  _maxAge = maxAge;
 };
 
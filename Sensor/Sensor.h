@@ -9,8 +9,11 @@
 #define SENSOR_H_
 
 #include <WProgram.h>
+#include "SampleHistory.h"
 
-// TODO: try this a template and see the implications
+class SensorHealth;
+
+// See StaticSensor.h for a variant that resolves the calls at compile time
 
 class Sensor {
   public:
@@ -24,12 +27,13 @@ class Sensor {
                  TOO_QUICK,
                  CHECKSUM_ERROR,
                  BUS_ERROR,
+                 MEASUREMENT_PENDING,
                };
 
     virtual Sensor::Error initialize() = 0;
     virtual Sensor::Error reset() = 0;
 
-    Sensor::Error readSensor(int config = 0) { return readSensor(millis()); };
+    Sensor::Error readSensor(int config = 0) { return readSensor(millis(), config); };
     virtual Sensor::Error readSensor(unsigned long timeInMillis, int config = 0) = 0;
 
     /**
@@ -104,6 +108,21 @@ class Sensor {
      */
     virtual float getFloatValue(int config = 0)  = 0;
 
+    /**
+     * Returns the last value read by this sensor as fixed point number, i.e. in hundredths of the unit of
+     * <code>getFloatValue</code>: 2150 is 21.50 C, -1234 is -12.34 A. Sensors compute the value once per
+     * reading with integer arithmetic, so control loops that only use fixed point values do not spend
+     * the time of the software floating point emulation of the ATmega.
+     *
+     * param[in] config a configuration value that can be passed to the sensor. The value is sensor specific and might
+     *                  be ignored.
+     *
+     * @return the value of this sensor in hundredths of the unit of <code>getFloatValue</code>.
+     *
+     * Sensor::getFloatValue(int), Sensor::fixedToFahrenheit(int)
+     */
+    virtual int getFixedValue(int config = 0) = 0;
+
     // Sampling, only relevant if there is energy management involved, i.e. sensor is turn on and off
     virtual Sensor::Error beginSampling() = 0;
     virtual Sensor::Error endSampling() = 0;
@@ -114,6 +133,38 @@ class Sensor {
     virtual void clockReset(unsigned long timeInMillis) = 0;
 
     virtual unsigned long lastReadTime() = 0;
+
+    /**
+     * The config of <code>readSensor</code> that reads all values of a sensor with several values, e.g.
+     * humidity and temperature, in one go. Sensors that do not support it return <code>UNKNOWN_CONFIG</code>
+     * or <code>FUNCTION_NOT_SUPPORTED</code>.
+     */
+    static const int ALL_CHANNELS = -1;
+
+    /**
+     * @return <code>true</code> if all values were read with <code>ALL_CHANNELS</code> less than
+     *         <code>maxAge</code> ms before <code>timeInMillis</code>.
+     */
+    virtual bool isAcquired(unsigned long timeInMillis, unsigned long maxAge) = 0;
+
+    // Fixed point values are in hundredths of the unit
+    static const int FIXED_SCALE = 100;
+
+    /**
+     * Converts a fixed point temperature from Celsius to Fahrenheit.
+     */
+    static int fixedToFahrenheit(int celsius) { return fixedDivide((long)celsius * 9, 5) + 3200; };
+
+    /**
+     * Divides <code>value</code> by <code>divisor</code> and rounds the result half away from zero, like
+     * <code>round</code> does for floats.
+     */
+    static int fixedDivide(long value, int divisor);
+
+    /**
+     * @return the integer square root of <code>value</code>, rounded down.
+     */
+    static unsigned int squareRoot(unsigned long value);
 };
 
 class SensorImpl: public Sensor  {
@@ -123,12 +174,59 @@ class SensorImpl: public Sensor  {
     virtual Sensor::Error initialize();
     virtual Sensor::Error reset();
 
-    Sensor::Error readSensor(unsigned long timeInMillis, int config = 0) { return readSensorImpl(timeInMillis); };
+    Sensor::Error readSensor(unsigned long timeInMillis, int config = 0) {
+      Sensor::Error err;
+      unsigned long start;
+
+      _reused = false;
+      if(_health) {
+        start = micros();
+        err = readSensorImpl(timeInMillis, config);
+        if(!_reused) {
+          recordHealth(err, timeInMillis, micros() - start);
+        }
+      }
+      else {
+        err = readSensorImpl(timeInMillis, config);
+      }
+
+      // Values of an earlier reading were recorded when they were read
+      if((err == NO_ERROR) && !_reused) {
+        if(config == ALL_CHANNELS) {
+          _acquired = true;
+          _acquiredAt = timeInMillis;
+        }
+        if(_histories) {
+          record(config);
+        }
+      }
+      return err;
+    };
+
+    bool isAcquired(unsigned long timeInMillis, unsigned long maxAge) {
+      return _acquired && (timeInMillis - _acquiredAt < maxAge);
+    };
+
+    /**
+     * Attaches a history, which from now on records the fixed point value of every successful
+     * <code>readSensor</code> with the config of the history. Several histories can be attached, e.g. one
+     * for each value of a sensor.
+     */
+    void attachHistory(SampleHistory *history);
+    void detachHistory(SampleHistory *history);
+
+    /**
+     * Attaches a health record, which from now on counts the results and the time of every
+     * <code>readSensor</code>, see <code>SensorHealth</code>. <code>0</code> detaches it.
+     */
+    void attachHealth(SensorHealth *health) { _health = health; };
+    SensorHealth *health() { return _health; };
 
     // Default implementations
     virtual int getIntegerValue(int config = 0) { return 0; };
     virtual byte getByteValue(int config = 0) { return 0; };
     virtual float getFloatValue(int config = 0) { return 0; };
+    virtual int getFixedValue(int config = 0) { return 0; };
 
     // Sampling, only relevant if there is energy management involved, i.e. sensor is turn on and off
     Sensor::Error beginSampling();
@@ -146,19 +244,44 @@ class SensorImpl: public Sensor  {
     virtual Sensor::Error endSamplingImpl() { return NO_ERROR; };
     virtual Sensor::Error readSensorImpl(unsigned long timeInMillis, int config = 0) { return FUNCTION_NOT_SUPPORTED; };
 
+    /**
+     * Called by <code>readSensorImpl</code> when it returns the values of an earlier reading rather than
+     * reading the sensor. The read is then neither recorded in the histories nor in the health record.
+     */
+    void reuseValues() { _reused = true; };
+
   private:
+    void record(int config);
+    void recordHealth(Sensor::Error err, unsigned long timeInMillis, unsigned long latencyMicros);
+
     unsigned long _lastReadTime;
     bool _sampling;
+    bool _acquired;
+    unsigned long _acquiredAt;
+    bool _reused;
+    SampleHistory *_histories;
+    SensorHealth *_health;
 };
 
 class SensorAdapter:public Sensor {
   public:
-    SensorAdapter(Sensor *sensor, int config);
+    /**
+     * @param[in] sensor the sensor this adapter provides one value of.
+     * @param[in] config the config of the value.
+     * @param[in] maxAge if not <code>0</code>, <code>readSensor</code> reads all values of the sensor
+     *            (<code>ALL_CHANNELS</code>), unless they were read less than <code>maxAge</code> ms ago.
+     *            In that way the adapters of one sensor share a reading, e.g. the humidity and the
+     *            temperature adapter of a SHT21 read both values once per <code>maxAge</code>.
+     */
+    SensorAdapter(Sensor *sensor, int config, unsigned long maxAge = 0);
 
     Sensor::Error initialize() { return _sensor->initialize(); };
     Sensor::Error reset()  { return _sensor->initialize(); };
 
     Sensor::Error readSensor(unsigned long timeInMillis, int config = 0) {
+      if(_maxAge && !config) {
+        return _sensor->isAcquired(timeInMillis, _maxAge) ? NO_ERROR : _sensor->readSensor(timeInMillis, ALL_CHANNELS);
+      }
       return _sensor->readSensor(timeInMillis, config ? config :_config);
     };
 
@@ -228,6 +351,14 @@ class SensorAdapter:public Sensor {
      */
     float getFloatValue(int config = 0) { return _sensor->getFloatValue(config ? config :_config); };
 
+    /**
+     * Returns the last fixed point value read by the sensor of this adapter, see <code>getIntegerValue</code>
+     * for how <code>config</code> is handled.
+     *
+     * @see Sensor::getFixedValue(int)
+     */
+    int getFixedValue(int config = 0) { return _sensor->getFixedValue(config ? config :_config); };
+
     // Sampling, only relevant if there is energy management involved, i.e. sensor is turn on and off
     Sensor::Error beginSampling() { return _sensor->beginSampling(); };
     Sensor::Error endSampling() { return _sensor->endSampling(); };
@@ -237,9 +368,14 @@ class SensorAdapter:public Sensor {
     void clockReset(unsigned long timeInMillis) {  _sensor->clockReset(); };
     unsigned long lastReadTime() { return _sensor->lastReadTime(); };
 
+    bool isAcquired(unsigned long timeInMillis, unsigned long maxAge) {
+      return _sensor->isAcquired(timeInMillis, maxAge);
+    };
+
   private:
     Sensor* _sensor;
     int _config;
+    unsigned long _maxAge;
 };
 
 #endif /* SENSOR_H_ */
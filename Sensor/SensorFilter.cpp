@@ -0,0 +1,161 @@
+/*
+ * SensorFilter.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "SensorFilter.h"
+
+SensorFilter::SensorFilter(Sensor *source, int config) {
+  _source = source;
+  _config = config;
+  _value = 0;
+}
+
+Sensor::Error SensorFilter::initialize() {
+  SensorImpl::initialize();
+  _value = 0;
+  clear();
+
+  return _source->initialize();
+}
+
+Sensor::Error SensorFilter::reset() {
+  SensorImpl::reset();
+  _value = 0;
+  clear();
+
+  return _source->reset();
+}
+
+Sensor::Error SensorFilter::readSensorImpl(unsigned long timeInMillis, int config) {
+  Sensor::Error err;
+
+  config = config ? config : _config;
+  err = _source->readSensor(timeInMillis, config);
+  if(err != NO_ERROR) {
+    return err;
+  }
+
+  return filter(_source->getFixedValue(config)) ? NO_ERROR : MEASUREMENT_PENDING;
+}
+
+// ---- WindowFilter ------
+WindowFilter::WindowFilter(Sensor *source, int *window, int *sorted, uint8_t size, int config)
+  : SensorFilter(source, config) {
+  _window = window;
+  _sorted = sorted;
+  _size = size;
+  clear();
+}
+
+void WindowFilter::add(int value) {
+  uint8_t i;
+
+  if(_count == _size) {
+    // Remove the oldest value from the sorted values
+    int oldest = _window[_next];
+
+    for(i = 0; _sorted[i] != oldest; i++);
+    for(; i < _count - 1; i++) {
+      _sorted[i] = _sorted[i + 1];
+    }
+    _count--;
+  }
+
+  // Insert the new value
+  for(i = _count; (i > 0) && (_sorted[i - 1] > value); i--) {
+    _sorted[i] = _sorted[i - 1];
+  }
+  _sorted[i] = value;
+  _count++;
+
+  _window[_next] = value;
+  _next = _next + 1 < _size ? _next + 1 : 0;
+}
+
+int WindowFilter::medianDeviation() {
+  int center = median();
+  int8_t below = (_count - 1) / 2;
+  uint8_t above = below + 1;
+  unsigned int deviation = 0;
+
+  // The deviations below and above the median are sorted already, so the median of the deviations
+  // is found by merging both sides up to the middle
+  for(uint8_t i = 0; i <= (_count - 1) / 2; i++) {
+    unsigned int down = below >= 0 ? (unsigned int)((long)center - _sorted[below]) : 0xffff;
+    unsigned int up = above < _count ? (unsigned int)((long)_sorted[above] - center) : 0xffff;
+
+    if(down <= up) {
+      deviation = down;
+      below--;
+    }
+    else {
+      deviation = up;
+      above++;
+    }
+  }
+
+  return deviation > 0x7fff ? 0x7fff : (int)deviation;
+}
+
+// ---- DeltaFilter ------
+DeltaFilter::DeltaFilter(Sensor *source, int maxDelta, uint8_t maxRejects, int config)
+  : SensorFilter(source, config) {
+  _maxDelta = maxDelta;
+  _maxRejects = maxRejects;
+  _rejects = 0;
+  clear();
+}
+
+bool DeltaFilter::filter(int value) {
+  if(_valid && (labs((long)value - _value) > _maxDelta) && (_rejectsInRow < _maxRejects)) {
+    _rejectsInRow++;
+    _rejects++;
+    return true;
+  }
+
+  _rejectsInRow = 0;
+  _valid = true;
+  _value = value;
+  return true;
+}
+
+// ---- EmaFilter ------
+EmaFilter::EmaFilter(Sensor *source, uint8_t shift, int config)
+  : SensorFilter(source, config) {
+  _shift = shift;
+  clear();
+}
+
+bool EmaFilter::filter(int value) {
+  if(!_valid) {
+    _average = (long)value << 8;
+    _valid = true;
+  }
+  else {
+    _average += (((long)value << 8) - _average) >> _shift;
+  }
+  _value = (int)((_average + 128) >> 8);
+
+  return true;
+}
+
+// ---- DecimationFilter ------
+DecimationFilter::DecimationFilter(Sensor *source, uint8_t factor, int config)
+  : SensorFilter(source, config) {
+  _factor = factor;
+  clear();
+}
+
+bool DecimationFilter::filter(int value) {
+  _sum += value;
+  if(++_count < _factor) {
+    return false;
+  }
+
+  _value = fixedDivide(_sum, _count);
+  clear();
+  return true;
+}
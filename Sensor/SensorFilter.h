@@ -0,0 +1,213 @@
+/*
+ * SensorFilter.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef SENSORFILTER_H_
+#define SENSORFILTER_H_
+
+#include "Sensor.h"
+
+/**
+ * Base class of the filter stages. A filter reads another sensor (the source) and filters the fixed
+ * point values of the readings (see <code>Sensor::getFixedValue</code>) with integer arithmetic. A filter
+ * is a sensor itself, so filters can be chained, read by the <code>SensorScheduler</code> and record
+ * into a <code>SampleHistory</code>:
+ * <pre>
+ *   ACS712 acs712;
+ *   HampelFilter&lt;5&gt; spikes(&amp;acs712);
+ *   EmaFilter current(&amp;spikes, 2);
+ * </pre>
+ * Each stage costs constant time per reading. The filtered value is returned by <code>getFixedValue</code>,
+ * by <code>getFloatValue</code> in the unit of the source and by <code>getIntegerValue</code> and
+ * <code>getByteValue</code> rounded to whole units. A filter that needs more readings before it has a new
+ * value, e.g. the <code>DecimationFilter</code>, returns <code>MEASUREMENT_PENDING</code>.
+ */
+class SensorFilter: public SensorImpl {
+  public:
+    /**
+     * @param[in] source the sensor to filter.
+     * @param[in] config the config the source is read with, if <code>readSensor</code> is called
+     *                   without a config.
+     */
+    SensorFilter(Sensor *source, int config = 0);
+
+    Sensor::Error initialize();
+    Sensor::Error reset();
+
+    int getIntegerValue(int config = 0) { return fixedDivide(_value, FIXED_SCALE); };
+    byte getByteValue(int config = 0) { return (byte)fixedDivide(_value, FIXED_SCALE); };
+    float getFloatValue(int config = 0) { return _value / (float)FIXED_SCALE; };
+    int getFixedValue(int config = 0) { return _value; };
+
+    Sensor *source() { return _source; };
+
+  protected:
+    Sensor::Error beginSamplingImpl() { return _source->beginSampling(); };
+    Sensor::Error endSamplingImpl() { return _source->endSampling(); };
+    Sensor::Error readSensorImpl(unsigned long timeInMillis, int config = 0);
+
+    /**
+     * Filters the next value of the source and stores the result in <code>_value</code>.
+     *
+     * @return <code>true</code> if there is a new filtered value;<code>false</code> if the filter needs
+     *         more values.
+     */
+    virtual bool filter(int value) = 0;
+
+    /**
+     * Forgets all values, called by <code>initialize</code> and <code>reset</code>.
+     */
+    virtual void clear() = 0;
+
+    int _value;
+
+  private:
+    Sensor *_source;
+    int _config;
+};
+
+/**
+ * Base class of the filters over a window of the last values. Keeps the values in the order they
+ * were read and sorted, so the median is available right away. A new value replaces the oldest,
+ * which costs time linear in the size of the window.
+ */
+class WindowFilter: public SensorFilter {
+  public:
+    WindowFilter(Sensor *source, int *window, int *sorted, uint8_t size, int config = 0);
+
+    uint8_t count() { return _count; };
+
+  protected:
+    void clear() { _count = 0; _next = 0; };
+
+    void add(int value);
+
+    /**
+     * @return the median of the values in the window, the lower one if the count is even.
+     */
+    int median() { return _sorted[(_count - 1) / 2]; };
+
+    /**
+     * @return the median absolute deviation of the values in the window from their median.
+     */
+    int medianDeviation();
+
+  private:
+    int *_window;
+    int *_sorted;
+    uint8_t _size;
+    uint8_t _count;
+    uint8_t _next;
+};
+
+/**
+ * Median of the last <code>SIZE</code> values. Removes spikes that are shorter than half the window.
+ */
+template <uint8_t SIZE>
+class MedianFilter: public WindowFilter {
+  public:
+    MedianFilter(Sensor *source, int config = 0) : WindowFilter(source, _buffer, _sortedBuffer, SIZE, config) {};
+
+  protected:
+    bool filter(int value) {
+      add(value);
+      _value = median();
+      return true;
+    };
+
+  private:
+    int _buffer[SIZE];
+    int _sortedBuffer[SIZE];
+};
+
+/**
+ * Hampel filter: a value that is more than <code>k</code> standard deviations away from the median of
+ * the last <code>SIZE</code> values is replaced by the median; other values pass unchanged. The standard
+ * deviation is estimated robustly as 1.5 times the median absolute deviation.
+ */
+template <uint8_t SIZE>
+class HampelFilter: public WindowFilter {
+  public:
+    HampelFilter(Sensor *source, uint8_t k = 3, int config = 0)
+      : WindowFilter(source, _buffer, _sortedBuffer, SIZE, config) { _k = k; };
+
+  protected:
+    bool filter(int value) {
+      int center;
+      long limit;
+
+      add(value);
+      center = median();
+      limit = (long)medianDeviation() * _k * 3 / 2;
+      _value = labs((long)value - center) > limit ? center : value;
+      return true;
+    };
+
+  private:
+    uint8_t _k;
+    int _buffer[SIZE];
+    int _sortedBuffer[SIZE];
+};
+
+/**
+ * Rejects a value that differs more than <code>maxDelta</code> from the last accepted value and
+ * keeps the last accepted value instead. After <code>maxRejects</code> rejections in a row the value
+ * is accepted, so the filter follows a real step of the signal.
+ */
+class DeltaFilter: public SensorFilter {
+  public:
+    DeltaFilter(Sensor *source, int maxDelta, uint8_t maxRejects = 3, int config = 0);
+
+    unsigned long rejects() { return _rejects; };
+
+  protected:
+    bool filter(int value);
+    void clear() { _valid = false; _rejectsInRow = 0; };
+
+  private:
+    int _maxDelta;
+    uint8_t _maxRejects;
+    uint8_t _rejectsInRow;
+    bool _valid;
+    unsigned long _rejects;
+};
+
+/**
+ * Exponential moving average with the smoothing factor 1/2^shift.
+ */
+class EmaFilter: public SensorFilter {
+  public:
+    EmaFilter(Sensor *source, uint8_t shift, int config = 0);
+
+  protected:
+    bool filter(int value);
+    void clear() { _valid = false; };
+
+  private:
+    long _average;    // times 256
+    uint8_t _shift;
+    bool _valid;
+};
+
+/**
+ * Averages <code>factor</code> values of the source to one value, i.e. reduces the rate of the readings.
+ * <code>readSensor</code> returns <code>MEASUREMENT_PENDING</code> until <code>factor</code> values were read.
+ */
+class DecimationFilter: public SensorFilter {
+  public:
+    DecimationFilter(Sensor *source, uint8_t factor, int config = 0);
+
+  protected:
+    bool filter(int value);
+    void clear() { _sum = 0; _count = 0; };
+
+  private:
+    long _sum;
+    uint8_t _factor;
+    uint8_t _count;
+};
+
+#endif /* SENSORFILTER_H_ */
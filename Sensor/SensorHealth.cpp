@@ -0,0 +1,130 @@
+/*
+ * SensorHealth.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "SensorHealth.h"
+
+SensorHealth::SensorHealth() {
+  clear();
+}
+
+void SensorHealth::clear() {
+  _successes = 0;
+  for(uint8_t i = 0; i < ERROR_KINDS; i++) {
+    _errors[i] = 0;
+  }
+  _consecutiveFailures = 0;
+  _lastError = Sensor::NO_ERROR;
+  _lastGoodTime = 0;
+  _minLatency = 0;
+  _maxLatency = 0;
+  _latencySum = 0;
+  _latencyCount = 0;
+}
+
+void SensorHealth::record(Sensor::Error err, unsigned long timeInMillis, unsigned long latencyMicros) {
+  if(err == Sensor::NO_ERROR) {
+    _successes++;
+    _consecutiveFailures = 0;
+    _lastGoodTime = timeInMillis;
+  }
+  else if((err <= ERROR_KINDS) && (_errors[err - 1] < 0xffff)) {
+    _errors[err - 1]++;
+  }
+  if((err != Sensor::NO_ERROR) && (err != Sensor::MEASUREMENT_PENDING)) {
+    _lastError = err;
+    if(_consecutiveFailures < 0xffff) {
+      _consecutiveFailures++;
+    }
+  }
+
+  if(!_latencyCount || (latencyMicros < _minLatency)) {
+    _minLatency = latencyMicros;
+  }
+  if(latencyMicros > _maxLatency) {
+    _maxLatency = latencyMicros;
+  }
+  // Halving sum and count keeps the mean, so the sum never overflows
+  if(_latencySum > 0xffffffffUL - latencyMicros) {
+    _latencySum >>= 1;
+    _latencyCount >>= 1;
+  }
+  _latencySum += latencyMicros;
+  _latencyCount++;
+}
+
+unsigned long SensorHealth::reads() {
+  unsigned long count = _successes;
+
+  for(uint8_t i = 0; i < ERROR_KINDS; i++) {
+    count += _errors[i];
+  }
+  return count;
+}
+
+unsigned int SensorHealth::errors(Sensor::Error err) {
+  if((err == Sensor::NO_ERROR) || (err > ERROR_KINDS)) {
+    return 0;
+  }
+  return _errors[err - 1];
+}
+
+unsigned long SensorHealth::failures() {
+  return reads() - _successes - _errors[Sensor::MEASUREMENT_PENDING - 1];
+}
+
+unsigned long SensorHealth::meanLatency() {
+  return _latencyCount ? (_latencySum + _latencyCount / 2) / _latencyCount : 0;
+}
+
+static uint8_t *dumpLong(uint8_t *buffer, unsigned long value) {
+  for(uint8_t i = 0; i < 4; i++) {
+    *buffer++ = value & 0xff;
+    value >>= 8;
+  }
+  return buffer;
+}
+
+static uint8_t *dumpInt(uint8_t *buffer, uint16_t value) {
+  *buffer++ = value & 0xff;
+  *buffer++ = value >> 8;
+  return buffer;
+}
+
+void SensorHealth::dump(uint8_t *buffer) {
+  buffer = dumpLong(buffer, _successes);
+  for(uint8_t i = 0; i < ERROR_KINDS; i++) {
+    buffer = dumpInt(buffer, _errors[i]);
+  }
+  buffer = dumpInt(buffer, _consecutiveFailures);
+  buffer = dumpLong(buffer, _lastGoodTime);
+  buffer = dumpLong(buffer, minLatency());
+  buffer = dumpLong(buffer, _maxLatency);
+  dumpLong(buffer, meanLatency());
+}
+
+void SensorHealth::printDebug() {
+  Serial.print("ok:");
+  Serial.print(_successes);
+  for(uint8_t i = 0; i < ERROR_KINDS; i++) {
+    if(_errors[i]) {
+      Serial.print(" e");
+      Serial.print((int)(i + 1));
+      Serial.print(":");
+      Serial.print((unsigned int)_errors[i]);
+    }
+  }
+  Serial.print(" run:");
+  Serial.print((unsigned int)_consecutiveFailures);
+  Serial.print(" good:");
+  Serial.print(_lastGoodTime);
+  Serial.print(" us:");
+  Serial.print(minLatency());
+  Serial.print("/");
+  Serial.print(_maxLatency);
+  Serial.print("/");
+  Serial.println(meanLatency());
+}
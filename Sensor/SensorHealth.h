@@ -0,0 +1,91 @@
+/*
+ * SensorHealth.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef SENSORHEALTH_H_
+#define SENSORHEALTH_H_
+
+#include <WProgram.h>
+#include "Sensor.h"
+
+/**
+ * Counters about the readings of a sensor, to find slow or flaky sensors in the field. A health record is
+ * attached to a sensor with <code>SensorImpl::attachHealth</code> and from then on counts every
+ * <code>readSensor</code>:
+ * <ul>
+ *  <li>successful readings and each kind of error, <code>MEASUREMENT_PENDING</code> included,
+ *  <li>failures in a row, i.e. errors since the last successful reading (pending readings do not count),
+ *  <li>the time of the last successful reading,
+ *  <li>minimum, maximum and mean of the time spent in the driver, in us.
+ * </ul>
+ * The error counters stop at 65535. The record costs 47 bytes of RAM; sensors without one only pay for the
+ * pointer and do not measure the time.
+ */
+class SensorHealth {
+  public:
+    // Size of the record written by dump
+    static const uint8_t DUMP_SIZE = 42;
+
+    SensorHealth();
+
+    void clear();
+
+    /**
+     * Counts a reading, called by the sensor.
+     */
+    void record(Sensor::Error err, unsigned long timeInMillis, unsigned long latencyMicros);
+
+    unsigned long reads();
+    unsigned long successes() { return _successes; };
+    unsigned int errors(Sensor::Error err);
+
+    /**
+     * @return the number of errors, without <code>MEASUREMENT_PENDING</code>.
+     */
+    unsigned long failures();
+
+    unsigned int consecutiveFailures() { return _consecutiveFailures; };
+    Sensor::Error lastError() { return (Sensor::Error)_lastError; };
+
+    /**
+     * @return the time of the last successful reading, only valid if there was one.
+     */
+    unsigned long lastGoodTime() { return _lastGoodTime; };
+
+    unsigned long minLatency() { return _latencyCount ? _minLatency : 0; };
+    unsigned long maxLatency() { return _maxLatency; };
+    unsigned long meanLatency();
+
+    /**
+     * Writes the counters in <code>DUMP_SIZE</code> bytes, little endian: successes (4), the error
+     * counters in the order of <code>Sensor::Error</code> starting with <code>FUNCTION_NOT_SUPPORTED</code>
+     * (2 each), failures in a row (2), time of the last good reading (4), minimum, maximum and mean
+     * latency (4 each).
+     */
+    void dump(uint8_t *buffer);
+
+    /**
+     * Prints the counters in one line, e.g. <code>ok:120 e8:2 e10:30 run:0 good:61234 us:110/85010/2310</code>,
+     * errors that did not happen are left out.
+     */
+    void printDebug();
+
+  private:
+    // The errors 1 ... ERROR_KINDS are counted, an integer so it compares with Sensor::Error without a warning
+    static const uint8_t ERROR_KINDS = Sensor::MEASUREMENT_PENDING;
+
+    unsigned long _successes;
+    uint16_t _errors[ERROR_KINDS];
+    uint16_t _consecutiveFailures;
+    uint8_t _lastError;
+    unsigned long _lastGoodTime;
+    unsigned long _minLatency;
+    unsigned long _maxLatency;
+    unsigned long _latencySum;
+    unsigned long _latencyCount;
+};
+
+#endif /* SENSORHEALTH_H_ */
@@ -0,0 +1,169 @@
+/*
+ * SensorScheduler.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "SensorScheduler.h"
+
+// True if time a is at or after time b, also across the rollover of millis()
+#define REACHED(a, b) ((long)((a) - (b)) >= 0)
+
+SensorScheduler::SensorScheduler() {
+  _size = 0;
+  _handler = 0;
+  resetStatistics();
+}
+
+int8_t SensorScheduler::add(Sensor *sensor, unsigned long period, unsigned long deadline, unsigned long warmUp,
+                            int config, unsigned long timeInMillis) {
+  Task *task;
+
+  // A task without a period would be due forever
+  if((_size >= SENSORSCHEDULER_MAX_TASKS) || (period == 0)) {
+    return -1;
+  }
+
+  task = &_tasks[_size];
+  task->sensor = sensor;
+  task->config = config;
+  task->period = period;
+  task->deadline = deadline ? deadline : period;
+  task->warmUp = warmUp;
+  task->release = timeInMillis;
+  task->phase = IDLE;
+  task->lastError = Sensor::NO_ERROR;
+  task->reads = 0;
+  task->misses = 0;
+  task->maxLatency = 0;
+
+  return _size++;
+}
+
+void SensorScheduler::run(unsigned long timeInMillis) {
+  bool stepped[SENSORSCHEDULER_MAX_TASKS];
+  int8_t next;
+  uint8_t i;
+
+  if(_loops > 0 && (timeInMillis - _lastRun > _maxLoopGap)) {
+    _maxLoopGap = timeInMillis - _lastRun;
+  }
+  _lastRun = timeInMillis;
+  _loops++;
+
+  for(i = 0; i < _size; i++) {
+    stepped[i] = false;
+  }
+
+  // Earliest deadline first, each task makes one step
+  do {
+    next = -1;
+    for(i = 0; i < _size; i++) {
+      if(!stepped[i] && isDue(_tasks[i], timeInMillis) &&
+         ((next < 0) || !REACHED(_tasks[i].release + _tasks[i].deadline, _tasks[next].release + _tasks[next].deadline))) {
+        next = i;
+      }
+    }
+    if(next >= 0) {
+      stepped[next] = true;
+      step(next, timeInMillis);
+    }
+  } while(next >= 0);
+}
+
+unsigned long SensorScheduler::timeToNextEvent(unsigned long timeInMillis) {
+  unsigned long next = 0xffffffffUL;
+  unsigned long event;
+
+  for(uint8_t i = 0; i < _size; i++) {
+    if(isDue(_tasks[i], timeInMillis)) {
+      return 0;
+    }
+    event = _tasks[i].release - (_tasks[i].phase == IDLE ? _tasks[i].warmUp : 0) - timeInMillis;
+    if(event < next) {
+      next = event;
+    }
+  }
+
+  return next;
+}
+
+void SensorScheduler::resetStatistics() {
+  for(uint8_t i = 0; i < _size; i++) {
+    _tasks[i].reads = 0;
+    _tasks[i].misses = 0;
+    _tasks[i].maxLatency = 0;
+  }
+  _maxLoopGap = 0;
+  _loops = 0;
+  _lastRun = 0;
+}
+
+// ------------------------------------------------------
+// Private methods
+//
+
+bool SensorScheduler::isDue(Task &task, unsigned long timeInMillis) {
+  switch(task.phase) {
+    case IDLE:
+      return REACHED(timeInMillis, task.release - task.warmUp);
+    case SAMPLING:
+      return REACHED(timeInMillis, task.release);
+    default:
+      // Polled until the reading is complete
+      return true;
+  }
+}
+
+void SensorScheduler::step(uint8_t index, unsigned long timeInMillis) {
+  Task &task = _tasks[index];
+  Sensor::Error err;
+
+  if(task.phase == IDLE) {
+    err = task.sensor->beginSampling();
+    if(err != Sensor::NO_ERROR) {
+      finish(index, err, timeInMillis);
+      return;
+    }
+    task.phase = SAMPLING;
+    if(!REACHED(timeInMillis, task.release)) {
+      return;
+    }
+  }
+
+  task.phase = READING;
+  err = task.sensor->readSensor(timeInMillis, task.config);
+  if(err != Sensor::MEASUREMENT_PENDING) {
+    finish(index, err, timeInMillis);
+  }
+}
+
+void SensorScheduler::finish(uint8_t index, Sensor::Error err, unsigned long timeInMillis) {
+  Task &task = _tasks[index];
+  unsigned long latency = timeInMillis - task.release;
+
+  task.sensor->endSampling();
+  task.phase = IDLE;
+  task.lastError = err;
+  task.reads++;
+
+  if(latency > task.maxLatency) {
+    task.maxLatency = latency;
+  }
+  if(latency > task.deadline) {
+    task.misses++;
+  }
+
+  // Skip the periods that were missed completely, all at once after a long stall or sleep
+  task.release += task.period;
+  if(REACHED(timeInMillis, task.release + task.period)) {
+    unsigned long skipped = (timeInMillis - task.release) / task.period;
+    task.release += skipped * task.period;
+    task.misses += skipped;
+  }
+
+  if(_handler) {
+    _handler(index, err);
+  }
+}
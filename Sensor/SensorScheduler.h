@@ -0,0 +1,116 @@
+/*
+ * SensorScheduler.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef SENSORSCHEDULER_H_
+#define SENSORSCHEDULER_H_
+
+#include "Sensor.h"
+
+#ifndef SENSORSCHEDULER_MAX_TASKS
+#define SENSORSCHEDULER_MAX_TASKS 12
+#endif
+
+/**
+ * Reads a set of sensors, each with its own period, from the main loop. Every sensor goes through
+ * the phases
+ * <pre>
+ *   idle --(release - warm up)--> beginSampling --(release)--> readSensor ... --> endSampling --> idle
+ * </pre>
+ * <code>run</code> advances every sensor that is due by one phase and returns, it never waits for a
+ * sensor. A sensor whose <code>readSensor</code> returns <code>MEASUREMENT_PENDING</code> (e.g. an SHT21
+ * in asynchronous mode) is polled again in the next <code>run</code>. If several sensors are due, the
+ * one with the earliest deadline goes first.
+ * <p>
+ * A reading misses its deadline if it is not complete within <code>deadline</code> ms after its release.
+ * If a sensor falls behind by whole periods, the missed periods are skipped and counted as misses, so
+ * a slow sensor does not read in a burst to catch up. The scheduler also records the largest gap between
+ * two calls of <code>run</code>, which is the jitter the loop adds to every reading.
+ */
+class SensorScheduler {
+  public:
+    /**
+     * Called after each reading with the index of the task and the result of <code>readSensor</code>.
+     */
+    typedef void (*ReadHandler)(uint8_t task, Sensor::Error err);
+
+    SensorScheduler();
+
+    /**
+     * Adds a sensor. A <code>SensorAdapter</code> can be used to read one value of a sensor with multiple
+     * values, or <code>config</code> is passed to <code>readSensor</code>.
+     *
+     * @param[in] period the time between two readings in ms, at least 1.
+     * @param[in] deadline the time in ms after the release by which the reading has to be complete,
+     *                     <code>0</code> means the period.
+     * @param[in] warmUp the time in ms <code>beginSampling</code> is called before the reading.
+     * @param[in] timeInMillis the time of the first reading.
+     *
+     * @return the index of the task or <code>-1</code> if there are already
+     *         <code>SENSORSCHEDULER_MAX_TASKS</code> tasks or the period is <code>0</code>.
+     */
+    int8_t add(Sensor *sensor, unsigned long period, unsigned long deadline = 0, unsigned long warmUp = 0,
+               int config = 0, unsigned long timeInMillis = 0);
+
+    void setReadHandler(ReadHandler handler) { _handler = handler; };
+
+    void run() { run(millis()); };
+    void run(unsigned long timeInMillis);
+
+    /**
+     * @return the time in ms until a sensor is due, <code>0</code> if one is due now. Allows the loop to
+     *         sleep in between.
+     */
+    unsigned long timeToNextEvent(unsigned long timeInMillis);
+
+    uint8_t size() { return _size; };
+
+    Sensor::Error lastError(uint8_t task) { return _tasks[task].lastError; };
+    unsigned long reads(uint8_t task) { return _tasks[task].reads; };
+    unsigned long misses(uint8_t task) { return _tasks[task].misses; };
+
+    /**
+     * @return the longest time in ms from the release to the completion of a reading of the task.
+     */
+    unsigned long maxLatency(uint8_t task) { return _tasks[task].maxLatency; };
+
+    /**
+     * @return the longest time in ms between two calls of <code>run</code>.
+     */
+    unsigned long maxLoopGap() { return _maxLoopGap; };
+    unsigned long loops() { return _loops; };
+    void resetStatistics();
+
+  private:
+    enum Phase { IDLE, SAMPLING, READING };
+
+    struct Task {
+      Sensor *sensor;
+      int config;
+      unsigned long period;
+      unsigned long deadline;
+      unsigned long warmUp;
+      unsigned long release;
+      uint8_t phase;
+      Sensor::Error lastError;
+      unsigned long reads;
+      unsigned long misses;
+      unsigned long maxLatency;
+    };
+
+    bool isDue(Task &task, unsigned long timeInMillis);
+    void step(uint8_t index, unsigned long timeInMillis);
+    void finish(uint8_t index, Sensor::Error err, unsigned long timeInMillis);
+
+    Task _tasks[SENSORSCHEDULER_MAX_TASKS];
+    uint8_t _size;
+    ReadHandler _handler;
+    unsigned long _lastRun;
+    unsigned long _maxLoopGap;
+    unsigned long _loops;
+};
+
+#endif /* SENSORSCHEDULER_H_ */
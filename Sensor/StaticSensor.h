@@ -0,0 +1,192 @@
+/*
+ * StaticSensor.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ *
+ * Compile time variants of SensorImpl and SensorAdapter. Calls through a Sensor* go through the
+ * vtable, through a SensorAdapter even twice, and every class with virtual methods costs a vtable
+ * in flash and a pointer in RAM per object. The templates below resolve the calls at compile time:
+ * <ul>
+ *  <li><code>StaticSensorImpl&lt;Driver&gt;</code> - base class of drivers without virtual methods
+ *      (curiously recurring template pattern). It keeps the sampling state like <code>SensorImpl</code>
+ *      and calls the <code>...Impl</code> methods of the driver directly.
+ *  <li><code>StaticSensorAdapter&lt;S, CONFIG&gt;</code> - one value of a sensor, the config is part of the
+ *      type. Works with drivers on <code>StaticSensorImpl</code> and with the existing
+ *      <code>SensorImpl</code> drivers, whose methods it calls qualified, i.e. without the vtable.
+ *  <li><code>ErasedSensor&lt;S&gt;</code> - makes any of the above a <code>Sensor</code>, for code that
+ *      has to handle sensors at run time, e.g. the <code>SensorScheduler</code>.
+ * </ul>
+ * Templates are instantiated per type, so many different drivers cost more flash than the virtual
+ * version. The benefit is largest for a few drivers that are read often.
+ */
+
+#ifndef STATICSENSOR_H_
+#define STATICSENSOR_H_
+
+#include "Sensor.h"
+
+/**
+ * Base class of a driver without virtual methods. The driver implements <code>readSensorImpl</code> and
+ * may hide <code>beginSamplingImpl</code>, <code>endSamplingImpl</code> and the <code>get...Value</code>
+ * methods. If the <code>...Impl</code> methods are not public, the driver has to declare
+ * <code>StaticSensorImpl&lt;Driver&gt;</code> a friend.
+ */
+template <class Driver>
+class StaticSensorImpl {
+  public:
+    StaticSensorImpl() {
+      _lastReadTime = 0;
+      _sampling = false;
+      _acquired = false;
+    };
+
+    Sensor::Error initialize() { return reset(); };
+
+    Sensor::Error reset() {
+      _sampling = false;
+      _lastReadTime = 0;
+      _acquired = false;
+      return Sensor::NO_ERROR;
+    };
+
+    Sensor::Error readSensor(unsigned long timeInMillis, int config = 0) {
+      Sensor::Error err = driver().readSensorImpl(timeInMillis, config);
+
+      if((err == Sensor::NO_ERROR) && (config == Sensor::ALL_CHANNELS)) {
+        _acquired = true;
+        _acquiredAt = timeInMillis;
+      }
+      return err;
+    };
+
+    bool isAcquired(unsigned long timeInMillis, unsigned long maxAge) {
+      return _acquired && (timeInMillis - _acquiredAt < maxAge);
+    };
+
+    // Default implementations
+    int getIntegerValue(int config = 0) { return 0; };
+    byte getByteValue(int config = 0) { return 0; };
+    float getFloatValue(int config = 0) { return 0; };
+    int getFixedValue(int config = 0) { return 0; };
+
+    Sensor::Error beginSampling() {
+      Sensor::Error err = Sensor::NO_ERROR;
+
+      if(!_sampling) {
+        err = driver().beginSamplingImpl();
+        if(err == Sensor::NO_ERROR) {
+          _sampling = true;
+        }
+      }
+
+      return err;
+    };
+
+    Sensor::Error endSampling() {
+      Sensor::Error err = Sensor::NO_ERROR;
+
+      if(_sampling) {
+        err = driver().endSamplingImpl();
+        if(err == Sensor::NO_ERROR) {
+          _sampling = false;
+        }
+      }
+
+      return err;
+    };
+
+    bool isSampling() { return _sampling; };
+
+    void clockReset(unsigned long timeInMillis) { _lastReadTime = timeInMillis; };
+    unsigned long lastReadTime() { return _lastReadTime; };
+
+    Sensor::Error beginSamplingImpl() { return Sensor::NO_ERROR; };
+    Sensor::Error endSamplingImpl() { return Sensor::NO_ERROR; };
+
+  protected:
+    Driver &driver() { return *static_cast<Driver *>(this); };
+
+  private:
+    unsigned long _lastReadTime;
+    bool _sampling;
+    bool _acquired;
+    unsigned long _acquiredAt;
+};
+
+/**
+ * One value of sensor <code>S</code>, selected by <code>CONFIG</code>. Like <code>SensorAdapter</code>, a
+ * config other than zero passed to a method overrides <code>CONFIG</code>. The methods of <code>S</code> are
+ * called qualified, so even for a <code>SensorImpl</code> driver the vtable is not used.
+ */
+template <class S, int CONFIG>
+class StaticSensorAdapter {
+  public:
+    StaticSensorAdapter(S &sensor) : _sensor(sensor) {};
+
+    Sensor::Error initialize() { return _sensor.S::initialize(); };
+    Sensor::Error reset() { return _sensor.S::reset(); };
+
+    Sensor::Error readSensor(unsigned long timeInMillis, int config = 0) {
+      return _sensor.S::readSensor(timeInMillis, config ? config : CONFIG);
+    };
+
+    int getIntegerValue(int config = 0) { return _sensor.S::getIntegerValue(config ? config : CONFIG); };
+    byte getByteValue(int config = 0) { return _sensor.S::getByteValue(config ? config : CONFIG); };
+    float getFloatValue(int config = 0) { return _sensor.S::getFloatValue(config ? config : CONFIG); };
+    int getFixedValue(int config = 0) { return _sensor.S::getFixedValue(config ? config : CONFIG); };
+
+    Sensor::Error beginSampling() { return _sensor.S::beginSampling(); };
+    Sensor::Error endSampling() { return _sensor.S::endSampling(); };
+    bool isSampling() { return _sensor.S::isSampling(); };
+
+    void clockReset(unsigned long timeInMillis) { _sensor.S::clockReset(timeInMillis); };
+    unsigned long lastReadTime() { return _sensor.S::lastReadTime(); };
+
+    bool isAcquired(unsigned long timeInMillis, unsigned long maxAge) {
+      return _sensor.S::isAcquired(timeInMillis, maxAge);
+    };
+
+    S &sensor() { return _sensor; };
+
+  private:
+    S &_sensor;
+};
+
+/**
+ * Makes a driver on <code>StaticSensorImpl</code> or a <code>StaticSensorAdapter</code> a
+ * <code>Sensor</code>. The wrapper has a vtable, but calls <code>S</code> directly.
+ */
+template <class S>
+class ErasedSensor: public Sensor {
+  public:
+    ErasedSensor(S &sensor) : _sensor(sensor) {};
+
+    Sensor::Error initialize() { return _sensor.S::initialize(); };
+    Sensor::Error reset() { return _sensor.S::reset(); };
+
+    Sensor::Error readSensor(unsigned long timeInMillis, int config = 0) {
+      return _sensor.S::readSensor(timeInMillis, config);
+    };
+
+    int getIntegerValue(int config = 0) { return _sensor.S::getIntegerValue(config); };
+    byte getByteValue(int config = 0) { return _sensor.S::getByteValue(config); };
+    float getFloatValue(int config = 0) { return _sensor.S::getFloatValue(config); };
+    int getFixedValue(int config = 0) { return _sensor.S::getFixedValue(config); };
+
+    Sensor::Error beginSampling() { return _sensor.S::beginSampling(); };
+    Sensor::Error endSampling() { return _sensor.S::endSampling(); };
+    bool isSampling() { return _sensor.S::isSampling(); };
+
+    void clockReset(unsigned long timeInMillis) { _sensor.S::clockReset(timeInMillis); };
+    unsigned long lastReadTime() { return _sensor.S::lastReadTime(); };
+
+    bool isAcquired(unsigned long timeInMillis, unsigned long maxAge) {
+      return _sensor.S::isAcquired(timeInMillis, maxAge);
+    };
+
+  private:
+    S &_sensor;
+};
+
+#endif /* STATICSENSOR_H_ */
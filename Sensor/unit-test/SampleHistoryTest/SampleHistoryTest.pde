@@ -0,0 +1,164 @@
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <SampleHistory.h>
+
+TestSuite suite;
+
+/**
+ * Sensor that returns the values of a table, one per reading. A negative config makes the
+ * reading fail.
+ */
+class TableSensor: public SensorImpl {
+  public:
+    TableSensor(const int *values) { _values = values; _index = 0; };
+
+    int getFixedValue(int config = 0) { return _values[_index - 1] + config; };
+
+  protected:
+    Sensor::Error readSensorImpl(unsigned long timeInMillis, int config) {
+      if(config < 0) {
+        return DATA_TIMEOUT;
+      }
+      _index++;
+      return NO_ERROR;
+    };
+
+  private:
+    const int *_values;
+    uint8_t _index;
+};
+
+void setup() {
+  Serial.begin(9600);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(ringBuffer) {
+  SensorHistory<4> history;
+
+  assertEquals(0, history.count());
+  assertEquals(0, history.minimum());
+  assertEquals(0, history.average());
+
+  for(int i = 1; i <= 6; i++) {
+    history.add(i * 100);
+  }
+  assertTrue(history.isFull());
+  assertEquals(4, history.count());
+  assertEquals(600, history.last());
+  assertEquals(300, history.sample(3));
+  assertEquals(0, history.sample(4));
+  assertEquals(1800, history.sum());
+  assertEquals(300, history.minimum());
+  assertEquals(600, history.maximum());
+  assertEquals(450, history.average());
+
+  history.clear();
+  assertEquals(0, history.count());
+  history.add(-5);
+  assertEquals(-5, history.minimum());
+  assertEquals(-5, history.maximum());
+  assertEquals(-5, history.movingAverage());
+}
+
+test(slidingMinMax) {
+  SensorHistory<7> history;
+  int values[200];
+  unsigned long seed = 1;
+
+  // Compares the queues with a search over the window for pseudo random values, including runs
+  // of equal values
+  for(int i = 0; i < 200; i++) {
+    seed = seed * 1103515245UL + 12345;
+    values[i] = (int)((seed >> 16) % 41) - 20;
+    history.add(values[i]);
+
+    int first = i >= 6 ? i - 6 : 0;
+    int minValue = values[first];
+    int maxValue = values[first];
+    long sum = 0;
+    for(int j = first; j <= i; j++) {
+      if(values[j] < minValue) {
+        minValue = values[j];
+      }
+      if(values[j] > maxValue) {
+        maxValue = values[j];
+      }
+      sum += values[j];
+    }
+    assertEquals(minValue, history.minimum());
+    assertEquals(maxValue, history.maximum());
+    assertEquals(sum, history.sum());
+  }
+}
+
+test(variance) {
+  SensorHistory<8> history;
+  int values[] = { 200, 400, 400, 400, 500, 500, 700, 900 };
+
+  for(int i = 0; i < 8; i++) {
+    history.add(values[i] - 30000);
+  }
+  // The standard deviation of 2, 4, 4, 4, 5, 5, 7, 9 is 2, far from zero as well
+  assertEquals(-29500, history.average());
+  assertUnsignedLongEquals(40000, history.variance());
+  assertEquals(200, history.standardDeviation());
+
+  for(int i = 0; i < 8; i++) {
+    history.add(values[i] + 30000);
+  }
+  assertUnsignedLongEquals(40000, history.variance());
+  assertEquals(200, history.standardDeviation());
+}
+
+test(movingAverage) {
+  SensorHistory<2> history;
+
+  history.setSmoothing(1);
+  history.add(1000);
+  history.add(2000);
+  assertEquals(1500, history.movingAverage());
+  history.add(2000);
+  assertEquals(1750, history.movingAverage());
+
+  // The moving average covers all samples, not only the ones in the history
+  history.clear();
+  history.setSmoothing(3);
+  for(int i = 0; i < 100; i++) {
+    history.add(800);
+  }
+  history.add(0);
+  assertEquals(700, history.movingAverage());
+}
+
+test(attached) {
+  const int values[] = { 100, 200, 300, 400 };
+  TableSensor sensor(values);
+  SensorHistory<4> history;
+  SensorHistory<4> offsetHistory(5);
+
+  sensor.attachHistory(&history);
+  sensor.attachHistory(&offsetHistory);
+
+  sensor.readSensor(0UL);
+  sensor.readSensor(0UL, 5);
+  // Failed readings are not recorded
+  assertEquals(Sensor::DATA_TIMEOUT, sensor.readSensor(0UL, -1));
+  assertEquals(1, history.count());
+  assertEquals(100, history.last());
+  assertEquals(1, offsetHistory.count());
+  assertEquals(205, offsetHistory.last());
+
+  // Also through an adapter
+  SensorAdapter adapter(&sensor, 5);
+  adapter.readSensor(0UL);
+  assertEquals(305, offsetHistory.last());
+
+  sensor.detachHistory(&offsetHistory);
+  sensor.readSensor(0UL, 5);
+  assertEquals(2, offsetHistory.count());
+  assertEquals(1, history.count());
+}
@@ -0,0 +1,135 @@
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <SensorFilter.h>
+#include <SampleHistory.h>
+
+TestSuite suite;
+
+/**
+ * Sensor that returns the values of a table, one per reading, and starts over at the end.
+ */
+class TableSensor: public SensorImpl {
+  public:
+    TableSensor(const int *values, uint8_t size) { _values = values; _size = size; _index = 0; samplingCalls = 0; };
+
+    int samplingCalls;
+
+    int getFixedValue(int config = 0) { return _values[(_index + _size - 1) % _size]; };
+
+  protected:
+    Sensor::Error readSensorImpl(unsigned long timeInMillis, int config) {
+      _index = (_index + 1) % _size;
+      return NO_ERROR;
+    };
+
+    Sensor::Error beginSamplingImpl() {
+      samplingCalls++;
+      return NO_ERROR;
+    };
+
+  private:
+    const int *_values;
+    uint8_t _size;
+    uint8_t _index;
+};
+
+void setup() {
+  Serial.begin(9600);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(median) {
+  const int values[] = { 100, 900, 110, 120, -800, 130, 140, 150 };
+  const int expected[] = { 100, 100, 110, 120, 110, 120, 130, 140 };
+  TableSensor sensor(values, 8);
+  MedianFilter<3> filter(&sensor);
+
+  for(int i = 0; i < 8; i++) {
+    assertEquals(Sensor::NO_ERROR, filter.readSensor(0UL));
+    assertEquals(expected[i], filter.getFixedValue());
+  }
+  assertEquals(3, filter.count());
+  assertEquals(1, filter.getIntegerValue());
+  assertTrue(fabs(filter.getFloatValue() - 1.4) < 0.001);
+
+  filter.reset();
+  assertEquals(0, filter.count());
+}
+
+test(hampel) {
+  // Noise of +-10 around 500 with two spikes
+  const int values[] = { 500, 510, 490, 505, 495, 2000, 500, 510, 490, -1000, 505 };
+  TableSensor sensor(values, 11);
+  HampelFilter<5> filter(&sensor);
+  int maxDeviation = 0;
+
+  for(int i = 0; i < 11; i++) {
+    filter.readSensor(0UL);
+    if(i >= 4) {
+      if(abs(filter.getFixedValue() - 500) > maxDeviation) {
+        maxDeviation = abs(filter.getFixedValue() - 500);
+      }
+    }
+    // Values within the noise pass unchanged
+    if((i >= 4) && (values[i] > 0) && (values[i] < 1000)) {
+      assertEquals(values[i], filter.getFixedValue());
+    }
+  }
+  assertTrue(maxDeviation <= 10);
+}
+
+test(delta) {
+  const int values[] = { 0, 10, 500, 20, 600, 600, 600, 600, 610 };
+  const int expected[] = { 0, 10, 10, 20, 20, 20, 20, 600, 610 };
+  TableSensor sensor(values, 9);
+  DeltaFilter filter(&sensor, 50);
+
+  for(int i = 0; i < 9; i++) {
+    filter.readSensor(0UL);
+    assertEquals(expected[i], filter.getFixedValue());
+  }
+  assertUnsignedLongEquals(4, filter.rejects());
+}
+
+test(emaAndDecimation) {
+  const int values[] = { 1000, 2000, 3000, 4000 };
+  TableSensor sensor(values, 4);
+  EmaFilter ema(&sensor, 1);
+  DecimationFilter decimation(&ema, 2);
+
+  assertEquals(Sensor::MEASUREMENT_PENDING, decimation.readSensor(0UL));
+  assertEquals(1000, ema.getFixedValue());
+  assertEquals(Sensor::NO_ERROR, decimation.readSensor(0UL));
+  assertEquals(1500, ema.getFixedValue());
+  assertEquals(1250, decimation.getFixedValue());
+  decimation.readSensor(0UL);
+  assertEquals(Sensor::NO_ERROR, decimation.readSensor(0UL));
+  assertEquals(3125, ema.getFixedValue());
+  // (2250 + 3125) / 2
+  assertEquals(2688, decimation.getFixedValue());
+}
+
+test(chain) {
+  const int values[] = { 100, 100, 5000, 100, 100 };
+  TableSensor sensor(values, 5);
+  MedianFilter<3> median(&sensor);
+  EmaFilter ema(&median, 2);
+  SensorHistory<4> history;
+
+  ema.attachHistory(&history);
+
+  // Sampling goes through to the source
+  ema.beginSampling();
+  assertEquals(1, sensor.samplingCalls);
+  assertTrue(ema.isSampling());
+
+  for(int i = 0; i < 5; i++) {
+    ema.readSensor(0UL);
+  }
+  assertEquals(4, history.count());
+  assertEquals(100, history.maximum());
+  ema.endSampling();
+}
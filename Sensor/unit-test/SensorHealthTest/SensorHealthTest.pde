@@ -0,0 +1,129 @@
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <SensorHealth.h>
+
+TestSuite suite;
+
+/**
+ * Sensor that returns the results of a script, one per reading. Each reading takes the time
+ * passed as config in us.
+ */
+class ScriptSensor: public SensorImpl {
+  public:
+    ScriptSensor(const Sensor::Error *script) { _script = script; _index = 0; };
+
+  protected:
+    Sensor::Error readSensorImpl(unsigned long timeInMillis, int config) {
+      delayMicroseconds(config);
+      return _script[_index++];
+    };
+
+  private:
+    const Sensor::Error *_script;
+    uint8_t _index;
+};
+
+const Sensor::Error script[] = {
+  Sensor::NO_ERROR, Sensor::CHECKSUM_ERROR, Sensor::CHECKSUM_ERROR, Sensor::MEASUREMENT_PENDING,
+  Sensor::SYNC_TIMEOUT, Sensor::NO_ERROR, Sensor::TOO_QUICK, Sensor::BUS_ERROR
+};
+
+void setup() {
+  Serial.begin(9600);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(counters) {
+  ScriptSensor sensor(script);
+  SensorHealth health;
+
+  // Not counted without a health record
+  sensor.readSensor(1000, 100);
+  sensor.attachHealth(&health);
+  assertTrue(sensor.health() == &health);
+  assertUnsignedLongEquals(0, health.reads());
+
+  for(int i = 1; i < 5; i++) {
+    sensor.readSensor(1000 + i * 10, 100);
+  }
+  assertUnsignedLongEquals(4, health.reads());
+  assertUnsignedLongEquals(0, health.successes());
+  assertEquals(2, health.errors(Sensor::CHECKSUM_ERROR));
+  assertEquals(1, health.errors(Sensor::SYNC_TIMEOUT));
+  assertEquals(1, health.errors(Sensor::MEASUREMENT_PENDING));
+  assertEquals(0, health.errors(Sensor::NO_ERROR));
+  assertUnsignedLongEquals(3, health.failures());
+  // The pending reading does not interrupt the failures
+  assertEquals(3, health.consecutiveFailures());
+  assertEquals(Sensor::SYNC_TIMEOUT, health.lastError());
+
+  sensor.readSensor(2000, 100);
+  assertUnsignedLongEquals(1, health.successes());
+  assertEquals(0, health.consecutiveFailures());
+  assertUnsignedLongEquals(2000, health.lastGoodTime());
+
+  sensor.readSensor(3000, 100);
+  sensor.readSensor(4000, 100);
+  assertEquals(2, health.consecutiveFailures());
+  assertEquals(Sensor::BUS_ERROR, health.lastError());
+  assertUnsignedLongEquals(2000, health.lastGoodTime());
+
+  health.clear();
+  assertUnsignedLongEquals(0, health.reads());
+  assertEquals(0, health.consecutiveFailures());
+}
+
+test(latency) {
+  ScriptSensor sensor(script);
+  SensorHealth health;
+
+  assertUnsignedLongEquals(0, health.minLatency());
+  assertUnsignedLongEquals(0, health.meanLatency());
+
+  sensor.attachHealth(&health);
+  sensor.readSensor(0, 100);
+  sensor.readSensor(0, 300);
+  sensor.readSensor(0, 50);
+  sensor.readSensor(0, 2000);
+  assertUnsignedLongEquals(50, health.minLatency());
+  assertUnsignedLongEquals(2000, health.maxLatency());
+  assertUnsignedLongEquals(613, health.meanLatency());
+
+  // Detached, the time is not measured any more
+  sensor.attachHealth(0);
+  sensor.readSensor(0, 5000);
+  assertUnsignedLongEquals(2000, health.maxLatency());
+}
+
+test(dump) {
+  ScriptSensor sensor(script);
+  SensorHealth health;
+  uint8_t buffer[SensorHealth::DUMP_SIZE];
+
+  sensor.attachHealth(&health);
+  for(int i = 0; i < 8; i++) {
+    sensor.readSensor(70000UL + i, 300);
+  }
+  health.dump(buffer);
+
+  // Successes
+  assertEquals(2, buffer[0]);
+  assertEquals(0, buffer[3]);
+  // Checksum errors (8) and pending (10)
+  assertEquals(2, buffer[4 + (Sensor::CHECKSUM_ERROR - 1) * 2]);
+  assertEquals(1, buffer[4 + (Sensor::MEASUREMENT_PENDING - 1) * 2]);
+  // Failures in a row
+  assertEquals(2, buffer[24]);
+  // Last good reading, 70005 = 0x011175
+  assertEquals(0x75, buffer[26]);
+  assertEquals(0x11, buffer[27]);
+  assertEquals(0x01, buffer[28]);
+  // Mean latency
+  assertEquals(300 & 0xff, buffer[38]);
+  assertEquals(300 >> 8, buffer[39]);
+
+  health.printDebug();
+}
@@ -0,0 +1,180 @@
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <SensorScheduler.h>
+
+TestSuite suite;
+
+/**
+ * Sensor that needs <code>pendingReads</code> polls to complete a reading and records the calls.
+ */
+class FakeSensor: public SensorImpl {
+  public:
+    FakeSensor(uint8_t pendingReads = 0) { _pendingReads = pendingReads; _polls = 0; readCount = 0; lastConfig = -1; };
+
+    int readCount;
+    int lastConfig;
+    unsigned long lastRead;
+
+  protected:
+    Sensor::Error readSensorImpl(unsigned long timeInMillis, int config) {
+      if(_polls < _pendingReads) {
+        _polls++;
+        return MEASUREMENT_PENDING;
+      }
+      _polls = 0;
+      readCount++;
+      lastConfig = config;
+      lastRead = timeInMillis;
+      return NO_ERROR;
+    };
+
+  private:
+    uint8_t _pendingReads;
+    uint8_t _polls;
+};
+
+int order[4];
+int orderCount;
+
+void recordOrder(uint8_t task, Sensor::Error err) {
+  if(orderCount < 4) {
+    order[orderCount++] = task;
+  }
+}
+
+void setup() {
+  Serial.begin(9600);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(periods) {
+  SensorScheduler scheduler;
+  FakeSensor fast, slow;
+
+  scheduler.add(&fast, 100);
+  scheduler.add(&slow, 1000, 0, 0, 7);
+
+  for(unsigned long t = 0; t < 2000; t += 10) {
+    scheduler.run(t);
+  }
+  assertEquals(20, fast.readCount);
+  assertEquals(2, slow.readCount);
+  assertEquals(7, slow.lastConfig);
+  assertUnsignedLongEquals(0, scheduler.misses(0));
+  assertUnsignedLongEquals(10, scheduler.maxLoopGap());
+  assertEquals(40, scheduler.timeToNextEvent(1960));
+}
+
+test(pendingAndWarmUp) {
+  SensorScheduler scheduler;
+  FakeSensor sensor(2);
+
+  scheduler.add(&sensor, 500, 0, 50, 0, 1000);
+
+  assertUnsignedLongEquals(950, scheduler.timeToNextEvent(0));
+
+  // Sampling starts before the release, the reading at the release
+  scheduler.run(950);
+  assertTrue(sensor.isSampling());
+  assertEquals(0, sensor.readCount);
+  scheduler.run(1000);
+  scheduler.run(1005);
+  assertEquals(0, sensor.readCount);
+  assertUnsignedLongEquals(0, scheduler.timeToNextEvent(1010));
+
+  // Pending readings are polled until they are complete
+  scheduler.run(1010);
+  assertEquals(1, sensor.readCount);
+  assertTrue(!sensor.isSampling());
+  assertUnsignedLongEquals(10, scheduler.maxLatency(0));
+  assertEquals(Sensor::NO_ERROR, scheduler.lastError(0));
+}
+
+test(deadlineMisses) {
+  SensorScheduler scheduler;
+  FakeSensor sensor;
+
+  scheduler.add(&sensor, 100, 20);
+
+  scheduler.run(0);
+  scheduler.run(150);
+  assertUnsignedLongEquals(1, scheduler.misses(0));
+  assertUnsignedLongEquals(50, scheduler.maxLatency(0));
+
+  // The loop stalled for several periods, the periods 300 and 400 are skipped
+  scheduler.run(560);
+  assertEquals(3, sensor.readCount);
+  assertUnsignedLongEquals(4, scheduler.misses(0));
+
+  // The reading of period 500 is late as well
+  scheduler.run(600);
+  assertEquals(4, sensor.readCount);
+  assertUnsignedLongEquals(5, scheduler.misses(0));
+  scheduler.run(610);
+  assertEquals(5, sensor.readCount);
+  assertUnsignedLongEquals(5, scheduler.misses(0));
+  assertUnsignedLongEquals(410, scheduler.maxLoopGap());
+}
+
+test(earliestDeadlineFirst) {
+  SensorScheduler scheduler;
+  FakeSensor a, b, c;
+
+  scheduler.add(&a, 1000, 500);
+  scheduler.add(&b, 1000, 100);
+  scheduler.add(&c, 1000, 300);
+  scheduler.setReadHandler(recordOrder);
+
+  orderCount = 0;
+  scheduler.run(0);
+  assertEquals(3, orderCount);
+  assertEquals(1, order[0]);
+  assertEquals(2, order[1]);
+  assertEquals(0, order[2]);
+}
+
+test(tooManyTasks) {
+  SensorScheduler scheduler;
+  FakeSensor sensor;
+
+  for(int i = 0; i < SENSORSCHEDULER_MAX_TASKS; i++) {
+    assertEquals(i, scheduler.add(&sensor, 100));
+  }
+  assertEquals(-1, scheduler.add(&sensor, 100));
+}
+
+test(zeroPeriod) {
+  SensorScheduler scheduler;
+  FakeSensor sensor;
+
+  assertEquals(-1, scheduler.add(&sensor, 0));
+  assertEquals(0, scheduler.add(&sensor, 100));
+}
+
+// After a day of sleep the missed periods are skipped at once
+#define DAY_MILLIS 86400000UL
+
+test(longSleep) {
+  SensorScheduler scheduler;
+  FakeSensor sensor;
+
+  scheduler.add(&sensor, 100, 20);
+  scheduler.run(0);
+  scheduler.run(DAY_MILLIS + 50);
+  assertEquals(2, sensor.readCount);
+  // The late reading of period 100 and the periods 200 ... DAY_MILLIS - 100
+  assertUnsignedLongEquals(DAY_MILLIS / 100 - 1, scheduler.misses(0));
+
+  // The period the sleep ended in is read late, then the schedule is back on time
+  scheduler.run(DAY_MILLIS + 60);
+  assertEquals(3, sensor.readCount);
+  assertUnsignedLongEquals(DAY_MILLIS / 100, scheduler.misses(0));
+  scheduler.run(DAY_MILLIS + 99);
+  assertEquals(3, sensor.readCount);
+  scheduler.run(DAY_MILLIS + 100);
+  assertEquals(4, sensor.readCount);
+  assertUnsignedLongEquals(DAY_MILLIS / 100, scheduler.misses(0));
+}
@@ -0,0 +1,108 @@
+#include <ArduinoUnit.h>
+#include <Sensor.h>
+#include <StaticSensor.h>
+#include <SensorScheduler.h>
+
+TestSuite suite;
+
+/**
+ * Driver without virtual methods that records the calls.
+ */
+class StaticFake: public StaticSensorImpl<StaticFake> {
+  public:
+    StaticFake() { readCount = 0; lastConfig = -1; samplingCalls = 0; };
+
+    int readCount;
+    int lastConfig;
+    int samplingCalls;
+
+    float getFloatValue(int config = 0) { return config * 1.5; };
+    int getIntegerValue(int config = 0) { return config * 10; };
+
+    Sensor::Error readSensorImpl(unsigned long timeInMillis, int config) {
+      readCount++;
+      lastConfig = config;
+      return Sensor::NO_ERROR;
+    };
+
+    Sensor::Error beginSamplingImpl() {
+      samplingCalls++;
+      return Sensor::NO_ERROR;
+    };
+};
+
+/**
+ * Virtual driver, which the StaticSensorAdapter calls without the vtable.
+ */
+class VirtualFake: public SensorImpl {
+  public:
+    int getIntegerValue(int config = 0) { return config + 100; };
+
+  protected:
+    Sensor::Error readSensorImpl(unsigned long timeInMillis, int config) {
+      return config == 3 ? NO_ERROR : DATA_TIMEOUT;
+    };
+};
+
+void setup() {
+  Serial.begin(9600);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(staticDriver) {
+  StaticFake fake;
+  StaticSensorAdapter<StaticFake, 2> adapter(fake);
+
+  assertTrue(adapter.readSensor(0) == Sensor::NO_ERROR);
+  assertEquals(1, fake.readCount);
+  assertEquals(2, fake.lastConfig);
+  assertEquals(20, adapter.getIntegerValue());
+  assertTrue(adapter.getFloatValue() == 3.0);
+
+  // A config passed to the adapter overrides the one of the type
+  adapter.readSensor(0, 4);
+  assertEquals(4, fake.lastConfig);
+  assertEquals(0, adapter.getByteValue());
+}
+
+test(sampling) {
+  StaticFake fake;
+  StaticSensorAdapter<StaticFake, 1> adapter(fake);
+
+  assertTrue(!adapter.isSampling());
+  adapter.beginSampling();
+  adapter.beginSampling();
+  assertTrue(adapter.isSampling());
+  assertEquals(1, fake.samplingCalls);
+  adapter.endSampling();
+  assertTrue(!fake.isSampling());
+
+  adapter.clockReset(1234);
+  assertUnsignedLongEquals(1234, fake.lastReadTime());
+}
+
+test(virtualDriver) {
+  VirtualFake fake;
+  StaticSensorAdapter<VirtualFake, 3> adapter(fake);
+
+  assertTrue(adapter.readSensor(0) == Sensor::NO_ERROR);
+  assertTrue(adapter.readSensor(0, 1) == Sensor::DATA_TIMEOUT);
+  assertEquals(103, adapter.getIntegerValue());
+}
+
+test(erased) {
+  StaticFake fake;
+  StaticSensorAdapter<StaticFake, 5> adapter(fake);
+  ErasedSensor<StaticSensorAdapter<StaticFake, 5> > erased(adapter);
+  SensorScheduler scheduler;
+
+  scheduler.add(&erased, 100);
+  for(unsigned long t = 0; t < 1000; t += 10) {
+    scheduler.run(t);
+  }
+  assertEquals(10, fake.readCount);
+  assertEquals(5, fake.lastConfig);
+}
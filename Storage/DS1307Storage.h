@@ -0,0 +1,57 @@
+/*
+ * DS1307Storage.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef DS1307STORAGE_H_
+#define DS1307STORAGE_H_
+
+#include "StorageDevice.h"
+#include <DS1307RTC.h>
+
+/**
+ * The battery backed user RAM of the DS1307, accessed through <code>RTC.readUserMemory</code> and
+ * <code>RTC.writeUserMemory</code>. Of the 56 bytes of RAM, the DS1307RTC library keeps the time zone
+ * hours in the first one and the record of <code>RTC.writeTimeZone</code> in the last
+ * <code>TimeZone::RECORD_SIZE</code>, which leaves <code>DS1307RTC::USER_MEMORY_SIZE</code> (43) bytes.
+ * The RAM does not wear out and a block is transferred in one I2C transaction (up to 31 bytes), which
+ * makes it a good place for small, often changing data.
+ * <p>
+ * The <code>RTC</code> has to be initialized before the device is used.
+ * <p>
+ * The device is implemented in the header, so the Storage library only depends on the DS1307RTC
+ * library in sketches that use it.
+ */
+class DS1307Storage: public StorageDevice {
+  public:
+    static const int SIZE = DS1307RTC::USER_MEMORY_SIZE;
+
+    long size() { return SIZE; };
+
+    int read(int addr, uint8_t *buffer, int len);
+    int write(int addr, const uint8_t *buffer, int len);
+    using StorageDevice::read;
+    using StorageDevice::write;
+
+    bool hasBlockWrites() { return true; };
+};
+
+inline int DS1307Storage::read(int addr, uint8_t *buffer, int len) {
+  if((addr < 0) || (addr >= SIZE)) {
+    return 0;
+  }
+
+  return RTC.readUserMemory(buffer, addr, addr + len > SIZE ? SIZE - addr : len);
+}
+
+inline int DS1307Storage::write(int addr, const uint8_t *buffer, int len) {
+  if((addr < 0) || (addr >= SIZE)) {
+    return 0;
+  }
+
+  return RTC.writeUserMemory((byte *)buffer, addr, addr + len > SIZE ? SIZE - addr : len);
+}
+
+#endif /* DS1307STORAGE_H_ */
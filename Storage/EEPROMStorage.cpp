@@ -0,0 +1,45 @@
+/*
+ * EEPROMStorage.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "EEPROMStorage.h"
+#include <EEPROM.h>
+
+EEPROMStorage EEPROMStorage::instance = EEPROMStorage();
+
+int EEPROMStorage::read(int addr, uint8_t *buffer, int len) {
+  len = fit(addr, len);
+  for(int i = 0; i < len; i++) {
+    buffer[i] = EEPROM.read(addr + i);
+  }
+
+  return len;
+}
+
+int EEPROMStorage::write(int addr, const uint8_t *buffer, int len) {
+  len = fit(addr, len);
+  for(int i = 0; i < len; i++) {
+    EEPROM.write(addr + i, buffer[i]);
+  }
+
+  return len;
+}
+
+uint8_t EEPROMStorage::read(int addr) {
+  return EEPROM.read(addr);
+}
+
+void EEPROMStorage::write(int addr, uint8_t value) {
+  EEPROM.write(addr, value);
+}
+
+int EEPROMStorage::fit(int addr, int len) {
+  if((addr < 0) || (addr > E2END)) {
+    return 0;
+  }
+
+  return (addr + (long)len > E2END + 1L) ? E2END + 1 - addr : len;
+}
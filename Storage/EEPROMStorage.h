@@ -0,0 +1,35 @@
+/*
+ * EEPROMStorage.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef EEPROMSTORAGE_H_
+#define EEPROMSTORAGE_H_
+
+#include "StorageDevice.h"
+#include <avr/io.h>
+
+/**
+ * The internal EEPROM of the MCU.
+ */
+class EEPROMStorage: public StorageDevice {
+  public:
+    static EEPROMStorage instance;
+
+    long size() { return E2END + 1L; };
+
+    int read(int addr, uint8_t *buffer, int len);
+    int write(int addr, const uint8_t *buffer, int len);
+
+    uint8_t read(int addr);
+    void write(int addr, uint8_t value);
+
+  private:
+    EEPROMStorage() {};
+
+    int fit(int addr, int len);
+};
+
+#endif /* EEPROMSTORAGE_H_ */
@@ -0,0 +1,156 @@
+/*
+ * I2CEEPROMStorage.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef I2CEEPROMSTORAGE_H_
+#define I2CEEPROMSTORAGE_H_
+
+#include "StorageDevice.h"
+#include <Wire.h>
+
+// Two bytes of each Wire buffer are taken by the address
+#define I2CEEPROM_ADDRESS_BYTES 2
+
+/**
+ * An external I2C EEPROM with two address bytes, e.g. a 24LC64 (8 kB, 32 byte pages) or a
+ * 24LC256 (32 kB, 64 byte pages). Blocks are read with sequential reads and written with page
+ * writes, i.e. a block is split at the page boundaries and at the size of the buffer of the Wire
+ * library. After each page the device is polled until it finished its write cycle (~5 ms), which
+ * is the cost of a whole page instead of a single byte.
+ * <p>
+ * <code>Wire.begin()</code> has to be called before the device is used.
+ * <p>
+ * The device is implemented in the header, so the Storage library only depends on the Wire library
+ * in sketches that use it.
+ */
+class I2CEEPROMStorage: public StorageDevice {
+  public:
+    static const uint8_t DEFAULT_ADDRESS = 0x50;
+
+    /**
+     * @param[in] size the number of bytes of the EEPROM.
+     * @param[in] pageSize the size of a page in bytes, see the data sheet of the EEPROM.
+     * @param[in] address the I2C address of the EEPROM, <code>0x50</code> to <code>0x57</code> depending
+     *                    on the address pins.
+     */
+    I2CEEPROMStorage(long size, uint8_t pageSize, uint8_t address = DEFAULT_ADDRESS);
+
+    long size() { return _size; };
+
+    int read(int addr, uint8_t *buffer, int len);
+    int write(int addr, const uint8_t *buffer, int len);
+    using StorageDevice::read;
+    using StorageDevice::write;
+
+    bool hasBlockWrites() { return true; };
+
+    /**
+     * Waits until the EEPROM acknowledges its address, i.e. until a write cycle is done.
+     *
+     * @return <code>true</code> if the EEPROM is ready;<code>false</code> if it did not respond
+     *         within <code>WRITE_TIMEOUT</code> ms.
+     */
+    bool waitReady();
+
+  private:
+    static const unsigned long WRITE_TIMEOUT = 10;
+
+    int fit(int addr, int len);
+
+    long _size;
+    uint8_t _pageSize;
+    uint8_t _address;
+};
+
+inline I2CEEPROMStorage::I2CEEPROMStorage(long size, uint8_t pageSize, uint8_t address) {
+  _size = size;
+  _pageSize = pageSize;
+  _address = address;
+}
+
+inline int I2CEEPROMStorage::read(int addr, uint8_t *buffer, int len) {
+  int done = 0;
+  uint8_t chunk, received;
+
+  len = fit(addr, len);
+  while(done < len) {
+    Wire.beginTransmission(_address);
+    Wire.send((uint8_t)((addr + done) >> 8));
+    Wire.send((uint8_t)((addr + done) & 0xff));
+    if(Wire.endTransmission() != 0) {
+      break;
+    }
+
+    // The address counter of the EEPROM increments over the page boundaries when reading
+    chunk = (len - done) > BUFFER_LENGTH ? BUFFER_LENGTH : len - done;
+    received = Wire.requestFrom(_address, chunk);
+    for(uint8_t i = 0; i < received; i++) {
+      buffer[done++] = Wire.receive();
+    }
+    if(received < chunk) {
+      break;
+    }
+  }
+
+  return done;
+}
+
+inline int I2CEEPROMStorage::write(int addr, const uint8_t *buffer, int len) {
+  int done = 0;
+  int chunk;
+
+  len = fit(addr, len);
+  while(done < len) {
+    // Within a page write the address counter wraps at the end of the page
+    chunk = _pageSize - (addr + done) % _pageSize;
+    if(chunk > BUFFER_LENGTH - I2CEEPROM_ADDRESS_BYTES) {
+      chunk = BUFFER_LENGTH - I2CEEPROM_ADDRESS_BYTES;
+    }
+    if(chunk > len - done) {
+      chunk = len - done;
+    }
+
+    if(!waitReady()) {
+      break;
+    }
+    Wire.beginTransmission(_address);
+    Wire.send((uint8_t)((addr + done) >> 8));
+    Wire.send((uint8_t)((addr + done) & 0xff));
+    Wire.send((uint8_t *)buffer + done, chunk);
+    if(Wire.endTransmission() != 0) {
+      break;
+    }
+    done += chunk;
+  }
+
+  // Reads are not possible before the last write cycle is done
+  waitReady();
+
+  return done;
+}
+
+inline bool I2CEEPROMStorage::waitReady() {
+  unsigned long start = millis();
+
+  do {
+    Wire.beginTransmission(_address);
+    if(Wire.endTransmission() == 0) {
+      return true;
+    }
+  } while(millis() - start < WRITE_TIMEOUT);
+
+  return false;
+}
+
+inline int I2CEEPROMStorage::fit(int addr, int len) {
+  if((addr < 0) || (addr >= _size)) {
+    return 0;
+  }
+
+  return (addr + (long)len > _size) ? _size - addr : len;
+}
+
+#endif /* I2CEEPROMSTORAGE_H_ */
@@ -0,0 +1,20 @@
+/*
+ * StorageDevice.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "StorageDevice.h"
+
+uint8_t StorageDevice::read(int addr) {
+  uint8_t value = 0xff;
+
+  read(addr, &value, 1);
+
+  return value;
+}
+
+void StorageDevice::write(int addr, uint8_t value) {
+  write(addr, &value, 1);
+}
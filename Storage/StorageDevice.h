@@ -0,0 +1,57 @@
+/*
+ * StorageDevice.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef STORAGEDEVICE_H_
+#define STORAGEDEVICE_H_
+
+#include <WProgram.h>
+
+/**
+ * A non-volatile memory that is addressed byte by byte, e.g. the internal EEPROM, the user RAM of
+ * a DS1307 or an external I2C EEPROM. Besides single bytes, a device reads and writes blocks, so
+ * devices that sit on a bus can transfer a whole record in as few transactions as possible.
+ */
+class StorageDevice {
+  public:
+    /**
+     * @return the number of bytes of the device.
+     */
+    virtual long size() = 0;
+
+    /**
+     * Reads <code>len</code> bytes starting at <code>addr</code> into <code>buffer</code>.
+     *
+     * @return the number of bytes read, which is less than <code>len</code> if the block does not fit
+     *         into the device or the device did not respond.
+     */
+    virtual int read(int addr, uint8_t *buffer, int len) = 0;
+
+    /**
+     * Writes <code>len</code> bytes from <code>buffer</code> starting at <code>addr</code>.
+     *
+     * @return the number of bytes written, which is less than <code>len</code> if the block does not
+     *         fit into the device or the device did not respond.
+     */
+    virtual int write(int addr, const uint8_t *buffer, int len) = 0;
+
+    virtual uint8_t read(int addr);
+    virtual void write(int addr, uint8_t value);
+
+    /**
+     * Commits the writes the device holds back. Devices that write through have nothing to do.
+     */
+    virtual void flush() {};
+
+    /**
+     * @return <code>true</code> if a block costs the same as a single byte, e.g. a page write or one bus
+     *         transfer, so unchanged bytes between changed ones can be written along with them;
+     *         <code>false</code> if every byte is a write cycle of its own.
+     */
+    virtual bool hasBlockWrites() { return false; };
+};
+
+#endif /* STORAGEDEVICE_H_ */
@@ -0,0 +1,169 @@
+/*
+ * WriteBackCache.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "WriteBackCache.h"
+#include "EEPROMStorage.h"
+
+// The number of bytes compared with the device in one read
+#define COMPARE_BLOCK 16
+
+WriteBackCache WriteBackCache::instance = WriteBackCache(&EEPROMStorage::instance);
+
+WriteBackCache::WriteBackCache(StorageDevice *device) {
+  _device = device;
+  _pending = 0;
+  _batchLevel = 0;
+  _writes = 0;
+  _savedWrites = 0;
+}
+
+void WriteBackCache::setDevice(StorageDevice *device) {
+  flush();
+  _device = device;
+}
+
+uint8_t WriteBackCache::read(int addr) {
+  int8_t index = find(addr);
+
+  if(index >= 0) {
+    return _value[index];
+  }
+
+  return _device->read(addr);
+}
+
+void WriteBackCache::write(int addr, uint8_t value) {
+  int8_t index = find(addr);
+
+  if(index >= 0) {
+    // Overwrites a value that was not committed yet
+    _value[index] = value;
+    _savedWrites++;
+    return;
+  }
+
+  if(_device->read(addr) == value) {
+    _savedWrites++;
+    return;
+  }
+
+  if(_batchLevel == 0) {
+    _device->write(addr, value);
+    _writes++;
+    return;
+  }
+
+  if(_pending == WRITEBACKCACHE_SIZE) {
+    flush();
+  }
+  _addr[_pending] = addr;
+  _value[_pending] = value;
+  _pending++;
+}
+
+int WriteBackCache::read(int addr, uint8_t *buffer, int len) {
+  len = _device->read(addr, buffer, len);
+
+  for(uint8_t i = 0; i < _pending; i++) {
+    if((_addr[i] >= addr) && (_addr[i] < addr + len)) {
+      buffer[_addr[i] - addr] = _value[i];
+    }
+  }
+
+  return len;
+}
+
+int WriteBackCache::write(int addr, const uint8_t *buffer, int len) {
+  if(_batchLevel > 0) {
+    for(int i = 0; i < len; i++) {
+      write(addr + i, buffer[i]);
+    }
+  }
+  else {
+    commit(addr, buffer, len);
+  }
+
+  return len;
+}
+
+void WriteBackCache::beginBatch() {
+  _batchLevel++;
+}
+
+void WriteBackCache::endBatch() {
+  if(_batchLevel > 0) {
+    _batchLevel--;
+    if(_batchLevel == 0) {
+      flush();
+    }
+  }
+}
+
+void WriteBackCache::flush() {
+  uint8_t block[WRITEBACKCACHE_SIZE];
+  uint8_t start = 0;
+  uint8_t len;
+
+  // Writes to consecutive addresses are committed as one block, in the order they were made
+  while(start < _pending) {
+    len = 0;
+    do {
+      block[len] = _value[start + len];
+      len++;
+    } while((start + len < _pending) && (_addr[start + len] == _addr[start] + len));
+
+    commit(_addr[start], block, len);
+    start += len;
+  }
+  _pending = 0;
+}
+
+void WriteBackCache::commit(int addr, const uint8_t *buffer, int len) {
+  uint8_t stored[COMPARE_BLOCK];
+  bool blocks = _device->hasBlockWrites();
+  int first = -1;
+  int last = -1;
+  int written = 0;
+  int chunk, received;
+
+  for(int i = 0; i < len; i += chunk) {
+    chunk = (len - i) > COMPARE_BLOCK ? COMPARE_BLOCK : len - i;
+    received = _device->read(addr + i, stored, chunk);
+    for(int j = 0; j < chunk; j++) {
+      // Bytes that could not be read are written
+      if((j >= received) || (stored[j] != buffer[i + j])) {
+        if(first < 0) {
+          first = i + j;
+        }
+        last = i + j;
+      }
+      else if(!blocks && (first >= 0)) {
+        // An unchanged byte ends the run, rewriting it would cost a write cycle
+        _device->write(addr + first, buffer + first, last - first + 1);
+        written += last - first + 1;
+        first = -1;
+      }
+    }
+  }
+
+  if(first >= 0) {
+    _device->write(addr + first, buffer + first, last - first + 1);
+    written += last - first + 1;
+  }
+  _writes += written;
+  _savedWrites += len - written;
+}
+
+int8_t WriteBackCache::find(int addr) {
+  for(uint8_t i = 0; i < _pending; i++) {
+    if(_addr[i] == addr) {
+      return i;
+    }
+  }
+
+  return -1;
+}
@@ -0,0 +1,113 @@
+/*
+ * WriteBackCache.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef WRITEBACKCACHE_H_
+#define WRITEBACKCACHE_H_
+
+#include "StorageDevice.h"
+
+#define STORAGE WriteBackCache::instance
+
+#ifndef WRITEBACKCACHE_SIZE
+#define WRITEBACKCACHE_SIZE 16
+#endif
+
+/**
+ * Write-back layer for a storage device, by default the internal EEPROM. Each EEPROM write takes
+ * ~3.3 ms and wears the cell, so
+ * <ul>
+ *  <li>a write of the value a byte already has is dropped and
+ *  <li>within a batch (<code>beginBatch</code> ... <code>endBatch</code>) writes are collected in RAM
+ *      and only the last value of each byte is committed with <code>flush</code>.
+ * </ul>
+ * Outside of a batch, a write that changes a byte goes to the EEPROM immediately. Reads always see
+ * the latest value, including values that have not been flushed yet. If more than
+ * <code>WRITEBACKCACHE_SIZE</code> different bytes are changed within a batch, the batch is flushed
+ * early. When the writes are committed, only the bytes that changed are written. On a device with
+ * block writes (see <code>StorageDevice::hasBlockWrites</code>) the span from the first to the last
+ * changed byte goes out as one block, so a page write needs one write cycle for it.
+ */
+class WriteBackCache: public StorageDevice {
+  public:
+    static WriteBackCache instance;
+
+    WriteBackCache(StorageDevice *device);
+
+    /**
+     * Changes the device the cache writes to. Pending writes are committed to the old device first.
+     */
+    void setDevice(StorageDevice *device);
+    StorageDevice *getDevice() { return _device; };
+
+    long size() { return _device->size(); };
+
+    uint8_t read(int addr);
+    void write(int addr, uint8_t value);
+
+    /**
+     * Reads a block in one transfer from the device. Values that have not been committed yet are
+     * taken from the cache.
+     */
+    int read(int addr, uint8_t *buffer, int len);
+
+    /**
+     * Writes a block. Outside of a batch only the changed bytes are written, see above. Within a batch
+     * the bytes are collected like single writes.
+     */
+    int write(int addr, const uint8_t *buffer, int len);
+
+    /**
+     * Starts collecting writes. Batches can be nested, the writes are committed when the outermost
+     * batch ends.
+     */
+    void beginBatch();
+    void endBatch();
+
+    /**
+     * Commits all collected writes to the device.
+     */
+    void flush();
+
+    /**
+     * @return the number of writes that have not been committed yet.
+     */
+    uint8_t pending() { return _pending; };
+
+    /**
+     * @return the number of bytes written to the device.
+     */
+    unsigned long writes() { return _writes; };
+
+    /**
+     * @return the number of writes that did not reach the device, because the value was already stored
+     *         or was overwritten before the flush.
+     */
+    unsigned long savedWrites() { return _savedWrites; };
+    void resetCounters() { _writes = _savedWrites = 0; };
+
+  private:
+    /**
+     * @return the index of the pending write for <code>addr</code> or <code>-1</code> if there is none.
+     */
+    int8_t find(int addr);
+
+    /**
+     * Writes the bytes of the block that differ from the device. Runs of changed bytes are written
+     * one by one, or, on a device with block writes, the span from the first to the last one at once.
+     */
+    void commit(int addr, const uint8_t *buffer, int len);
+
+    StorageDevice *_device;
+    int _addr[WRITEBACKCACHE_SIZE];
+    uint8_t _value[WRITEBACKCACHE_SIZE];
+    uint8_t _pending;
+    uint8_t _batchLevel;
+    unsigned long _writes;
+    unsigned long _savedWrites;
+};
+
+#endif /* WRITEBACKCACHE_H_ */
@@ -0,0 +1,134 @@
+#include <ArduinoUnit.h>
+#include <EEPROM.h>
+#include <Wire.h>
+#include <EEPROMStorage.h>
+#include <I2CEEPROMStorage.h>
+#include <WriteBackCache.h>
+
+// On the board a 24LC256 has to be connected to the I2C bus
+#ifndef __AVR__
+#include <SimI2C.h>
+SimI2CEEPROM simEEPROM;
+#endif
+
+TestSuite suite;
+
+#define MEM_ADDR 0x340
+#define PAGE_SIZE 64
+
+I2CEEPROMStorage i2cEEPROM(0x8000, PAGE_SIZE);
+
+void setup() {
+  Serial.begin(9600);
+  Wire.begin();
+#ifndef __AVR__
+  SimI2CBus::instance.attach(&simEEPROM);
+#endif
+  for(int i = 0; i < 64; i++) {
+    EEPROM.write(MEM_ADDR + i, 0);
+  }
+}
+
+void loop() {
+  suite.run();
+}
+
+test(eepromBlocks) {
+  uint8_t data[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+  uint8_t buffer[8];
+  long size = EEPROMStorage::instance.size();
+
+  assertEquals(8, EEPROMStorage::instance.write(MEM_ADDR, data, 8));
+  assertEquals(8, EEPROMStorage::instance.read(MEM_ADDR, buffer, 8));
+  for(int i = 0; i < 8; i++) {
+    assertEquals(data[i], buffer[i]);
+    assertEquals(data[i], EEPROM.read(MEM_ADDR + i));
+  }
+
+  // Blocks are cut at the end of the EEPROM
+  assertEquals(3, EEPROMStorage::instance.read(size - 3, buffer, 8));
+  assertEquals(0, EEPROMStorage::instance.read(size, buffer, 8));
+}
+
+test(cacheBlocks) {
+  uint8_t data[8] = { 0, 0, 9, 0, 0, 9, 0, 0 };
+  uint8_t buffer[8];
+
+  STORAGE.resetCounters();
+
+  // Only the changed bytes are written to the internal EEPROM
+  STORAGE.write(MEM_ADDR + 16, data, 8);
+  assertUnsignedLongEquals(2, STORAGE.writes());
+  assertUnsignedLongEquals(6, STORAGE.savedWrites());
+
+  // A device with page writes gets the span from the first to the last changed byte in one block
+  for(int i = 0; i < 8; i++) {
+    buffer[i] = 0;
+  }
+  assertEquals(8, i2cEEPROM.write(MEM_ADDR + 16, buffer, 8));
+  STORAGE.setDevice(&i2cEEPROM);
+  STORAGE.resetCounters();
+  STORAGE.write(MEM_ADDR + 16, data, 8);
+  assertUnsignedLongEquals(4, STORAGE.writes());
+  assertUnsignedLongEquals(4, STORAGE.savedWrites());
+  assertEquals(9, i2cEEPROM.read(MEM_ADDR + 21));
+  STORAGE.setDevice(&EEPROMStorage::instance);
+
+  // A block read sees the writes that are not committed yet
+  STORAGE.beginBatch();
+  STORAGE.write(MEM_ADDR + 19, 7);
+  assertEquals(8, STORAGE.read(MEM_ADDR + 16, buffer, 8));
+  assertEquals(9, buffer[2]);
+  assertEquals(7, buffer[3]);
+  assertEquals(0, EEPROM.read(MEM_ADDR + 19));
+  STORAGE.endBatch();
+  assertEquals(7, EEPROM.read(MEM_ADDR + 19));
+}
+
+test(i2cEEPROMPages) {
+  uint8_t data[100];
+  uint8_t buffer[100];
+  int addr = 3 * PAGE_SIZE - 10;
+
+  for(int i = 0; i < 100; i++) {
+    data[i] = i + 1;
+  }
+
+#ifndef __AVR__
+  simEEPROM.resetCounters();
+#endif
+  assertEquals(100, i2cEEPROM.write(addr, data, 100));
+#ifndef __AVR__
+  // 10 bytes up to the page boundary, then blocks of the size of the Wire buffer
+  assertUnsignedLongEquals(5, simEEPROM.writeCycles());
+#endif
+
+  assertEquals(100, i2cEEPROM.read(addr, buffer, 100));
+  for(int i = 0; i < 100; i++) {
+    assertEquals(data[i], buffer[i]);
+  }
+}
+
+test(cacheOnI2CEEPROM) {
+  WriteBackCache cache(&i2cEEPROM);
+  uint8_t data[4] = { 1, 2, 3, 4 };
+
+  i2cEEPROM.write(0x100, data, 4);
+  data[1] = 5;
+  data[2] = 6;
+
+  // Consecutive writes of a batch are committed in one page write
+#ifndef __AVR__
+  simEEPROM.resetCounters();
+#endif
+  cache.beginBatch();
+  for(int i = 0; i < 4; i++) {
+    cache.write(0x100 + i, data[i]);
+  }
+  cache.endBatch();
+  assertUnsignedLongEquals(2, cache.writes());
+#ifndef __AVR__
+  assertUnsignedLongEquals(1, simEEPROM.writeCycles());
+#endif
+  assertEquals(6, i2cEEPROM.read(0x102));
+}
@@ -0,0 +1,99 @@
+#include <ArduinoUnit.h>
+#include <EEPROM.h>
+#include <WriteBackCache.h>
+
+TestSuite suite;
+
+#define MEM_ADDR 0x300
+
+void setup() {
+  Serial.begin(9600);
+  for(int i = 0; i < 64; i++) {
+    EEPROM.write(MEM_ADDR + i, 0);
+  }
+}
+
+void loop() {
+  suite.run();
+}
+
+test(unchangedValuesAreNotWritten) {
+  STORAGE.resetCounters();
+
+  STORAGE.write(MEM_ADDR, 0);
+  STORAGE.write(MEM_ADDR + 1, 0);
+  assertUnsignedLongEquals(0, STORAGE.writes());
+  assertUnsignedLongEquals(2, STORAGE.savedWrites());
+
+  // Outside of a batch, a change is written immediately
+  STORAGE.write(MEM_ADDR, 5);
+  assertUnsignedLongEquals(1, STORAGE.writes());
+  assertEquals(5, EEPROM.read(MEM_ADDR));
+  assertEquals(5, STORAGE.read(MEM_ADDR));
+  assertEquals(0, STORAGE.pending());
+}
+
+test(batch) {
+  STORAGE.resetCounters();
+
+  STORAGE.beginBatch();
+  for(int value = 1; value <= 10; value++) {
+    for(int i = 0; i < 8; i++) {
+      STORAGE.write(MEM_ADDR + 8 + i, value);
+    }
+  }
+  // Nothing is written yet, but the new values can be read
+  assertUnsignedLongEquals(0, STORAGE.writes());
+  assertEquals(8, STORAGE.pending());
+  assertEquals(0, EEPROM.read(MEM_ADDR + 8));
+  assertEquals(10, STORAGE.read(MEM_ADDR + 8));
+
+  // A nested batch does not commit
+  STORAGE.beginBatch();
+  STORAGE.write(MEM_ADDR + 16, 1);
+  STORAGE.endBatch();
+  assertEquals(9, STORAGE.pending());
+
+  // A value changed back to what is stored is not written
+  STORAGE.write(MEM_ADDR + 16, 0);
+  STORAGE.endBatch();
+
+  assertEquals(0, STORAGE.pending());
+  assertUnsignedLongEquals(8, STORAGE.writes());
+  for(int i = 0; i < 8; i++) {
+    assertEquals(10, EEPROM.read(MEM_ADDR + 8 + i));
+  }
+  assertEquals(0, EEPROM.read(MEM_ADDR + 16));
+}
+
+test(batchOverflow) {
+  STORAGE.resetCounters();
+
+  STORAGE.beginBatch();
+  for(int i = 0; i < WRITEBACKCACHE_SIZE + 4; i++) {
+    STORAGE.write(MEM_ADDR + 24 + i, i + 1);
+  }
+  // The full cache was flushed
+  assertUnsignedLongEquals(WRITEBACKCACHE_SIZE, STORAGE.writes());
+  assertEquals(4, STORAGE.pending());
+  STORAGE.endBatch();
+
+  assertUnsignedLongEquals(WRITEBACKCACHE_SIZE + 4, STORAGE.writes());
+  for(int i = 0; i < WRITEBACKCACHE_SIZE + 4; i++) {
+    assertEquals(i + 1, STORAGE.read(MEM_ADDR + 24 + i));
+  }
+}
+
+// The internal EEPROM writes byte by byte, so an unchanged byte between changed ones is not rewritten
+test(blockSkipsUnchangedBytes) {
+  uint8_t block[5] = { 1, 2, 0, 0, 3 };
+
+  STORAGE.resetCounters();
+  STORAGE.write(MEM_ADDR + 48, block, 5);
+
+  assertUnsignedLongEquals(3, STORAGE.writes());
+  assertUnsignedLongEquals(2, STORAGE.savedWrites());
+  for(int i = 0; i < 5; i++) {
+    assertEquals(block[i], EEPROM.read(MEM_ADDR + 48 + i));
+  }
+}
@@ -9,7 +9,7 @@
 #include "TemperatureProfileManager.h"
 #include "TemperatureProfile.h"
 #include <Time.h>
-#include <EEPROM.h>
+#include <WriteBackCache.h>
 
 TemperatureManager TemperatureManager::instance = TemperatureManager();
 
@@ -20,9 +20,16 @@ void TemperatureManager::setMemoryInfo(int addr) {
   instance.load();
 };
 
+int TemperatureManager::getMemorySize() {
+  // Time of year, vacation temperatures and the profile ids, the timeline is not stored
+  return 3 + MAX_DAYS * MAX_TIME_OF_DAY * MAX_TIME_OF_YEAR;
+}
+
 TemperatureManager::TemperatureManager() {
   _timeOfYear = SUMMER;
   _amBegin = 6;
+  _timelineValid = false;
+  _timelineProfileChanges = 0;
 }
 
 void TemperatureManager::clear() {
@@ -33,142 +40,149 @@ void TemperatureManager::clear() {
       }
     }
   }
+  _timelineValid = false;
   save();
 }
 
 
 time_t TemperatureManager::nextSetPointChange(time_t now) {
-  int index;
-  int time = -1, temperature;
-  tmElements_t nowTE, nextTE;
-  time_t changeTime = 0;
+  int halfDay, quarter, index;
+  long secondsOfHalfDay;
+  time_t halfDayStart;
+
+  compileTimeline();
 
   // We need to correct the time to offset the shift in AM/PM profiles
   // Profiles don't start at 12 AM, they start at 12 AM + _amBegin
   // the offset allows to find the correct profiles.
   now = adjustTime(now);
 
-  // Break time into its elements
-  //This is nasty, but what to do at this point
-  breakTime(now, nowTE);
+  halfDay = halfDayOf(now);
+  if(_timelineMissing & (1 << halfDay)) {
+    return 0;
+  }
 
-  if(loadProfile(nowTE)) {
-    // Get the index that matches exact or is larger
-    index = TPROFILE.indexOf(timeToQuarterHour(nowTE, true), 1);
-    if(index >= 0) {
-      TPROFILE.getAt(index, time, temperature);
-    }
-    else {
-      // We need the next profile
-      breakTime(now + 12L * 3600L, nowTE);
-      if (loadProfile(nowTE)) {
-        // All we need is the first entry
-        TPROFILE.getAt(0, time, temperature);
-        // B/c this is the next profile, we need to add 12 hrs to it
-      }
-    }
+  secondsOfHalfDay = elapsedSecsToday(now) % SECS_PER_HALF_DAY;
+  halfDayStart = now - secondsOfHalfDay;
+
+  // The first quarter hour that starts at or after now
+  quarter = (secondsOfHalfDay + SECS_PER_QUARTER_HOUR - 1) / SECS_PER_QUARTER_HOUR;
+  index = findChangeAtOrBefore(halfDay, quarter);
+  if(index < 0) {
+    index = _timelineIndex[halfDay];
+  }
+  else if(_timeline[index][TIME] < quarter) {
+    // The change after the one found
+    index++;
   }
 
-  if(time != -1) {
-    // The change time is the time given minus offset (find the the beginning time of the profile)
-    // plus the time found in the profile (time 15 minutes).
-    changeTime = makeTime(nowTE) - calcTimeOffset(nowTE) + time * 15L * 60L + (long)_amBegin * 3600L;
+  if(index >= _timelineIndex[halfDay + 1]) {
+    // We need the next half day, all we need is its first entry
+    halfDay = (halfDay + 1) % HALF_DAYS_PER_WEEK;
+    index = _timelineIndex[halfDay];
+    if((_timelineMissing & (1 << halfDay)) || (index == _timelineIndex[halfDay + 1])) {
+      return 0;
+    }
+    halfDayStart += SECS_PER_HALF_DAY;
   }
 
-  return changeTime;
+  // The beginning of the half day plus the time found in the profile (time 15 minutes), moved
+  // back into the time zone of the clock.
+  return halfDayStart + _timeline[index][TIME] * (long)SECS_PER_QUARTER_HOUR + (long)_amBegin * 3600L;
 }
 
 int TemperatureManager::getSetPointFor(time_t timeInSeconds) {
-  int time, temperature, index;
-  tmElements_t te;
+  int halfDay, index;
 
-  // Initialize with failure of obtaining a temperature
-  temperature = -1;
+  compileTimeline();
 
   timeInSeconds = adjustTime(timeInSeconds);
 
-  // Break the time into its elements
-  breakTime(timeInSeconds, te);
-  /*Serial.print(millis());
-  Serial.print("|Time: ");
-  Serial.print(te.Day, DEC);
-  Serial.print("-");
-  Serial.print(te.Hour, DEC);
-  Serial.print(":");
-  Serial.print(te.Minute, DEC);
-  Serial.print(":");
-  Serial.print(te.Second, DEC);*/
-
-  if(loadProfile(te)) {
-
-    index = TPROFILE.indexOf(timeToQuarterHour(te, false), -1);
-    if(index >= 0) {
-      TPROFILE.getAt(index, time, temperature);
-    }
-    else {
-      // This means we need the previous profile
-      breakTime(timeInSeconds - 12L * 3600L, te);
-      if(loadProfile(te)) {
-        // All we need is the last entry
-        TPROFILE.getAt(TPROFILE.size() - 1, time, temperature);
-      }
+  halfDay = halfDayOf(timeInSeconds);
+  if(_timelineMissing & (1 << halfDay)) {
+    return -1;
+  }
+
+  index = findChangeAtOrBefore(halfDay, (elapsedSecsToday(timeInSeconds) % SECS_PER_HALF_DAY) / SECS_PER_QUARTER_HOUR);
+  if(index < 0) {
+    // This means we need the previous half day, all we need is its last entry
+    halfDay = (halfDay + HALF_DAYS_PER_WEEK - 1) % HALF_DAYS_PER_WEEK;
+    if((_timelineMissing & (1 << halfDay)) || (_timelineIndex[halfDay] == _timelineIndex[halfDay + 1])) {
+      return -1;
     }
-    /*
-    Serial.print(", Profile Info:");
-    Serial.print(TPROFILE.getId());
-    Serial.print("-");
-    Serial.print(time);
-    Serial.print("-");
-    Serial.println(temperature);
-    */
+    index = _timelineIndex[halfDay + 1] - 1;
   }
 
-  return temperature;
+  return _timeline[index][TEMPERATURE];
 }
 
-bool TemperatureManager::loadProfile(tmElements_t &te) {
-  int profileId;
-
-  // Get the id of the profile that applies to the given time
-  profileId = getTemperatureProfileID(te);
-  //Serial.print("Profile id");
-  //Serial.println(profileId);
-  if(profileId >= 0) {
-    // Load the profile into memory
-    if(TPM.load(profileId)) {
-      return true;
+void TemperatureManager::compileTimeline() {
+  int time, temperature, profileId;
+  uint8_t size = 0;
+
+  if(_timelineValid && (_timelineProfileChanges == TPM.changeCount())) {
+    return;
+  }
+
+  _timelineMissing = 0;
+  for(int halfDay = 0; halfDay < HALF_DAYS_PER_WEEK; halfDay++) {
+    _timelineIndex[halfDay] = size;
+
+    profileId = _profiles[halfDay / 2][halfDay % 2][_timeOfYear];
+    if((profileId >= 0) && TPM.load(profileId)) {
+      // The entries of a profile are sorted by time
+      for(int i = 0; i < TPROFILE.size(); i++, size++) {
+        TPROFILE.getAt(i, time, temperature);
+        _timeline[size][TIME] = time;
+        _timeline[size][TEMPERATURE] = temperature;
+      }
+    }
+    else {
+      _timelineMissing |= 1 << halfDay;
     }
   }
-  Serial.println("... loading failed");
+  _timelineIndex[HALF_DAYS_PER_WEEK] = size;
 
-  return false;
+  _timelineProfileChanges = TPM.changeCount();
+  _timelineValid = true;
 }
 
-int TemperatureManager::getTemperatureProfileID(tmElements_t &te) {
-  int ampm = PM;
+int TemperatureManager::findChangeAtOrBefore(int halfDay, int quarter) {
+  int low = _timelineIndex[halfDay];
+  int high = _timelineIndex[halfDay + 1] - 1;
+  int found = -1;
 
-  if(te.Hour < 12){
-    ampm = AM;
+  while(low <= high) {
+    int middle = (low + high) / 2;
+
+    if(_timeline[middle][TIME] <= quarter) {
+      found = middle;
+      low = middle + 1;
+    }
+    else {
+      high = middle - 1;
+    }
   }
 
-  return _profiles[te.Wday - 1][ampm][_timeOfYear];
+  return found;
 }
 
 bool TemperatureManager::load() {
   int addr = _memoryAddr;
   if(addr >= 0) {
-    _timeOfYear = (int8_t)EEPROM.read(addr++);
-    _vacationTemperature[SUMMER] = (int8_t)EEPROM.read(addr++);
-    _vacationTemperature[WINTER] = (int8_t)EEPROM.read(addr++);
+    _timeOfYear = (int8_t)STORAGE.read(addr++);
+    _vacationTemperature[SUMMER] = (int8_t)STORAGE.read(addr++);
+    _vacationTemperature[WINTER] = (int8_t)STORAGE.read(addr++);
 
     for(int i = 0; i < MAX_DAYS; i++) {
       for(int j = 0; j < MAX_TIME_OF_DAY; j ++) {
         for(int k = 0; k < MAX_TIME_OF_YEAR; k++) {
-          _profiles[i][j][k] = (int8_t)EEPROM.read(addr++);
+          _profiles[i][j][k] = (int8_t)STORAGE.read(addr++);
         }
       }
     }
 
+    _timelineValid = false;
     return true;
   }
 
@@ -179,14 +193,14 @@ bool TemperatureManager::save() {
   int addr = _memoryAddr;
 
   if(addr >= 0) {
-    EEPROM.write(addr++, _timeOfYear);
-    EEPROM.write(addr++, _vacationTemperature[SUMMER]);
-    EEPROM.write(addr++, _vacationTemperature[WINTER]);
+    STORAGE.write(addr++, _timeOfYear);
+    STORAGE.write(addr++, _vacationTemperature[SUMMER]);
+    STORAGE.write(addr++, _vacationTemperature[WINTER]);
 
     for(int i = 0; i < MAX_DAYS; i++) {
       for(int j = 0; j < MAX_TIME_OF_DAY; j ++) {
         for(int k = 0; k < MAX_TIME_OF_YEAR; k++) {
-          EEPROM.write(addr++, _profiles[i][j][k]);
+          STORAGE.write(addr++, _profiles[i][j][k]);
         }
       }
     }
@@ -227,28 +241,6 @@ void TemperatureManager::printDebug() {
 
 
 
-long TemperatureManager::calcTimeOffset(tmElements_t &te) {
-  int hourCorrection = 12;
-
-  if(te.Hour < 12) {
-    hourCorrection = 0;
-  }
-
-  return (te.Hour - hourCorrection) * 3600L + te.Minute * 60L + te.Second;
-}
-
 time_t TemperatureManager::adjustTime(time_t time) {
   return time - (((long)_amBegin) * 3600L);
 }
-
-
-int TemperatureManager::timeToQuarterHour(tmElements_t &te, bool roundUp) {
-  int time = te.Hour * 4 + te.Minute / 15;
-
-  if(roundUp && (te.Second > 0)) {
-    time++;
-  }
-
-  return time > 47 ? time - 48 : time;
-}
-
@@ -10,6 +10,7 @@
 
 #include <WProgram.h>
 #include <Time.h>
+#include "TemperatureProfile.h"
 
 #define TEMPMGR TemperatureManager::instance
 /**
@@ -19,7 +20,7 @@ class TemperatureManager {
   public:
     static TemperatureManager instance;
     static void setMemoryInfo(int addr);
-    static int getMemorySize() { return sizeof(TemperatureManager); };
+    static int getMemorySize();
 
     enum Days { SUNDAY = 0, MONDAY = 1, TUESDAY = 2, WEDNESDAY = 3, THURSDAY = 4, FRIDAY = 5, SATURDAY = 6, HOLIDAY = 7 , MAX_DAYS};
     enum TimeOfDay { AM = 0, PM = 1 , MAX_TIME_OF_DAY };
@@ -27,6 +28,7 @@ class TemperatureManager {
 
     bool setProfile(int profile, Days day, TimeOfDay timeOfDay, TimeOfYear timeOfYear) {
       _profiles[day][timeOfDay][timeOfYear] = profile;
+      _timelineValid = false;
       return save();
     };
 
@@ -45,11 +47,17 @@ class TemperatureManager {
 
     void setTimeOfYear(TimeOfYear timeOfYear) {
       _timeOfYear = timeOfYear;
+      _timelineValid = false;
       save();
     };
 
     TimeOfYear getTimeOfYear() { return (TimeOfYear) _timeOfYear; };
 
+    /**
+     * Returns the time of the next set point change at or after <code>now</code>. Only the profiles
+     * of the current and the next half day are considered.
+     * @return the time of the next set point change or <code>0</code> if there is none.
+     */
     time_t nextSetPointChange(time_t now);
     /**
      * Returns the set point for the given time.
@@ -57,6 +65,12 @@ class TemperatureManager {
      */
     int getSetPointFor(time_t timeInSeconds);
 
+    /**
+     * Forces the timeline to be compiled again with the next set point lookup. Changes to the schedule
+     * and profiles saved through <code>TPM</code> are detected automatically.
+     */
+    void invalidateTimeline() { _timelineValid = false; };
+
     /**
      * Clears all entries and saves it to the
      */
@@ -66,16 +80,27 @@ class TemperatureManager {
 
   private:
     TemperatureManager();
+    enum { HALF_DAYS_PER_WEEK = 14, SECS_PER_HALF_DAY = 12 * 3600L, SECS_PER_QUARTER_HOUR = 15 * 60 };
+
     bool load();
     bool save();
-    int getTemperatureProfileID(tmElements_t &te);
-    bool loadProfile(tmElements_t &te);
-    int timeToQuarterHour(tmElements_t &te, bool roundUp);
 
     /**
-     * Calculates the hours, minutes, and seconds of the given time in seconds and returns it.
+     * Compiles the profiles of the current time of year for every half day of the week into the timeline
+     * if the schedule or a profile changed since it was compiled the last time.
      */
-    long calcTimeOffset(tmElements_t &te);
+    void compileTimeline();
+
+    /**
+     * @return the index of the half day of the week (0 is Sunday AM) of the given adjusted time.
+     */
+    int halfDayOf(time_t time) { return (dayOfWeek(time) - 1) * 2 + (elapsedSecsToday(time) >= SECS_PER_HALF_DAY); };
+
+    /**
+     * Binary search for the last set point change of the given half day at or before <code>quarter</code>.
+     * @return the index into <code>_timeline</code> or <code>-1</code> if there is none.
+     */
+    int findChangeAtOrBefore(int halfDay, int quarter);
     /**
      * Subtracts <code>_amBegin</code> from the given time to adjust for when "AM" begins from a temperature
      * profile management perspective. In other words, it moves the time to the day change, e.g. the PM time
@@ -97,6 +122,18 @@ class TemperatureManager {
     int8_t _amBegin;
     int8_t _profiles[MAX_DAYS][MAX_TIME_OF_DAY][MAX_TIME_OF_YEAR];
     int8_t _vacationTemperature[MAX_TIME_OF_YEAR];
+
+    /**
+     * The set point changes of the whole week, i.e. the entries of the profiles of every half day in the order
+     * of the week. The entries of half day <code>h</code> are <code>_timeline[_timelineIndex[h]]</code> up to
+     * (excluding) <code>_timeline[_timelineIndex[h + 1]]</code>. Half days without a profile have their bit set
+     * in <code>_timelineMissing</code>.
+     */
+    int8_t _timeline[HALF_DAYS_PER_WEEK * TemperatureProfile::MAX_SIZE][2];
+    uint8_t _timelineIndex[HALF_DAYS_PER_WEEK + 1];
+    uint16_t _timelineMissing;
+    bool _timelineValid;
+    unsigned int _timelineProfileChanges;
 };
 
 #endif /* TEMPERATUREMANAGER_H_ */
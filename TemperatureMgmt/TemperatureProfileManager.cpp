@@ -4,43 +4,57 @@
  *  Created on: Jul 16, 2011
  *      Author: john wulf
  *
- *  TODO: Make the storage mechanism flexible.
- *
  *  TODO: Error handling for fundamental storage
  */
 
 #include "TemperatureProfileManager.h"
 #include "TemperatureProfile.h"
-#include <EEPROM.h>
+#include <WriteBackCache.h>
 
 #define EMPTY_PROFILE_MARKER -1
 
+// Offsets of the fields of a record
+#define RECORD_SEQUENCE 0
+#define RECORD_ID 4
+#define RECORD_SIZE_OFFSET 5
+#define RECORD_NAME 6
+#define RECORD_ENTRIES (RECORD_NAME + MAX_NAME_SIZE)
+#define RECORD_CRC (RECORD_SIZE - 1)
+
+StorageDevice *TemperatureProfileManager::_storage = &STORAGE;
 int TemperatureProfileManager::_memoryAdr = -1;
 int TemperatureProfileManager::_memorySize = -1;
-int TemperatureProfileManager::_memoryBlockSize = -1;
+int TemperatureProfileManager::_slotCount = 0;
 int TemperatureProfileManager::_maxNumOfProfiles = 0;
 
 TemperatureProfileManager TemperatureProfileManager::instance = TemperatureProfileManager();
 
-void TemperatureProfileManager::setMemoryInfo(int start, int profileCount) {
+void TemperatureProfileManager::setMemoryInfo(int start, int profileCount, int slotCount) {
   if((start >= 0) && (profileCount > 0)) {
-    // TODO: We need to manage increases and decreases
-    //       for now we assume that nothing changes and this is
-    //       initialized always with the same size.
-    //       The thing really is, writing a simple file system/memory
-    //       management service that can work on any external storage
-    //       and not just the EEPROM. Next library after I am done with
-    //       the HVAC board.
+    if(profileCount > TEMPERATUREPROFILE_MAX_PROFILES) {
+      profileCount = TEMPERATUREPROFILE_MAX_PROFILES;
+    }
+    if(slotCount <= profileCount) {
+      // One more slot than profiles is the minimum, so there is always a slot for the new version
+      slotCount = slotCount == 0 ? 2 * profileCount : profileCount + 1;
+    }
+    if(slotCount > 255) {
+      slotCount = 255;
+    }
     _memoryAdr = start;
     _maxNumOfProfiles = profileCount;
-    _memoryBlockSize = sizeof(TemperatureProfile);
-    _memorySize = profileCount * _memoryBlockSize;
+    _slotCount = slotCount;
+    _memorySize = slotCount * RECORD_SIZE;
+    instance.buildIndex();
+    instance._changeCount++;
   }
 }
 
 TemperatureProfileManager::TemperatureProfileManager() {
-  // TODO Auto-generated constructor stub
-
+  _changeCount = 0;
+  _indexSize = 0;
+  _head = 0;
+  _sequence = 0;
 }
 
 TemperatureProfile& TemperatureProfileManager::getProfile() {
@@ -48,35 +62,27 @@ TemperatureProfile& TemperatureProfileManager::getProfile() {
 }
 
 bool TemperatureProfileManager::load(int id) {
-  int addr, size, time, temperature, i;
-
-  if(isInitialized()) {
-    addr = find(id);
-
-    if(addr >= 0) {
-      // This all just assumes sunny day scenario, i.e. no corruption
-      _profile.clear();
-
-      // Profile id
-      _profile.setId(readByte(addr++));
-
-      // Size of the profile
-      size = readByte(addr++);
-
-      // Name of the profile
-      for(i = 0; i < MAX_NAME_SIZE; i++, addr++) {
-        _profile.getName()[i] = readByte(addr);
-      }
-
-      // Read the time/temperature value pairs
-      for(i = 0; i < size; i++) {
-        time = readByte(addr++);
-        temperature = readByte(addr++);
-        _profile.add(time, temperature);
-      }
+  uint8_t record[RECORD_SIZE];
+  unsigned long sequence;
+  int i;
+  int index = find(id);
+
+  // The whole record is read in one block
+  if((index >= 0) && readRecord(_indexSlots[index], record, sequence)) {
+    _profile.clear();
+    _profile.setId((int8_t)record[RECORD_ID]);
+
+    // Name of the profile
+    for(i = 0; i < MAX_NAME_SIZE; i++) {
+      _profile.getName()[i] = record[RECORD_NAME + i];
+    }
 
-      return true;
+    // The time/temperature value pairs
+    for(i = 0; i < record[RECORD_SIZE_OFFSET]; i++) {
+      _profile.add((int8_t)record[RECORD_ENTRIES + 2 * i], (int8_t)record[RECORD_ENTRIES + 2 * i + 1]);
     }
+
+    return true;
   }
 
   return false;
@@ -84,61 +90,89 @@ bool TemperatureProfileManager::load(int id) {
 
 
 bool TemperatureProfileManager::save() {
-  int addr, time, temperature, i;
-
-   if(isInitialized()) {
-     addr = find(_profile.getId());
-
-     if(addr < 0) {
-       // No existing profile with the defined id
-       // So, let's see if we have space
-       addr = find(EMPTY_PROFILE_MARKER);
-     }
+  uint8_t record[RECORD_SIZE];
+  int addr, slot, index, time, temperature, i;
+  int8_t id = _profile.getId();
 
-     if(addr >= 0) {
-       writeByte(addr++, _profile.getId());
-
-       // Size of the profile
-       writeByte(addr++, _profile.size());
+  if(!isInitialized() || (id == EMPTY_PROFILE_MARKER)) {
+    return false;
+  }
 
-       for(i = 0; i < MAX_NAME_SIZE; i++, addr++) {
-         writeByte(addr, _profile.getName()[i]);
-       }
+  index = find(id);
+  if((index < 0) && (_indexSize >= _maxNumOfProfiles)) {
+    // No existing profile with the defined id and no space for a new one
+    return false;
+  }
 
-       // Read the time/temperature value pairs
-       for(i = 0; i < _profile.size(); i++) {
-         _profile.getAt(i, time, temperature);
-         writeByte(addr++, time);
-         writeByte(addr++, temperature);
-       }
+  _changeCount++;
+  slot = nextFreeSlot();
+  addr = slotAddress(slot);
 
-       return true;
-     }
-   }
+  _sequence++;
+  for(i = 0; i < 4; i++) {
+    record[RECORD_SEQUENCE + i] = (_sequence >> (8 * i)) & 0xff;
+  }
+  record[RECORD_SIZE_OFFSET] = _profile.size();
+  for(i = 0; i < MAX_NAME_SIZE; i++) {
+    record[RECORD_NAME + i] = _profile.getName()[i];
+  }
+  for(i = 0; i < _profile.size(); i++) {
+    _profile.getAt(i, time, temperature);
+    record[RECORD_ENTRIES + 2 * i] = time;
+    record[RECORD_ENTRIES + 2 * i + 1] = temperature;
+  }
+  record[RECORD_CRC] = recordCrc(record, id);
+
+  // Everything but the id, as long as the id is missing, the record is not valid. The slot
+  // could hold the remains of a save that failed. The unused entries are not written.
+  releaseSlot(slot);
+  _storage->write(addr + RECORD_SEQUENCE, record + RECORD_SEQUENCE, 4);
+  _storage->write(addr + RECORD_SIZE_OFFSET, record + RECORD_SIZE_OFFSET,
+      RECORD_ENTRIES + 2 * _profile.size() - RECORD_SIZE_OFFSET);
+  _storage->write(addr + RECORD_CRC, record[RECORD_CRC]);
+
+  // Commit. The storage may hold writes back, e.g. within a batch of the WriteBackCache, and would
+  // then commit the id together with the rest of the record, so the record goes to the device first.
+  _storage->flush();
+  _storage->write(addr + RECORD_ID, id);
+
+  if(index >= 0) {
+    releaseSlot(_indexSlots[index]);
+  }
+  else {
+    index = _indexSize++;
+    _indexIds[index] = id;
+  }
+  _indexSlots[index] = slot;
+  _head = (slot + 1) % _slotCount;
 
-   return false;
+  return true;
 }
 
 bool TemperatureProfileManager::remove() {
-  if(isInitialized()) {
-    int addr = find(_profile.getId());
+  int index = find(_profile.getId());
 
-    if(addr >= 0) {
-      writeByte(addr, EMPTY_PROFILE_MARKER);
-      return true;
-    }
+  if(index >= 0) {
+    _changeCount++;
+    releaseSlot(_indexSlots[index]);
+
+    // Keep the index compact
+    _indexSize--;
+    _indexIds[index] = _indexIds[_indexSize];
+    _indexSlots[index] = _indexSlots[_indexSize];
+    return true;
   }
+
   return false;
 }
 
 bool TemperatureProfileManager::format() {
-  int addr = _memoryAdr;
-
   if(isInitialized()) {
-    for(int i = 0; i < _maxNumOfProfiles; i++, addr += _memoryBlockSize) {
-      // All we got to do is mark each record with -1.
-      writeByte(addr, EMPTY_PROFILE_MARKER);
+    _changeCount++;
+    for(int slot = 0; slot < _slotCount; slot++) {
+      releaseSlot(slot);
     }
+    _indexSize = 0;
     return true;
   }
 
@@ -146,34 +180,63 @@ bool TemperatureProfileManager::format() {
 }
 
 int TemperatureProfileManager::freeSpace() {
-  int addr = _memoryAdr;
-  int empty = -1;
-
   if(isInitialized()) {
-    empty = 0;
-    for(int i = 0; i < _maxNumOfProfiles; i++, addr += _memoryBlockSize) {
-      if(readByte(addr) == EMPTY_PROFILE_MARKER) {
-        empty++;
-      }
-    }
+    return _maxNumOfProfiles - _indexSize;
   }
 
-  return empty;
+  return -1;
 }
 
 // ------------------------------------------------------
 // Private methods
 //
 
-int TemperatureProfileManager::find(int id) {
-  int addr = _memoryAdr;
+void TemperatureProfileManager::buildIndex() {
+  uint8_t record[RECORD_SIZE];
+  unsigned long sequence, otherSequence;
+  unsigned long maxSequence = 0;
+  int index;
 
-  if(isInitialized()) {
-    for(int i = 0; i < _maxNumOfProfiles; i++, addr += _memoryBlockSize) {
-      if(readByte(addr) == id) {
-        // don't like this, return out of a for loop.
-        // not really clean, but code efficient.
-        return addr;
+  _indexSize = 0;
+  _head = 0;
+
+  for(int slot = 0; slot < _slotCount; slot++) {
+    if(!readRecord(slot, record, sequence)) {
+      continue;
+    }
+
+    if(sequence >= maxSequence) {
+      maxSequence = sequence;
+      _head = (slot + 1) % _slotCount;
+    }
+
+    index = find((int8_t)record[RECORD_ID]);
+    if(index >= 0) {
+      // The power failed during a save, keep the newer version
+      readRecord(_indexSlots[index], record, otherSequence);
+      if(otherSequence < sequence) {
+        releaseSlot(_indexSlots[index]);
+        _indexSlots[index] = slot;
+      }
+      else {
+        releaseSlot(slot);
+      }
+    }
+    else if(_indexSize < _maxNumOfProfiles) {
+      _indexIds[_indexSize] = (int8_t)record[RECORD_ID];
+      _indexSlots[_indexSize] = slot;
+      _indexSize++;
+    }
+  }
+
+  _sequence = maxSequence;
+}
+
+int TemperatureProfileManager::find(int id) {
+  if(isInitialized() && (id != EMPTY_PROFILE_MARKER)) {
+    for(int i = 0; i < _indexSize; i++) {
+      if(_indexIds[i] == id) {
+        return i;
       }
     }
   }
@@ -181,12 +244,73 @@ int TemperatureProfileManager::find(int id) {
   return -1;
 }
 
-inline int8_t TemperatureProfileManager::readByte(int addr) {
-  return (int8_t) EEPROM.read(addr);
+int TemperatureProfileManager::nextFreeSlot() {
+  int slot = _head;
+
+  // There are more slots than profiles, so this always ends
+  while(isUsed(slot)) {
+    slot = (slot + 1) % _slotCount;
+  }
+
+  return slot;
+}
+
+bool TemperatureProfileManager::isUsed(int slot) {
+  for(int i = 0; i < _indexSize; i++) {
+    if(_indexSlots[i] == slot) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+bool TemperatureProfileManager::readRecord(int slot, uint8_t *record, unsigned long &sequence) {
+  int8_t id;
+
+  if(_storage->read(slotAddress(slot), record, RECORD_SIZE) != RECORD_SIZE) {
+    return false;
+  }
+
+  id = (int8_t)record[RECORD_ID];
+  if((id == EMPTY_PROFILE_MARKER) || (record[RECORD_SIZE_OFFSET] > TemperatureProfile::MAX_SIZE) ||
+     (record[RECORD_CRC] != recordCrc(record, id))) {
+    return false;
+  }
+
+  sequence = 0;
+  for(int i = 3; i >= 0; i--) {
+    sequence = (sequence << 8) | record[RECORD_SEQUENCE + i];
+  }
+
+  return true;
+}
+
+/**
+ * CRC-8 (polynomial x^8 + x^5 + x^4 + 1) over the record without the CRC. The id is passed, as it is
+ * written after the CRC.
+ */
+uint8_t TemperatureProfileManager::recordCrc(const uint8_t *record, int8_t id) {
+  int size = record[RECORD_SIZE_OFFSET];
+  uint8_t crc = 0;
+
+  if(size > TemperatureProfile::MAX_SIZE) {
+    size = TemperatureProfile::MAX_SIZE;
+  }
+
+  // Only the used entries are covered, the others are not written
+  for(int i = 0; i < RECORD_ENTRIES + 2 * size; i++) {
+    crc ^= i == RECORD_ID ? (uint8_t)id : record[i];
+    for(uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ 0x31 : crc << 1;
+    }
+  }
+
+  return crc;
 }
 
-inline void TemperatureProfileManager::writeByte(int addr, int8_t value) {
-  EEPROM.write(addr, value);
+void TemperatureProfileManager::releaseSlot(int slot) {
+  _storage->write(slotAddress(slot) + RECORD_ID, (uint8_t)EMPTY_PROFILE_MARKER);
 }
 
 inline bool TemperatureProfileManager::isInitialized() {
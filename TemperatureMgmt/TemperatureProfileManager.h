@@ -11,21 +11,59 @@
 #define TEMPERATUREPROFILEMANAGER_H_
 
 #include <WProgram.h>
+#include <StorageDevice.h>
 
 #define TPM TemperatureProfileManager::instance
 
 #define TPROFILE TemperatureProfileManager::instance.getProfile()
 
+// The maximum number of profiles, which defines the size of the in-RAM index
+#ifndef TEMPERATUREPROFILE_MAX_PROFILES
+#define TEMPERATUREPROFILE_MAX_PROFILES 16
+#endif
+
+/**
+ * Stores the profiles in a log in the EEPROM. The memory is divided into slots of
+ * <code>RECORD_SIZE</code> bytes, each holding one version of a profile:
+ * <pre>
+ *   sequence number (4 bytes) | id | size | name | time/set point pairs | CRC-8
+ * </pre>
+ * A save never overwrites the current version of a profile. It writes the new version into the next
+ * free slot of the log, the id last, and only then releases the slot of the previous version by setting
+ * its id to <code>-1</code>. If the power fails during a save, either the old or the new version
+ * survives: a partially written record has no id or fails the CRC and if both versions survive, the one
+ * with the higher sequence number wins. The slots are used round robin, so the writes are spread over
+ * the whole region instead of wearing out the slots of the profiles that change most.
+ * <p>
+ * The slots of all profiles are kept in an index in RAM, which is built once by <code>setMemoryInfo</code>.
+ * <p>
+ * By default the log lives in the EEPROM, behind the write-back cache (<code>STORAGE</code>). Any other
+ * <code>StorageDevice</code>, e.g. an external I2C EEPROM, can be set with <code>setStorage</code>. Records
+ * are read and written as blocks, so a device on a bus transfers a record in a few transactions.
+ */
 class TemperatureProfileManager {
   public:
+    enum { RECORD_SIZE = 4 + 1 + 1 + MAX_NAME_SIZE + TemperatureProfile::MAX_SIZE * 2 + 1 };
+
+    /**
+     * Sets the memory address in the EEPROM where all profiles are stored and reads the index of the stored
+     * profiles. The store takes <code>slotCount * RECORD_SIZE</code> bytes, see <code>memorySize</code>.
+     * The more slots there are beyond <code>profileCount</code>, the more the writes are spread. If
+     * <code>slotCount</code> is <code>0</code>, twice as many slots as profiles are used.
+     */
+    static void setMemoryInfo(int startAddress, int profileCount, int slotCount = 0);
+
     /**
-     * Sets the memory address in the EEPROM where all profiles are stored. Each profile will take
-     * <code>id * (TEMPERATUREPROFILE_SLOTS * 2 + 2)</code> bytes in the EEPROM. The number of profiles
-     * is limited by the amount of memory made available. If a profile is deleted, the profile id
-     * is set to <code>-1</code> indicating that the memory can be used for to store a new profile.
+     * Sets the device the profiles are stored on. Has to be called before <code>setMemoryInfo</code>, which
+     * reads the index from the device.
      */
-    static void setMemoryInfo(int startAddress, int profileCount);
+    static void setStorage(StorageDevice *storage) { _storage = storage; };
+    static StorageDevice *getStorage() { return _storage; };
     static int maxNumOfProfiles() { return _maxNumOfProfiles; };
+    /**
+     * @return the number of bytes the store takes in the EEPROM.
+     */
+    static int memorySize() { return _memorySize; };
     static TemperatureProfileManager instance;
 
     TemperatureProfile &getProfile();
@@ -43,24 +81,58 @@ class TemperatureProfileManager {
 
     int used() { return maxNumOfProfiles() - freeSpace(); };
 
-
+    /**
+     * @return a number that changes whenever a profile is saved or removed, which allows users of the profiles to
+     *         detect that cached profile data is outdated.
+     */
+    unsigned int changeCount() { return _changeCount; };
 
   private:
     TemperatureProfileManager();
 
     /**
-     * Finds the profile with the given id. If -1 is passed, it will find the first empty entry
-     * if such exists.
+     * Reads all slots and builds the index. If a profile is found twice, because the power failed during
+     * a save, the older version is released.
+     */
+    void buildIndex();
+
+    /**
+     * Finds the index entry of the profile with the given id.
+     * @return the position in the index or <code>-1</code> if there is no such profile.
      */
     int find(int id);
+
+    /**
+     * @return the first slot, starting with the head of the log, that is not used by a profile.
+     */
+    int nextFreeSlot();
+    bool isUsed(int slot);
+
+    int slotAddress(int slot) { return _memoryAdr + slot * RECORD_SIZE; };
+
+    /**
+     * Reads the record of the slot into <code>record</code>.
+     * @return <code>true</code> if the slot holds a valid record;<code>false</code> otherwise.
+     */
+    bool readRecord(int slot, uint8_t *record, unsigned long &sequence);
+    uint8_t recordCrc(const uint8_t *record, int8_t id);
+    void releaseSlot(int slot);
+
     bool isInitialized();
-    int8_t readByte(int addr);
-    void writeByte(int addr, int8_t value);
 
     TemperatureProfile _profile;
+    unsigned int _changeCount;
+
+    int8_t _indexIds[TEMPERATUREPROFILE_MAX_PROFILES];
+    uint8_t _indexSlots[TEMPERATUREPROFILE_MAX_PROFILES];
+    uint8_t _indexSize;
+    uint8_t _head;
+    unsigned long _sequence;
+
+    static StorageDevice *_storage;
     static int _memoryAdr;
     static int _memorySize;
-    static int _memoryBlockSize;
+    static int _slotCount;
     static int _maxNumOfProfiles;
 };
 
@@ -0,0 +1,236 @@
+#include <TemperatureProfileManager.h>
+#include <TemperatureProfile.h>
+#include <ArduinoUnit.h>
+#include <EEPROM.h>
+#include <WriteBackCache.h>
+#include <EEPROMStorage.h>
+
+TestSuite suite;
+
+#define MEM_ADDR 0x100
+#define NUM_PROFILES 4
+#define NUM_SLOTS 8
+
+#define ID_OFFSET 4
+
+void setup() {
+  Serial.begin(9600);
+  TemperatureProfileManager::setMemoryInfo(MEM_ADDR, NUM_PROFILES, NUM_SLOTS);
+  TPM.format();
+}
+
+void loop() {
+  suite.run();
+}
+
+void saveProfile(int id, int setPoint) {
+  TPROFILE.setId(id);
+  TPROFILE.add(4, setPoint);
+  TPROFILE.add(20, setPoint + 1);
+  TPM.save();
+}
+
+int setPointOf(int id) {
+  int time, setPoint;
+
+  if(!TPM.load(id)) {
+    return -1;
+  }
+  TPROFILE.getAt(0, time, setPoint);
+  return setPoint;
+}
+
+/**
+ * @return the slot that holds the profile with the given id or -1.
+ */
+int slotOf(int id) {
+  int found = -1;
+
+  for(int slot = 0; slot < NUM_SLOTS; slot++) {
+    if((int8_t)EEPROM.read(MEM_ADDR + slot * TemperatureProfileManager::RECORD_SIZE + ID_OFFSET) == id) {
+      found = slot;
+    }
+  }
+
+  return found;
+}
+
+/**
+ * Passes everything on to the EEPROM and remembers the order in which the bytes of one slot were written.
+ */
+class RecordingStorage: public StorageDevice {
+  public:
+    int slotAddr;
+    int count;
+    int order[TemperatureProfileManager::RECORD_SIZE];
+
+    long size() { return EEPROMStorage::instance.size(); };
+
+    int read(int addr, uint8_t *buffer, int len) {
+      return EEPROMStorage::instance.read(addr, buffer, len);
+    };
+
+    int write(int addr, const uint8_t *buffer, int len) {
+      for(int i = 0; i < len; i++) {
+        int offset = addr + i - slotAddr;
+        if((offset >= 0) && (offset < TemperatureProfileManager::RECORD_SIZE)) {
+          order[offset] = ++count;
+        }
+      }
+      return EEPROMStorage::instance.write(addr, buffer, len);
+    };
+};
+
+RecordingStorage recorder;
+
+void reboot() {
+  TemperatureProfileManager::setMemoryInfo(MEM_ADDR, NUM_PROFILES, NUM_SLOTS);
+}
+
+test(memorySize) {
+  assertEquals(NUM_SLOTS * TemperatureProfileManager::RECORD_SIZE, TemperatureProfileManager::memorySize());
+}
+
+test(wearRotation) {
+  int slot, previous = -1;
+  bool used[NUM_SLOTS];
+
+  TPM.format();
+  saveProfile(1, 60);
+
+  // Saving the same profile goes round robin through all slots but the one of profile 1
+  for(int i = 0; i < NUM_SLOTS; i++) {
+    used[i] = false;
+  }
+  for(int i = 0; i < 2 * NUM_SLOTS; i++) {
+    saveProfile(2, 60 + i);
+    slot = slotOf(2);
+    assertTrue(slot != previous);
+    assertTrue(slot != slotOf(1));
+    used[slot] = true;
+    previous = slot;
+  }
+  for(int i = 0; i < NUM_SLOTS; i++) {
+    assertTrue(used[i] || (i == slotOf(1)));
+  }
+
+  assertEquals(60 + 2 * NUM_SLOTS - 1, setPointOf(2));
+  assertEquals(60, setPointOf(1));
+  assertEquals(NUM_PROFILES - 2, TPM.freeSpace());
+}
+
+test(survivesReboot) {
+  TPM.format();
+  for(int id = 1; id <= NUM_PROFILES; id++) {
+    saveProfile(id, 60 + id);
+  }
+  saveProfile(2, 70);
+
+  reboot();
+  assertEquals(0, TPM.freeSpace());
+  assertEquals(61, setPointOf(1));
+  assertEquals(70, setPointOf(2));
+  assertEquals(63, setPointOf(3));
+  assertEquals(64, setPointOf(4));
+
+  // The log continues after the newest record
+  saveProfile(3, 71);
+  assertEquals((slotOf(2) + 1) % NUM_SLOTS, slotOf(3));
+}
+
+test(powerFailBeforeRelease) {
+  int oldSlot;
+
+  TPM.format();
+  saveProfile(1, 60);
+  oldSlot = slotOf(1);
+  saveProfile(1, 65);
+
+  // The power failed after the new version was written, but before the old one was released
+  EEPROM.write(MEM_ADDR + oldSlot * TemperatureProfileManager::RECORD_SIZE + ID_OFFSET, 1);
+
+  reboot();
+  assertEquals(65, setPointOf(1));
+  assertEquals(-1, (int8_t)EEPROM.read(MEM_ADDR + oldSlot * TemperatureProfileManager::RECORD_SIZE + ID_OFFSET));
+  assertEquals(NUM_PROFILES - 1, TPM.freeSpace());
+}
+
+test(powerFailDuringWrite) {
+  int addr;
+
+  TPM.format();
+  saveProfile(1, 60);
+  saveProfile(1, 65);
+
+  // The newest version was damaged, e.g. the power failed while writing its data
+  addr = MEM_ADDR + slotOf(1) * TemperatureProfileManager::RECORD_SIZE;
+  EEPROM.write(addr + 8, EEPROM.read(addr + 8) + 1);
+
+  reboot();
+  assertTrue(!TPM.exists(1));
+  assertEquals(NUM_PROFILES, TPM.freeSpace());
+
+  // A damaged slot is reused
+  for(int id = 1; id <= NUM_PROFILES; id++) {
+    saveProfile(id, 50 + id);
+  }
+  reboot();
+  for(int id = 1; id <= NUM_PROFILES; id++) {
+    assertEquals(50 + id, setPointOf(id));
+  }
+}
+
+test(removeAndFull) {
+  TPM.format();
+  for(int id = 1; id <= NUM_PROFILES; id++) {
+    saveProfile(id, 60 + id);
+  }
+
+  TPROFILE.setId(10);
+  assertTrue(!TPM.save());
+
+  TPROFILE.setId(2);
+  assertTrue(TPM.remove());
+  assertEquals(1, TPM.freeSpace());
+  saveProfile(10, 80);
+  assertEquals(80, setPointOf(10));
+
+  reboot();
+  assertTrue(!TPM.exists(2));
+  assertEquals(80, setPointOf(10));
+  assertEquals(0, TPM.freeSpace());
+}
+
+// Within a batch the id still reaches the EEPROM after the rest of the record, even if the slot
+// has to be released first
+test(saveInBatch) {
+  int slot;
+
+  TPM.format();
+  saveProfile(1, 60);
+  slot = (slotOf(1) + 1) % NUM_SLOTS;
+
+  // The next slot holds the remains of a save that failed
+  recorder.slotAddr = MEM_ADDR + slot * TemperatureProfileManager::RECORD_SIZE;
+  EEPROM.write(recorder.slotAddr + ID_OFFSET, 7);
+  reboot();
+  assertTrue(!TPM.exists(7));
+
+  recorder.count = 0;
+  for(int i = 0; i < TemperatureProfileManager::RECORD_SIZE; i++) {
+    recorder.order[i] = 0;
+  }
+  STORAGE.setDevice(&recorder);
+  STORAGE.beginBatch();
+  saveProfile(2, 70);
+  STORAGE.endBatch();
+  STORAGE.setDevice(&EEPROMStorage::instance);
+
+  assertEquals(slot, slotOf(2));
+  for(int i = 0; i < TemperatureProfileManager::RECORD_SIZE; i++) {
+    if(i != ID_OFFSET) {
+      assertTrue(recorder.order[i] < recorder.order[ID_OFFSET]);
+    }
+  }
+  assertEquals(70, setPointOf(2));
+}
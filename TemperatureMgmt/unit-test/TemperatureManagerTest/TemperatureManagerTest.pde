@@ -3,6 +3,7 @@
 #include <ArduinoUnit.h>
 #include <Time.h>
 #include <EEPROM.h>
+#include <WriteBackCache.h>
 
 #include <TemperatureProfile.h>
 #include <TemperatureProfileManager.h>
@@ -141,3 +142,91 @@ test(nextChangeTime) {
   }
 
 }
+
+test(nextChangeAtEndOfHalfDay) {
+  tmElements_t te;
+  time_t time;
+
+  // Sunday, the AM profile (1) ends at 18:00, the PM profile (2) starts at 18:30
+  te.Day = 24;
+  te.Month = 7;
+  te.Year = 41;
+  te.Hour = 17;
+  te.Minute = 59;
+  te.Second = 30;
+  time = makeTime(te);
+
+  te.Hour = 18;
+  te.Minute = 30;
+  te.Second = 0;
+  assertUnsignedLongEquals(makeTime(te), TEMPMGR.nextSetPointChange(time));
+
+  // Within a quarter hour, but on a full minute
+  te.Hour = 6;
+  te.Minute = 5;
+  time = makeTime(te);
+  te.Minute = 15;
+  assertUnsignedLongEquals(makeTime(te), TEMPMGR.nextSetPointChange(time));
+}
+
+test(scheduleChanges) {
+  tmElements_t te;
+  time_t time;
+
+  // Sunday 7:00, i.e. after the first set point of the AM profile
+  te.Day = 24;
+  te.Month = 7;
+  te.Year = 41;
+  te.Hour = 7;
+  te.Minute = 0;
+  te.Second = 0;
+  time = makeTime(te);
+
+  assertEquals(51, TEMPMGR.getSetPointFor(time));
+
+  // A different profile for Sunday AM
+  TEMPMGR.setProfile(3, TemperatureManager::SUNDAY, TemperatureManager::AM, TemperatureManager::SUMMER);
+  assertEquals(53, TEMPMGR.getSetPointFor(time));
+  TEMPMGR.setProfile(1, TemperatureManager::SUNDAY, TemperatureManager::AM, TemperatureManager::SUMMER);
+  assertEquals(51, TEMPMGR.getSetPointFor(time));
+
+  // The profile itself changes
+  TPM.load(1);
+  TPROFILE.add(4, 70);
+  TPM.save();
+  assertEquals(70, TEMPMGR.getSetPointFor(time));
+
+  TPROFILE.setId(1);
+  TPROFILE.add(1, 51);
+  TPROFILE.add(25, 81);
+  TPM.save();
+  assertEquals(51, TEMPMGR.getSetPointFor(time));
+
+  // No profile for the winter
+  TEMPMGR.setTimeOfYear(TemperatureManager::WINTER);
+  assertEquals(-1, TEMPMGR.getSetPointFor(time));
+  assertUnsignedLongEquals(0, TEMPMGR.nextSetPointChange(time));
+  TEMPMGR.setTimeOfYear(TemperatureManager::SUMMER);
+  assertEquals(51, TEMPMGR.getSetPointFor(time));
+}
+
+test(scheduleWrites) {
+  STORAGE.resetCounters();
+
+  // Only the byte of the changed profile id is written
+  TEMPMGR.setProfile(5, TemperatureManager::MONDAY, TemperatureManager::AM, TemperatureManager::WINTER);
+  assertUnsignedLongEquals(1, STORAGE.writes());
+
+  // Within a batch only the final state is written, which is the original schedule
+  STORAGE.beginBatch();
+  for(int day = TemperatureManager::SUNDAY; day < TemperatureManager::MAX_DAYS; day++) {
+    TEMPMGR.setProfile(1, (TemperatureManager::Days)day, TemperatureManager::PM, TemperatureManager::WINTER);
+  }
+  for(int day = TemperatureManager::SUNDAY; day < TemperatureManager::MAX_DAYS; day++) {
+    TEMPMGR.setProfile(-1, (TemperatureManager::Days)day, TemperatureManager::PM, TemperatureManager::WINTER);
+  }
+  TEMPMGR.setProfile(-1, TemperatureManager::MONDAY, TemperatureManager::AM, TemperatureManager::WINTER);
+  STORAGE.endBatch();
+  assertUnsignedLongEquals(2, STORAGE.writes());
+  assertEquals(-1, TEMPMGR.getProfile(TemperatureManager::MONDAY, TemperatureManager::AM, TemperatureManager::WINTER));
+}
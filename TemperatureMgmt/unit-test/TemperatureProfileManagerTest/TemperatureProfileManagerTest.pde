@@ -4,6 +4,7 @@
 #include <TemperatureProfile.h>
 #include <ArduinoUnit.h>
 #include <EEPROM.h>
+#include <WriteBackCache.h>
 #include <Time.h>
 #include <string.h>
 
@@ -20,7 +21,7 @@ void setup() {
 
   for(i = 0; i < MEM_ADDR; i++) {
     EEPROM.write(i, -22);
-    EEPROM.write(i + MEM_ADDR + sizeof(TemperatureProfile) * NUM_PROFILES, -33);
+    EEPROM.write(i + MEM_ADDR + TemperatureProfileManager::memorySize(), -33);
   }
   TPM.format();
 }
@@ -181,10 +182,10 @@ int checkIntegrity() {
      pass = i;
      break;
    }
-   if(((int8_t)EEPROM.read(i +  MEM_ADDR + sizeof(TemperatureProfile) * NUM_PROFILES)) != -33) {
-     pass = i +  MEM_ADDR + sizeof(TemperatureProfile) * NUM_PROFILES;
+   if(((int8_t)EEPROM.read(i +  MEM_ADDR + TemperatureProfileManager::memorySize())) != -33) {
+     pass = i +  MEM_ADDR + TemperatureProfileManager::memorySize();
      Serial.print("(POST)Address ");
-     Serial.print(i +  MEM_ADDR + sizeof(TemperatureProfile) * NUM_PROFILES, HEX);
+     Serial.print(i +  MEM_ADDR + TemperatureProfileManager::memorySize(), HEX);
      Serial.print(" has value ");
      Serial.println((int8_t)EEPROM.read(i), DEC); 
      break;
@@ -3,6 +3,7 @@
 #include <TemperatureProfile.h>
 #include <ArduinoUnit.h>
 #include <EEPROM.h>
+#include <WriteBackCache.h>
 
 TestSuite suite;
 
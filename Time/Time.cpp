@@ -25,16 +25,67 @@
 
 #include "Time.h"
 
+// leap year calulator expects year argument as years offset from 1970
+#define LEAP_YEAR(Y)     ( ((1970+Y)>0) && !((1970+Y)%4) && ( ((1970+Y)%100) || !((1970+Y)%400) ) )
+
+// The cache is moved forward element by element if the new time is less than a day ahead of the
+// cached time, for any other time it is converted with breakTime
+#define CACHE_MAX_STEP SECS_PER_DAY
+
 static tmElements_t tm;          // a cache of time elements
 static time_t       cacheTime;   // the time the cache was updated
+static bool         cacheValid;  // false until the cache was filled the first time
 static time_t       syncInterval = 300;  // time sync will be attempted after this many seconds
 
+static const uint8_t monthDays[]={31,28,31,30,31,30,31,31,30,31,30,31};
+
+static void nextDay(tmElements_t &tm){
+  uint8_t monthLength = monthDays[tm.Month - 1];
+  if(tm.Month == 2 && LEAP_YEAR(tm.Year)) {
+    monthLength++;
+  }
+
+  tm.Wday = (tm.Wday % 7) + 1;
+  if(tm.Day < monthLength) {
+    tm.Day++;
+  }
+  else {
+    tm.Day = 1;
+    if(tm.Month < 12) {
+      tm.Month++;
+    }
+    else {
+      tm.Month = 1;
+      tm.Year++;
+    }
+  }
+}
+
 void refreshCache( time_t t){
-  if( t != cacheTime)
-  {
-    breakTime(t, tm); 
-    cacheTime = t; 
+  unsigned long step = t - cacheTime;   // wraps around if t is before the cached time
+
+  if(!cacheValid || step >= CACHE_MAX_STEP) {
+    breakTime(t, tm);
+    cacheValid = true;
   }
+  else if(step < (unsigned long)(60 - tm.Second)) {
+    // The next seconds of the same minute, the usual case for a clock that is read every second
+    tm.Second += step;
+  }
+  else {
+    // Carry into minutes and hours, less than a day ahead is at most one carry into the next day
+    step += tm.Second;
+    tm.Second = step % 60;
+    uint16_t carry = step / 60 + tm.Minute;
+    tm.Minute = carry % 60;
+    carry = carry / 60 + tm.Hour;
+    if(carry >= 24) {
+      carry -= 24;
+      nextDay(tm);
+    }
+    tm.Hour = carry;
+  }
+  cacheTime = t;
 }
 
 int hour() { // the hour now 
@@ -134,60 +185,60 @@ int year(time_t t) { // the year for the given time
 /* functions to convert to and from system time */
 /* These are for interfacing with time serivces and are not normally needed in a sketch */
 
-// leap year calulator expects year argument as years offset from 1970
-#define LEAP_YEAR(Y)     ( ((1970+Y)>0) && !((1970+Y)%4) && ( ((1970+Y)%100) || !((1970+Y)%400) ) )
+// Days from March 1st 1968, the leap year before 1970, to January 1st 1970
+#define DAYS_1968_03_TO_1970 671
+// Days from March 1st 1968 to March 1st 2100, the only year in the range of time_t that is
+// divisible by 4, but is not a leap year
+#define DAYS_1968_03_TO_2100_03 48212
+// Days of four years, including one leap day
+#define DAYS_PER_4_YEARS 1461
+
+// The days from March 1st to the first of the given month, month 0 is March. Counting the year from
+// March puts the leap day at the end of the year, the remaining month lengths repeat 31 30 31 30 31.
+#define DAYS_BEFORE_MARCH_MONTH(M) ((153 * (M) + 2) / 5)
 
-static  const uint8_t monthDays[]={31,28,31,30,31,30,31,31,30,31,30,31}; // API starts months from 1, this array starts from 0
- 
 void breakTime(time_t time, tmElements_t &tm){
 // break the given time_t into time components
 // this is a more compact version of the C library localtime function
 // note that year is offset from 1970 !!!
-
-  uint8_t year;
-  uint8_t month, monthLength;
-  unsigned long days;
-  
-  tm.Second = time % 60;
-  time /= 60; // now it is minutes
-  tm.Minute = time % 60;
-  time /= 60; // now it is hours
-  tm.Hour = time % 24;
-  time /= 24; // now it is days
-  tm.Wday = ((time + 4) % 7) + 1;  // Sunday is day 1 
-  
-  year = 0;  
-  days = 0;
-  while((unsigned)(days += (LEAP_YEAR(year) ? 366 : 365)) <= time) {
-    year++;
+// works in constant time for the whole range of an unsigned 32 bit time_t (1970 till 2106)
+
+  uint16_t days, cycles, cycleDay, cycleYear, yearDay, marchMonth;
+  unsigned long secondsOfDay;
+  uint16_t secondsOfHour;
+
+  days = time / SECS_PER_DAY;
+  secondsOfDay = time - days * SECS_PER_DAY;
+  tm.Hour = secondsOfDay / SECS_PER_HOUR;
+  secondsOfHour = secondsOfDay - tm.Hour * SECS_PER_HOUR;
+  tm.Minute = secondsOfHour / 60;
+  tm.Second = secondsOfHour - tm.Minute * 60;
+  tm.Wday = ((days + 4) % 7) + 1;  // Sunday is day 1
+
+  // Count days from March 1st 1968, so every four years end with a leap day. 2100 is not a leap year,
+  // every day from March 2100 is moved by one, as if there was a February 29th, 2100.
+  days += DAYS_1968_03_TO_1970;
+  if(days >= DAYS_1968_03_TO_2100_03) {
+    days++;
   }
-  tm.Year = year; // year is offset from 1970 
-  
-  days -= LEAP_YEAR(year) ? 366 : 365;
-  time  -= days; // now it is days in this year, starting at 0
-  
-  days=0;
-  month=0;
-  monthLength=0;
-  for (month=0; month<12; month++) {
-    if (month==1) { // february
-      if (LEAP_YEAR(year)) {
-        monthLength=29;
-      } else {
-        monthLength=28;
-      }
-    } else {
-      monthLength = monthDays[month];
-    }
-    
-    if (time >= monthLength) {
-      time -= monthLength;
-    } else {
-        break;
-    }
+  cycles = days / DAYS_PER_4_YEARS;
+  cycleDay = days - cycles * DAYS_PER_4_YEARS;
+  // The last day of a cycle is the leap day, which still belongs to the fourth year
+  cycleYear = (cycleDay - cycleDay / (DAYS_PER_4_YEARS - 1)) / 365;
+  yearDay = cycleDay - cycleYear * 365;
+
+  marchMonth = (5 * yearDay + 2) / 153;
+  tm.Day = yearDay - DAYS_BEFORE_MARCH_MONTH(marchMonth) + 1;
+  // year is offset from 1970, the year starting in March 1968 is -2
+  tm.Year = 4 * cycles + cycleYear - 2;
+  if(marchMonth < 10) {
+    tm.Month = marchMonth + 3;
+  }
+  else {
+    // January and February belong to the next calendar year
+    tm.Month = marchMonth - 9;
+    tm.Year++;
   }
-  tm.Month = month + 1;  // jan is month 1  
-  tm.Day = time + 1;     // day of month
 }
 
 time_t makeTime(tmElements_t &tm){   
@@ -195,39 +246,63 @@ time_t makeTime(tmElements_t &tm){
 // note year argument is offset from 1970 (see macros in time.h to convert to other formats)
 // previous version used full four digit year (or digits since 2000),i.e. 2009 was 2009 or 9
   
-  int i;
-  time_t seconds;
-
-  // seconds from 1970 till 1 jan 00:00:00 of the given year
-  seconds= tm.Year*(SECS_PER_DAY * 365);
-  for (i = 0; i < tm.Year; i++) {
-    if (LEAP_YEAR(i)) {
-      seconds +=  SECS_PER_DAY;   // add extra days for leap years
-    }
-  }
-  
+  int year = tmYearToCalendar(tm.Year) - 1;
+  long days;
+
+  // days from 1970 till 1 jan of the given year, the leap years are counted from year 1
+  days = tm.Year * 365L + (year / 4 - year / 100 + year / 400) - (1969 / 4 - 1969 / 100 + 1969 / 400);
+
   // add days for this year, months start from 1
-  for (i = 1; i < tm.Month; i++) {
-    if ( (i == 2) && LEAP_YEAR(tm.Year)) { 
-      seconds += SECS_PER_DAY * 29;
-    } else {
-      seconds += SECS_PER_DAY * monthDays[i-1];  //monthDay array starts from 0
+  if(tm.Month > 2) {
+    days += DAYS_BEFORE_MARCH_MONTH(tm.Month - 3) + 31 + 28;
+    if(LEAP_YEAR(tm.Year)) {
+      days++;
     }
   }
-  seconds+= (tm.Day-1) * SECS_PER_DAY;
-  seconds+= tm.Hour * SECS_PER_HOUR;
-  seconds+= tm.Minute * SECS_PER_MIN;
-  seconds+= tm.Second;
-  return seconds; 
+  else if(tm.Month == 2) {
+    days += 31;
+  }
+  days += tm.Day - 1;
+
+  return days * SECS_PER_DAY + tm.Hour * SECS_PER_HOUR + tm.Minute * SECS_PER_MIN + tm.Second;
 }
 /*=====================================================*/	
 /* Low level system time functions  */
 
 static time_t sysTime = 0;
-static time_t prevMillis = 0;
+static unsigned long prevMillis = 0;  // millis() at the start of the current second of sysTime
 static time_t nextSyncTime = 0;
 static timeStatus_t Status = timeNotSet;
 
+/*
+ * The clock is disciplined by the sync provider: the frequency error of millis() is measured against
+ * the provider and corrected, small offsets are slewed by making the seconds a little shorter or longer
+ * instead of stepping the time, and the sync interval grows as long as the clock keeps up.
+ */
+
+// Offsets up to this many seconds are slewed, larger ones are stepped
+#define MAX_SLEW_SECONDS 10
+// Offsets below this many ms are left alone, the provider only tells whole seconds
+#define SLEW_THRESHOLD 1000
+// A second is made at most this many ms shorter or longer for slewing (0.5%)
+#define MAX_SLEW_MILLIS 5
+// The frequency is measured once the provider was followed for this many seconds
+#define MIN_DRIFT_SPAN SECS_PER_HOUR
+// A new baseline for the frequency is taken after this many ms, long before millis() rolls over
+#define MAX_DRIFT_BASELINE 0x40000000UL
+// Measured frequency errors are limited to 5%
+#define MAX_DRIFT_PPM 50000L
+// The sync interval grows up to this multiple of the interval set with setSyncInterval
+#define MAX_SYNC_INTERVAL_FACTOR 32
+
+static unsigned int secondMillis = 1000; // length of the current second in ms of millis()
+static long driftPpm = 0;         // frequency error of millis(), positive if it runs fast
+static long driftRemainder = 0;   // the fraction of a ms the drift correction still owes, in us
+static long slewMillis = 0;       // offset still to be slewed out, positive if the clock is behind
+static time_t syncIntervalNow = 300;
+static time_t baseTime = 0;       // time of the provider and millis() the frequency is measured from
+static unsigned long baseMillis = 0;
+
 getExternalTime getTimePtr;  // pointer to external sync function
 //setExternalTime setTimePtr; // not used in this version
 
@@ -235,20 +310,115 @@ getExternalTime getTimePtr;  // pointer to external sync function
 time_t sysUnsyncedTime = 0; // the time sysTime unadjusted by sync  
 #endif
 
+static void nextSecondLength(){
+  long us = 1000000L + driftPpm + driftRemainder;
+  long step;
+
+  secondMillis = us / 1000;
+  driftRemainder = us - secondMillis * 1000L;
+  if(slewMillis != 0) {
+    step = slewMillis > MAX_SLEW_MILLIS ? MAX_SLEW_MILLIS : (slewMillis < -MAX_SLEW_MILLIS ? -MAX_SLEW_MILLIS : slewMillis);
+    secondMillis -= step;
+    slewMillis -= step;
+  }
+}
+
+static void catchUp(unsigned long elapsed){
+  unsigned long seconds, usPerSecond;
+  unsigned long long total;
+  long slew, limit;
+
+  // The current second ends with the length it already has
+  sysTime++;
+  prevMillis += secondMillis;
+  elapsed -= secondMillis;
+
+  // Slew as much as the seconds in between allow
+  limit = elapsed / (1000 / MAX_SLEW_MILLIS);
+  slew = slewMillis > limit ? limit : (slewMillis < -limit ? -limit : slewMillis);
+  slewMillis -= slew;
+  prevMillis -= slew;
+  elapsed += slew;
+
+  // Then whole seconds of the corrected length, which is kept in us to carry the fractions
+  usPerSecond = 1000000L + driftPpm;
+  seconds = (unsigned long long)elapsed * 1000 / usPerSecond;
+  total = (unsigned long long)seconds * usPerSecond + driftRemainder;
+  sysTime += seconds;
+  prevMillis += total / 1000;
+  driftRemainder = total % 1000;
+#ifdef TIME_DRIFT_INFO
+  sysUnsyncedTime += seconds + 1;
+#endif
+  nextSecondLength();
+}
+
+static void restartDrift(time_t t, unsigned long ms){
+  baseTime = t;
+  baseMillis = ms;
+}
+
+static void syncTime(time_t t){
+  long seconds = (long)(t - sysTime);
+  unsigned long ms;
+  long span, offset;
+
+  if((Status == timeNotSet) || (seconds > MAX_SLEW_SECONDS) || (seconds < -MAX_SLEW_SECONDS)) {
+    setTime(t);
+    return;
+  }
+
+  ms = millis();
+  span = (long)(t - baseTime);
+  if(ms - baseMillis >= MAX_DRIFT_BASELINE) {
+    restartDrift(t, ms);
+  }
+  else if(span >= (long)MIN_DRIFT_SPAN) {
+    // Both times of the provider are whole seconds, the error is below a second over the whole span
+    long long ppm = ((long long)(ms - baseMillis) - span * 1000LL) * 1000 / span;
+    driftPpm = ppm > MAX_DRIFT_PPM ? MAX_DRIFT_PPM : (ppm < -MAX_DRIFT_PPM ? -MAX_DRIFT_PPM : (long)ppm);
+  }
+
+  // On average the provider is half a second into second t
+  offset = seconds * 1000L + 500 - (long)(ms - prevMillis);
+  if((offset >= SLEW_THRESHOLD) || (offset <= -SLEW_THRESHOLD)) {
+    slewMillis = offset;
+    syncIntervalNow = syncIntervalNow / 2 > syncInterval ? syncIntervalNow / 2 : syncInterval;
+  }
+  else {
+    slewMillis = 0;
+    if(syncIntervalNow < syncInterval * MAX_SYNC_INTERVAL_FACTOR) {
+      syncIntervalNow *= 2;
+    }
+  }
+  nextSyncTime = sysTime + syncIntervalNow;
+  Status = timeSet;
+}
 
 time_t now(){
-  while( millis() - prevMillis >= 1000){      
-    sysTime++;
-    prevMillis += 1000;	
+  // The unsigned difference is right across the rollover of millis() after 49.7 days, as long as
+  // now() is called at least once in that time
+  unsigned long elapsed = millis() - prevMillis;
+  if(elapsed >= secondMillis) {
+    if(elapsed < 2U * secondMillis) {
+      // Usually a single second passed
+      sysTime++;
+      prevMillis += secondMillis;
 #ifdef TIME_DRIFT_INFO
-    sysUnsyncedTime++; // this can be compared to the synced time to measure long term drift     
+      sysUnsyncedTime++; // this can be compared to the synced time to measure long term drift
 #endif	
+      nextSecondLength();
+    }
+    else {
+      // Long blocking calls are caught up at once
+      catchUp(elapsed);
+    }
   }
   if(nextSyncTime <= sysTime){
 	if(getTimePtr != 0){
 	  time_t t = getTimePtr();
       if( t != 0)
-        setTime(t);
+        syncTime(t);
       else
         Status = (Status == timeNotSet) ?  timeNotSet : timeNeedsSync;        
     }
@@ -263,31 +433,50 @@ void setTime(time_t t){
 #endif
 
   sysTime = t;  
+  syncIntervalNow = syncInterval;
   nextSyncTime = t + syncInterval;
   Status = timeSet; 
   prevMillis = millis();  // restart counting from now (thanks to Korman for this fix)
+  // A new second starts, the frequency is measured from here
+  slewMillis = 0;
+  driftRemainder = 0;
+  nextSecondLength();
+  restartDrift(t, prevMillis);
 } 
 
 void  setTime(int hr,int min,int sec,int dy, int mnth, int yr){
  // year can be given as full four digit year or two digts (2010 or 10 for 2010);  
  //it is converted to years since 1970
+  tmElements_t te;   // not the cache, which still holds the elements of cacheTime
+
   if( yr > 99)
       yr = yr - 1970;
   else
       yr += 30;  
-  tm.Year = yr;
-  tm.Month = mnth;
-  tm.Day = dy;
-  tm.Hour = hr;
-  tm.Minute = min;
-  tm.Second = sec;
-  setTime(makeTime(tm));
+  te.Year = yr;
+  te.Month = mnth;
+  te.Day = dy;
+  te.Hour = hr;
+  te.Minute = min;
+  te.Second = sec;
+  setTime(makeTime(te));
 }
 
 void adjustTime(long adjustment){
   sysTime += adjustment;
 }
 
+void addSleepTime(unsigned long ms){
+  sysTime += ms / 1000;
+#ifdef TIME_DRIFT_INFO
+  sysUnsyncedTime += ms / 1000;
+#endif
+  // The fraction of a second is added to the running second, now() carries it into sysTime
+  prevMillis -= ms % 1000;
+  // millis() did not count the time, for the frequency measurement it is as if it did
+  baseMillis -= ms;
+}
+
 timeStatus_t timeStatus(){ // indicates if time has been set and recently synchronized
   return Status;
 }
@@ -300,4 +489,17 @@ void setSyncProvider( getExternalTime getTimeFunction){
 
 void setSyncInterval(time_t interval){ // set the number of seconds between re-sync
   syncInterval = interval;
+  syncIntervalNow = interval;
+}
+
+time_t currentSyncInterval(){
+  return syncIntervalNow;
+}
+
+long timeDrift(){
+  return driftPpm;
+}
+
+void setTimeDrift(long ppm){
+  driftPpm = ppm > MAX_DRIFT_PPM ? MAX_DRIFT_PPM : (ppm < -MAX_DRIFT_PPM ? -MAX_DRIFT_PPM : ppm);
 }
\ No newline at end of file
@@ -7,7 +7,12 @@
 
 #include <inttypes.h>
 
+#ifdef __AVR__
 typedef unsigned long time_t;
+#else
+// Host builds (see HostSim) get time_t from the C library, a second typedef would clash
+#include <sys/types.h>
+#endif
 
 typedef enum {timeNotSet, timeNeedsSync, timeSet
 }  timeStatus_t ;
@@ -94,6 +99,7 @@ time_t now();              // return the current time as seconds since Jan 1 197
 void    setTime(time_t t);
 void    setTime(int hr,int min,int sec,int day, int month, int yr);
 void    adjustTime(long adjustment);
+void    addSleepTime(unsigned long ms); // credit time that passed while the millis() timer was stopped, e.g. in power down
 
 /* date strings */ 
 #define dt_MAX_STRING_LEN 9 // length of longest date string (excluding terminating null)
@@ -106,6 +112,9 @@ char* dayShortStr(uint8_t day);
 timeStatus_t timeStatus(); // indicates if time has been set and recently synchronized
 void    setSyncProvider( getExternalTime getTimeFunction); // identify the external time provider
 void    setSyncInterval(time_t interval); // set the number of seconds between re-sync
+time_t  currentSyncInterval();     // the interval grows up to 32 times the one set while the clock keeps up
+long    timeDrift();               // the measured frequency error of millis() in ppm, positive if it runs fast
+void    setTimeDrift(long ppm);    // restore a frequency error measured before, e.g. from EEPROM
 
 /* low level functions to convert to and from system time                     */
 void breakTime(time_t time, tmElements_t &tm);  // break time_t into elements
@@ -0,0 +1,380 @@
+/*
+ * TimeZone.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "TimeZone.h"
+
+#define RECORD_MAGIC 0x7a
+#define QUARTER_HOUR 900L
+// The last time an unsigned 32 bit time_t can represent
+#define TIME_MAX 0xffffffffUL
+// Transitions are computed up to 2105, 2106 ends in February
+#define LAST_YEAR 135
+
+static long daysOf(uint8_t year, uint8_t month, uint8_t day) {
+  tmElements_t te;
+
+  te.Second = 0;
+  te.Minute = 0;
+  te.Hour = 0;
+  te.Day = day;
+  te.Month = month;
+  te.Year = year;
+  return makeTime(te) / SECS_PER_DAY;
+}
+
+static bool isDigit(char c) {
+  return (c >= '0') && (c <= '9');
+}
+
+static bool isLetter(char c) {
+  return ((c >= 'a') && (c <= 'z')) || ((c >= 'A') && (c <= 'Z'));
+}
+
+// Parses a number of up to three digits
+static const char *parseNumber(const char *p, int &number) {
+  if(!isDigit(*p)) {
+    return NULL;
+  }
+  number = 0;
+  for(uint8_t i = 0; (i < 3) && isDigit(*p); i++) {
+    number = number * 10 + (*p++ - '0');
+  }
+  return p;
+}
+
+TimeZone::TimeZone() {
+  setOffset(0);
+}
+
+void TimeZone::setOffset(long utcOffset) {
+  _stdOffset = utcOffset;
+  _dstOffset = utcOffset;
+  _hasDST = false;
+  invalidate();
+}
+
+void TimeZone::invalidate() {
+  // Without daylight saving the one period covers all times
+  _from = 0;
+  _length = _hasDST ? 0 : TIME_MAX;
+  _offset = _stdOffset;
+  _dst = false;
+}
+
+const char *TimeZone::parseName(const char *p) {
+  const char *start = p;
+
+  if(*p == '<') {
+    while(*++p != '>') {
+      if(*p == 0) {
+        return NULL;
+      }
+    }
+    return p + 1;
+  }
+  while(isLetter(*p)) {
+    p++;
+  }
+  return (p - start >= 3) ? p : NULL;
+}
+
+const char *TimeZone::parseTime(const char *p, long &seconds) {
+  int hours, minutes = 0, secs = 0;
+  bool negative = (*p == '-');
+
+  if((*p == '-') || (*p == '+')) {
+    p++;
+  }
+  if(!(p = parseNumber(p, hours))) {
+    return NULL;
+  }
+  if(*p == ':') {
+    if(!(p = parseNumber(p + 1, minutes)) || (minutes > 59)) {
+      return NULL;
+    }
+    if(*p == ':') {
+      if(!(p = parseNumber(p + 1, secs)) || (secs > 59)) {
+        return NULL;
+      }
+    }
+  }
+  if(hours > 167) {
+    return NULL;
+  }
+  seconds = hours * SECS_PER_HOUR + minutes * SECS_PER_MIN + secs;
+  if(negative) {
+    seconds = -seconds;
+  }
+  return p;
+}
+
+const char *TimeZone::parseRule(const char *p, Rule &rule) {
+  int n;
+
+  if(*p == 'J') {
+    if(!(p = parseNumber(p + 1, n)) || (n < 1) || (n > 365)) {
+      return NULL;
+    }
+    rule.kind = JULIAN;
+    rule.day = n;
+  }
+  else if(*p == 'M') {
+    if(!(p = parseNumber(p + 1, n)) || (n < 1) || (n > 12) || (*p != '.')) {
+      return NULL;
+    }
+    rule.month = n;
+    if(!(p = parseNumber(p + 1, n)) || (n < 1) || (n > 5) || (*p != '.')) {
+      return NULL;
+    }
+    rule.week = n;
+    if(!(p = parseNumber(p + 1, n)) || (n > 6)) {
+      return NULL;
+    }
+    rule.wday = n;
+    rule.kind = MONTH;
+  }
+  else {
+    if(!(p = parseNumber(p, n)) || (n > 365)) {
+      return NULL;
+    }
+    rule.kind = DAY;
+    rule.day = n;
+  }
+
+  rule.time = 2 * SECS_PER_HOUR;
+  if(*p == '/') {
+    p = parseTime(p + 1, rule.time);
+  }
+  return p;
+}
+
+bool TimeZone::setRule(const char *rule) {
+  const char *p;
+  long stdOffset, dstOffset;
+  Rule start, end;
+
+  // POSIX offsets are the time to add to local time to get UTC
+  if(!(p = parseName(rule)) || !(p = parseTime(p, stdOffset))) {
+    setOffset(0);
+    return false;
+  }
+  if(*p == 0) {
+    setOffset(-stdOffset);
+    return true;
+  }
+
+  if(!(p = parseName(p))) {
+    setOffset(0);
+    return false;
+  }
+  dstOffset = stdOffset - SECS_PER_HOUR;
+  if((*p != ',') && !(p = parseTime(p, dstOffset))) {
+    setOffset(0);
+    return false;
+  }
+  if((*p != ',') || !(p = parseRule(p + 1, start)) || (*p != ',') || !(p = parseRule(p + 1, end)) || (*p != 0)) {
+    setOffset(0);
+    return false;
+  }
+
+  _stdOffset = -stdOffset;
+  _dstOffset = -dstOffset;
+  _start = start;
+  _end = end;
+  _hasDST = true;
+  invalidate();
+
+  return true;
+}
+
+time_t TimeZone::transition(const Rule &rule, uint8_t year, long offset) {
+  long days, first;
+  int day, length;
+
+  switch(rule.kind) {
+    case JULIAN:
+      // February 29th is not counted
+      days = daysOf(year, 1, 1) + rule.day - 1;
+      if((rule.day >= 60) && (daysOf(year, 3, 1) - daysOf(year, 2, 1) == 29)) {
+        days++;
+      }
+      break;
+    case DAY:
+      days = daysOf(year, 1, 1) + rule.day;
+      break;
+    default:
+      first = daysOf(year, rule.month, 1);
+      length = (rule.month < 12 ? daysOf(year, rule.month + 1, 1) : daysOf(year + 1, 1, 1)) - first;
+      // Jan 1st 1970 was a Thursday
+      day = (rule.wday + 7 - (first + 4) % 7) % 7 + (rule.week - 1) * 7;
+      while(day >= length) {
+        day -= 7;
+      }
+      days = first + day;
+      break;
+  }
+
+  // The rule gives the local time before the transition
+  return (time_t)days * SECS_PER_DAY + (rule.time - offset);
+}
+
+void TimeZone::findPeriod(time_t utc) {
+  tmElements_t te;
+  time_t from = 0, until = TIME_MAX, t;
+  bool found = false, dst = false, untilDST = false;
+
+  // The transitions of the year before, the year and the year after, the latest one before the
+  // given time starts the period, the first one after it ends the period
+  breakTime(utc, te);
+  for(int year = te.Year - 1; year <= te.Year + 1; year++) {
+    if((year < 0) || (year > LAST_YEAR)) {
+      continue;
+    }
+    for(uint8_t i = 0; i < 2; i++) {
+      t = (i == 0) ? transition(_start, year, _stdOffset) : transition(_end, year, _dstOffset);
+      if(t <= utc) {
+        if(!found || (t >= from)) {
+          from = t;
+          dst = (i == 0);
+          found = true;
+        }
+      }
+      else if(t < until) {
+        until = t;
+        untilDST = (i == 0);
+      }
+    }
+  }
+  if(!found) {
+    dst = !untilDST;
+  }
+
+  _from = from;
+  _length = until - from;
+  _dst = dst;
+  _offset = dst ? _dstOffset : _stdOffset;
+}
+
+long TimeZone::offset(time_t utc) {
+  if((unsigned long)(utc - _from) >= _length) {
+    findPeriod(utc);
+  }
+  return _offset;
+}
+
+bool TimeZone::isDST(time_t utc) {
+  offset(utc);
+  return _dst;
+}
+
+time_t TimeZone::nextTransition(time_t utc) {
+  if(!_hasDST) {
+    return 0;
+  }
+  offset(utc);
+  return (_length == TIME_MAX - _from) ? 0 : _from + _length;
+}
+
+time_t TimeZone::toUTC(time_t local) {
+  time_t utc = local - _stdOffset;
+
+  // In daylight saving time the local time is further ahead
+  if(_hasDST && isDST(utc) && isDST(local - _dstOffset)) {
+    utc = local - _dstOffset;
+  }
+  return utc;
+}
+
+bool TimeZone::encodeRule(const Rule &rule, uint8_t *buffer) {
+  long minutes = rule.time / 60;
+
+  if((rule.time % 60 != 0) || (minutes < -32768) || (minutes > 32767)) {
+    return false;
+  }
+  if(rule.kind == MONTH) {
+    buffer[0] = (MONTH << 6) | rule.month;
+    buffer[1] = (rule.week << 3) | rule.wday;
+  }
+  else {
+    buffer[0] = (rule.kind << 6) | (rule.day >> 8);
+    buffer[1] = rule.day & 0xff;
+  }
+  buffer[2] = minutes & 0xff;
+  buffer[3] = (minutes >> 8) & 0xff;
+  return true;
+}
+
+bool TimeZone::decodeRule(const uint8_t *buffer, Rule &rule) {
+  rule.kind = buffer[0] >> 6;
+  rule.time = (int16_t)(buffer[2] | (buffer[3] << 8)) * 60L;
+  if(rule.kind == MONTH) {
+    rule.month = buffer[0] & 0x0f;
+    rule.week = buffer[1] >> 3;
+    rule.wday = buffer[1] & 0x07;
+    return (rule.month >= 1) && (rule.month <= 12) && (rule.week >= 1) && (rule.week <= 5) && (rule.wday <= 6);
+  }
+  rule.day = ((buffer[0] & 0x01) << 8) | buffer[1];
+  return (rule.day <= 365) && ((rule.kind == DAY) || ((rule.kind == JULIAN) && (rule.day >= 1)));
+}
+
+bool TimeZone::encode(uint8_t *buffer) {
+  long delta = _dstOffset - _stdOffset;
+  uint8_t sum = 0;
+
+  if((_stdOffset % QUARTER_HOUR != 0) || (_stdOffset / QUARTER_HOUR < -127) || (_stdOffset / QUARTER_HOUR > 127) ||
+     (delta % QUARTER_HOUR != 0) || (delta / QUARTER_HOUR < -127) || (delta / QUARTER_HOUR > 127)) {
+    return false;
+  }
+
+  buffer[0] = RECORD_MAGIC;
+  buffer[1] = (int8_t)(_stdOffset / QUARTER_HOUR);
+  buffer[2] = _hasDST ? (int8_t)(delta / QUARTER_HOUR) : 0;
+  if(_hasDST) {
+    if(!encodeRule(_start, buffer + 3) || !encodeRule(_end, buffer + 7)) {
+      return false;
+    }
+  }
+  else {
+    for(uint8_t i = 3; i < 11; i++) {
+      buffer[i] = 0;
+    }
+  }
+  for(uint8_t i = 0; i < RECORD_SIZE - 1; i++) {
+    sum += buffer[i];
+  }
+  buffer[RECORD_SIZE - 1] = ~sum;
+
+  return true;
+}
+
+bool TimeZone::decode(const uint8_t *buffer) {
+  uint8_t sum = 0;
+  Rule start, end;
+
+  for(uint8_t i = 0; i < RECORD_SIZE - 1; i++) {
+    sum += buffer[i];
+  }
+  if((buffer[0] != RECORD_MAGIC) || (buffer[RECORD_SIZE - 1] != (uint8_t)~sum)) {
+    return false;
+  }
+
+  if(buffer[2] == 0) {
+    setOffset((int8_t)buffer[1] * QUARTER_HOUR);
+    return true;
+  }
+  if(!decodeRule(buffer + 3, start) || !decodeRule(buffer + 7, end)) {
+    return false;
+  }
+  _stdOffset = (int8_t)buffer[1] * QUARTER_HOUR;
+  _dstOffset = _stdOffset + (int8_t)buffer[2] * QUARTER_HOUR;
+  _start = start;
+  _end = end;
+  _hasDST = true;
+  invalidate();
+
+  return true;
+}
@@ -0,0 +1,133 @@
+/*
+ * TimeZone.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef TIMEZONE_H_
+#define TIMEZONE_H_
+
+#include <WProgram.h>
+#include "Time.h"
+
+/**
+ * Local time by a POSIX TZ rule, e.g. <code>CET-1CEST,M3.5.0,M10.5.0/3</code> for central Europe or
+ * <code>EST5EDT,M3.2.0,M11.1.0</code> for the US east coast. Supported are:
+ * <ul>
+ *  <li>names of three or more letters, or any characters within <code>&lt;&gt;</code>,
+ *  <li>offsets <code>[+-]hh[:mm[:ss]]</code>, positive west of Greenwich as in POSIX; the daylight saving offset
+ *      defaults to one hour ahead of standard time,
+ *  <li>the dates <code>Jn</code> (1...365, February 29th is never counted), <code>n</code> (0...365) and
+ *      <code>Mm.w.d</code> (day d, 0 is Sunday, of week w, 5 is the last one, of month m), each with an optional
+ *      <code>/time</code>, default 02:00:00, which may be negative or beyond 24 hours.
+ * </ul>
+ * The zone keeps the period around the last converted time in which the offset does not change, so most
+ * conversions take one comparison and one addition; the rule is only evaluated once the time leaves the
+ * period, i.e. twice a year.
+ */
+class TimeZone {
+  public:
+    // Size of the record written by encode
+    static const uint8_t RECORD_SIZE = 12;
+
+    /**
+     * Creates the zone UTC.
+     */
+    TimeZone();
+
+    /**
+     * @return <code>true</code> if the rule could be parsed;<code>false</code> otherwise, the zone is UTC then.
+     */
+    bool setRule(const char *rule);
+
+    /**
+     * Sets a zone without daylight saving.
+     *
+     * @param[in] utcOffset the seconds local time is ahead of UTC, i.e. east of Greenwich is positive.
+     */
+    void setOffset(long utcOffset);
+
+    time_t toLocal(time_t utc) {
+      if((unsigned long)(utc - _from) < _length) {
+        return utc + _offset;
+      }
+      return utc + offset(utc);
+    };
+
+    /**
+     * Converts a local time. Local times that do not exist, when the clock is put forward, are moved
+     * forward as well; local times that exist twice, when the clock is put back, are taken as standard time.
+     */
+    time_t toUTC(time_t local);
+
+    /**
+     * @return the seconds local time is ahead of UTC at the given time.
+     */
+    long offset(time_t utc);
+
+    bool isDST(time_t utc);
+
+    /**
+     * @return the local time now.
+     */
+    time_t now() { return toLocal(::now()); };
+
+    /**
+     * @return the next time, in UTC, the offset changes after the given time; <code>0</code> for zones
+     *         without daylight saving.
+     */
+    time_t nextTransition(time_t utc);
+
+    /**
+     * Writes the zone in <code>RECORD_SIZE</code> bytes to store it, e.g. in the memory of an RTC. Offsets
+     * are stored in quarter hours and the times of the transitions in minutes.
+     *
+     * @return <code>false</code> if the zone cannot be stored in the record;<code>true</code> otherwise.
+     */
+    bool encode(uint8_t *buffer);
+
+    /**
+     * Reads a zone written by <code>encode</code>.
+     *
+     * @return <code>false</code> if the buffer does not hold a valid record, the zone is left
+     *         unchanged;<code>true</code> otherwise.
+     */
+    bool decode(const uint8_t *buffer);
+
+  private:
+    enum Kind { JULIAN = 0, DAY = 1, MONTH = 2 };
+
+    struct Rule {
+      uint8_t kind;
+      uint8_t month;
+      uint8_t week;
+      uint8_t wday;
+      uint16_t day;
+      long time;
+    };
+
+    static const char *parseName(const char *p);
+    static const char *parseTime(const char *p, long &seconds);
+    static const char *parseRule(const char *p, Rule &rule);
+    static bool encodeRule(const Rule &rule, uint8_t *buffer);
+    static bool decodeRule(const uint8_t *buffer, Rule &rule);
+
+    time_t transition(const Rule &rule, uint8_t year, long offset);
+    void findPeriod(time_t utc);
+    void invalidate();
+
+    long _stdOffset;
+    long _dstOffset;
+    Rule _start;
+    Rule _end;
+    bool _hasDST;
+
+    // The period [_from, _from + _length) in which local time is _offset ahead of UTC
+    time_t _from;
+    unsigned long _length;
+    long _offset;
+    bool _dst;
+};
+
+#endif /* TIMEZONE_H_ */
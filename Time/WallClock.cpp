@@ -0,0 +1,157 @@
+/*
+ * WallClock.cpp
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#include "WallClock.h"
+#include <avr/io.h>
+#include <avr/interrupt.h>
+
+#define NOMINAL_PERIOD 1000000UL
+#define PERIOD_SHIFT 3
+
+WallClock WallClock::instance = WallClock();
+
+WallClock::WallClock() {
+  _seconds = 0;
+  _edgeMicros = 0;
+  _periodSum = NOMINAL_PERIOD << PERIOD_SHIFT;
+  _edges = 0;
+  _last = 0;
+  _interrupt = -1;
+  _running = false;
+}
+
+bool WallClock::begin(uint8_t interrupt, getExternalTime provider) {
+  unsigned long start;
+  time_t t;
+
+  end();
+  _interrupt = interrupt;
+  _edges = 0;
+  _periodSum = NOMINAL_PERIOD << PERIOD_SHIFT;
+  attachInterrupt(interrupt, edge, FALLING);
+
+  // The time is read right after an edge, so it is the second that just started
+  start = millis();
+  while(_edges == 0) {
+    if(millis() - start > MAX_EDGE_WAIT) {
+      end();
+      return false;
+    }
+    delay(1);
+  }
+  t = provider();
+  if(t == 0) {
+    end();
+    return false;
+  }
+
+  uint8_t oldSREG = SREG;
+  cli();
+  _seconds = t;
+  _last = 0;
+  _running = true;
+  SREG = oldSREG;
+
+  return true;
+}
+
+void WallClock::end() {
+  if(_interrupt >= 0) {
+    detachInterrupt(_interrupt);
+    _interrupt = -1;
+  }
+  _running = false;
+}
+
+void WallClock::edge() {
+  instance.tick(micros());
+}
+
+void WallClock::tick(unsigned long edgeMicros) {
+  unsigned long elapsed = edgeMicros - _edgeMicros;
+  unsigned long period = _periodSum >> PERIOD_SHIFT;
+
+  if(_edges != 0) {
+    if(elapsed < period / 2) {
+      // A glitch on the line, not a second
+      return;
+    }
+    if(elapsed > period + period / 2) {
+      // Edges went missing, count the seconds in between
+      _seconds += (elapsed + period / 2) / period;
+    }
+    else {
+      _seconds++;
+      // Only plausible periods go into the mean, the crystal of the MCU is off by far less than 3%
+      if((elapsed > period - period / 32) && (elapsed < period + period / 32)) {
+        _periodSum += elapsed - period;
+      }
+    }
+  }
+  _edgeMicros = edgeMicros;
+  if(_edges < 0xff) {
+    _edges++;
+  }
+}
+
+unsigned long long WallClock::timestamp() {
+  time_t seconds;
+  unsigned long edgeMicros, period, elapsed;
+  unsigned long long t;
+
+  if(!_running) {
+    return 0;
+  }
+
+  uint8_t oldSREG = SREG;
+  cli();
+  seconds = _seconds;
+  edgeMicros = _edgeMicros;
+  period = _periodSum >> PERIOD_SHIFT;
+  SREG = oldSREG;
+
+  elapsed = micros() - edgeMicros;
+  if(elapsed >= period) {
+    if(elapsed < period + period / 128) {
+      // The edge is due, it may wait for a few ms while interrupts are blocked (e.g. a DHT22 transfer)
+      elapsed = period - 1;
+    }
+    else {
+      // No edges, keep counting with the measured period
+      unsigned long missing = elapsed / period;
+      seconds += missing;
+      elapsed -= missing * period;
+    }
+  }
+
+  t = (unsigned long long)seconds * 1000 + elapsed * 1000UL / period;
+  if(t < _last) {
+    t = _last;
+  }
+  _last = t;
+
+  return t;
+}
+
+unsigned long WallClock::period() {
+  uint8_t oldSREG = SREG;
+  cli();
+  unsigned long period = _periodSum >> PERIOD_SHIFT;
+  SREG = oldSREG;
+
+  return period;
+}
+
+bool WallClock::isLocked() {
+  uint8_t oldSREG = SREG;
+  cli();
+  unsigned long edgeMicros = _edgeMicros;
+  uint8_t edges = _edges;
+  SREG = oldSREG;
+
+  return _running && (edges > 1) && (micros() - edgeMicros < period() + period() / 2);
+}
@@ -0,0 +1,86 @@
+/*
+ * WallClock.h
+ *
+ *  Created on: Oct 17, 2026
+ *      Author: john
+ */
+
+#ifndef WALLCLOCK_H_
+#define WALLCLOCK_H_
+
+#include <WProgram.h>
+#include "Time.h"
+
+#define WALLCLOCK WallClock::instance
+
+/**
+ * Millisecond time stamps that follow a real time clock. The 1 Hz square wave of the clock (DS1307 or
+ * DS1339, <code>startSquareWave(SQW_1HZ)</code>) is connected to an external interrupt pin; every falling
+ * edge starts the next second of the clock. Within a second the milliseconds are interpolated with
+ * <code>micros()</code>, scaled by the length of the second as measured by the MCU, so the error of the MCU
+ * clock does not add up and no I2C transfer is needed after <code>begin</code>.
+ * <p>
+ * Time stamps are milliseconds since Jan 1st 1970 and never go backwards. If edges are missing, e.g. the
+ * square wave is disconnected, the clock keeps running with the measured length of the second until the
+ * edges come back.
+ */
+class WallClock {
+  public:
+    static WallClock instance;
+
+    // The longest begin waits for the first edge, in ms
+    static const unsigned long MAX_EDGE_WAIT = 1100;
+
+    /**
+     * Starts to follow the square wave on the given external interrupt (0 is pin 2, 1 is pin 3). Waits
+     * for the next falling edge and reads the time of the second that just started with
+     * <code>provider</code>, e.g. a function that reads the RTC. Call again after the time of the RTC was set.
+     *
+     * @return <code>true</code> if there was an edge and the provider returned a time;<code>false</code>
+     *         otherwise.
+     */
+    bool begin(uint8_t interrupt, getExternalTime provider);
+
+    /**
+     * Stops following the square wave and releases the interrupt.
+     */
+    void end();
+
+    /**
+     * @return milliseconds since Jan 1st 1970, <code>0</code> before <code>begin</code> succeeded.
+     */
+    unsigned long long timestamp();
+
+    /**
+     * @return the current second of the clock.
+     */
+    time_t time() { return timestamp() / 1000; };
+
+    /**
+     * @return the length of a second of the clock as measured with <code>micros()</code>.
+     */
+    unsigned long period();
+
+    /**
+     * @return <code>true</code> if the edges of the square wave arrive;<code>false</code> otherwise.
+     */
+    bool isLocked();
+
+  private:
+    WallClock();
+
+    static void edge();
+
+    void tick(unsigned long edgeMicros);
+
+    volatile time_t _seconds;
+    volatile unsigned long _edgeMicros;
+    // Sum of the last 8 periods, i.e. the mean period with 3 more bits
+    volatile unsigned long _periodSum;
+    volatile uint8_t _edges;
+    unsigned long long _last;
+    int8_t _interrupt;
+    bool _running;
+};
+
+#endif /* WALLCLOCK_H_ */
@@ -0,0 +1,225 @@
+#include <ArduinoUnit.h>
+#include <Time.h>
+
+TestSuite suite;
+
+// The last day that an unsigned 32 bit time_t can represent (Feb 7th, 2106)
+#define LAST_DAY (0xffffffffUL / SECS_PER_DAY)
+
+/*
+ * The loop based breakTime and makeTime of the Time library up to version 1.0 are the reference,
+ * the constant time versions have to give identical results.
+ */
+#define LEAP_YEAR(Y)     ( ((1970+Y)>0) && !((1970+Y)%4) && ( ((1970+Y)%100) || !((1970+Y)%400) ) )
+
+static  const uint8_t monthDays[]={31,28,31,30,31,30,31,31,30,31,30,31};
+
+void referenceBreakTime(unsigned long time, tmElements_t &tm){
+  uint8_t year;
+  uint8_t month, monthLength;
+  unsigned long days;
+
+  tm.Second = time % 60;
+  time /= 60;
+  tm.Minute = time % 60;
+  time /= 60;
+  tm.Hour = time % 24;
+  time /= 24;
+  tm.Wday = ((time + 4) % 7) + 1;
+
+  year = 0;
+  days = 0;
+  while((unsigned)(days += (LEAP_YEAR(year) ? 366 : 365)) <= time) {
+    year++;
+  }
+  tm.Year = year;
+
+  days -= LEAP_YEAR(year) ? 366 : 365;
+  time  -= days;
+
+  days=0;
+  month=0;
+  monthLength=0;
+  for (month=0; month<12; month++) {
+    if (month==1) {
+      if (LEAP_YEAR(year)) {
+        monthLength=29;
+      } else {
+        monthLength=28;
+      }
+    } else {
+      monthLength = monthDays[month];
+    }
+
+    if (time >= monthLength) {
+      time -= monthLength;
+    } else {
+        break;
+    }
+  }
+  tm.Month = month + 1;
+  tm.Day = time + 1;
+}
+
+unsigned long referenceMakeTime(tmElements_t &tm){
+  int i;
+  unsigned long seconds;
+
+  seconds= tm.Year*(SECS_PER_DAY * 365);
+  for (i = 0; i < tm.Year; i++) {
+    if (LEAP_YEAR(i)) {
+      seconds +=  SECS_PER_DAY;
+    }
+  }
+
+  for (i = 1; i < tm.Month; i++) {
+    if ( (i == 2) && LEAP_YEAR(tm.Year)) {
+      seconds += SECS_PER_DAY * 29;
+    } else {
+      seconds += SECS_PER_DAY * monthDays[i-1];
+    }
+  }
+  seconds+= (tm.Day-1) * SECS_PER_DAY;
+  seconds+= tm.Hour * SECS_PER_HOUR;
+  seconds+= tm.Minute * SECS_PER_MIN;
+  seconds+= tm.Second;
+  return seconds;
+}
+
+bool equals(tmElements_t &expected, tmElements_t &actual) {
+  return expected.Second == actual.Second && expected.Minute == actual.Minute && expected.Hour == actual.Hour &&
+         expected.Wday == actual.Wday && expected.Day == actual.Day && expected.Month == actual.Month &&
+         expected.Year == actual.Year;
+}
+
+void setup() {
+  Serial.begin(9600);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(knownDates) {
+  tmElements_t te;
+
+  breakTime(0, te);
+  assertEquals(0, te.Year);
+  assertEquals(1, te.Month);
+  assertEquals(1, te.Day);
+  assertEquals(5, te.Wday);   // Thursday
+
+  // Feb 29th, 2000, 23:59:59
+  breakTime(951868799UL, te);
+  assertEquals(30, te.Year);
+  assertEquals(2, te.Month);
+  assertEquals(29, te.Day);
+  assertEquals(23, te.Hour);
+  assertEquals(59, te.Minute);
+  assertEquals(59, te.Second);
+  assertUnsignedLongEquals(951868799UL, makeTime(te));
+
+  // Mar 1st, 2100, 2100 is not a leap year
+  breakTime(4107542400UL, te);
+  assertEquals(130, te.Year);
+  assertEquals(3, te.Month);
+  assertEquals(1, te.Day);
+  assertUnsignedLongEquals(4107542400UL, makeTime(te));
+
+  // Feb 7th, 2106, 06:28:15
+  breakTime(0xffffffffUL, te);
+  assertEquals(136, te.Year);
+  assertEquals(2, te.Month);
+  assertEquals(7, te.Day);
+  assertEquals(6, te.Hour);
+  assertEquals(28, te.Minute);
+  assertEquals(15, te.Second);
+}
+
+// Every day of the range, each with a different time of the day
+test(everyDay) {
+  tmElements_t expected, actual;
+
+  for(unsigned long day = 0; day <= LAST_DAY; day++) {
+    unsigned long t = day * SECS_PER_DAY + (day * 7919UL) % SECS_PER_DAY;
+    if(t < day * SECS_PER_DAY) {
+      break;  // beyond the range of time_t
+    }
+
+    referenceBreakTime(t, expected);
+    breakTime(t, actual);
+    assertTrue(equals(expected, actual));
+    assertUnsignedLongEquals(referenceMakeTime(expected), makeTime(actual));
+    assertUnsignedLongEquals(t, makeTime(actual));
+  }
+}
+
+// Every second of a day, at the start and the end of the range
+test(everySecond) {
+  tmElements_t expected, actual;
+  unsigned long days[] = { 0, 11016, LAST_DAY - 1 };
+
+  for(int i = 0; i < 3; i++) {
+    for(unsigned long second = 0; second < SECS_PER_DAY; second++) {
+      unsigned long t = days[i] * SECS_PER_DAY + second;
+
+      referenceBreakTime(t, expected);
+      breakTime(t, actual);
+      assertTrue(equals(expected, actual));
+      assertUnsignedLongEquals(t, makeTime(actual));
+    }
+  }
+}
+
+// Elements that are out of range are added up the same way, e.g. day 0 is the last day of the previous month
+test(unnormalizedElements) {
+  tmElements_t te;
+
+  for(uint8_t year = 0; year < 136; year++) {
+    for(uint8_t month = 0; month <= 12; month++) {
+      for(uint8_t day = 0; day <= 32; day += 8) {
+        te.Year = year;
+        te.Month = month;
+        te.Day = day;
+        te.Hour = 23;
+        te.Minute = 59;
+        te.Second = 60;
+        assertUnsignedLongEquals(referenceMakeTime(te), (unsigned long)makeTime(te));
+      }
+    }
+  }
+}
+
+bool accessorsEqual(unsigned long t) {
+  tmElements_t expected;
+
+  breakTime(t, expected);
+  return second(t) == expected.Second && minute(t) == expected.Minute && hour(t) == expected.Hour &&
+         weekday(t) == expected.Wday && day(t) == expected.Day && month(t) == expected.Month &&
+         year(t) == tmYearToCalendar(expected.Year);
+}
+
+// The accessors advance their cache step by step, across the end of months, leap days, the end of 2099
+// and February 2100. Steps of a day or more and steps backwards are converted with breakTime.
+test(accessors) {
+  unsigned long starts[] = { 0, 951696000UL, 978220800UL, 4107456000UL - 3 * SECS_PER_DAY, LAST_DAY * SECS_PER_DAY - 2 * SECS_PER_DAY };
+  unsigned long steps[] = { 1, 1, 59, 61, 1, 3599, 3601, 7, SECS_PER_DAY - 1, SECS_PER_DAY, 0, 86000 };
+
+  assertTrue(accessorsEqual(0));
+  for(int i = 0; i < 5; i++) {
+    unsigned long t = starts[i];
+    for(int n = 0; n < 2000 && t >= starts[i]; n++) {
+      assertTrue(accessorsEqual(t));
+      t += steps[n % 12];
+      if(n % 97 == 96) {
+        t -= 5000;
+      }
+    }
+  }
+
+  // Setting the time from elements leaves the cache alone
+  assertTrue(accessorsEqual(951868799UL));
+  setTime(12, 0, 0, 1, 1, 2011);
+  assertEquals(59, second(951868799UL));
+  assertEquals(29, day(951868799UL));
+}
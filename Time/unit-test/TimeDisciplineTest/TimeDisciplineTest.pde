@@ -0,0 +1,105 @@
+/*
+ * Tests how the system time is disciplined by a simulated real time clock, i.e. only runs on the host,
+ * see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Time.h>
+#include <HostSim.h>
+#include <SimI2C.h>
+
+TestSuite suite;
+
+// Jan 1st, 2011
+#define START 1293840000UL
+
+SimDS1307 rtc;
+unsigned long syncs;
+
+time_t rtcTime() {
+  syncs++;
+  return rtc.getTime();
+}
+
+long offset() {
+  return (long)(now() - rtc.getTime());
+}
+
+// Calls now() every 100 ms for the given time. The time must not jump and stay within
+// tolerance seconds of the clock.
+bool follows(unsigned long seconds, long tolerance) {
+  time_t last = now();
+
+  for(unsigned long i = 0; i < seconds * 10; i++) {
+    delay(100);
+    time_t t = now();
+    if((t < last) || (t > last + 1) || (offset() > tolerance) || (offset() < -tolerance)) {
+      return false;
+    }
+    last = t;
+  }
+  return true;
+}
+
+void setup() {
+  Serial.begin(9600);
+  rtc.setTime(START);
+  setSyncInterval(300);
+}
+
+void loop() {
+  suite.run();
+}
+
+// The clock is 500 ppm slow, i.e. millis() is 500 ppm fast
+test(drift) {
+  rtc.setDrift(-500);
+  setSyncProvider(rtcTime);
+  assertEquals(0, offset());
+
+  syncs = 0;
+  assertTrue(follows(6 * SECS_PER_HOUR, 2));
+  assertTrue(timeDrift() > 400);
+  assertTrue(timeDrift() < 600);
+  // The interval grew, fewer than the 72 syncs of a fixed interval
+  assertTrue(currentSyncInterval() > 300);
+  assertTrue(syncs < 72);
+  assertTrue(follows(6 * SECS_PER_HOUR, 1));
+
+  rtc.setDrift(0);
+  setSyncProvider(0);
+}
+
+// A few seconds are slewed out, without a jump
+test(slew) {
+  setSyncInterval(300);
+  setSyncProvider(rtcTime);
+  rtc.setTime(rtc.getTime() + 3);
+  assertTrue(follows(30 * SECS_PER_MIN, 4));
+  assertTrue(offset() <= 1);
+  assertTrue(offset() >= -1);
+  setSyncProvider(0);
+}
+
+test(step) {
+  setSyncProvider(rtcTime);
+  rtc.setTime(rtc.getTime() + SECS_PER_HOUR);
+  setSyncProvider(rtcTime);
+  assertEquals(0, offset());
+  setSyncProvider(0);
+}
+
+// A long blocking call is caught up with the same corrected seconds as counting every second
+test(catchUp) {
+  setTimeDrift(20000);
+  setTime(START);
+  delay(SECS_PER_HOUR * 1000UL);
+  assertUnsignedLongEquals(START + 3529, now());
+
+  setTime(START);
+  for(int i = 0; i < 3600; i++) {
+    delay(1000);
+    now();
+  }
+  assertUnsignedLongEquals(START + 3529, now());
+  setTimeDrift(0);
+}
@@ -0,0 +1,56 @@
+/*
+ * Tests how the system time follows millis() through long blocking calls and sleep modes on the
+ * simulated MCU, i.e. only runs on the host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Time.h>
+#include <Enerlib.h>
+#include <HostSim.h>
+
+TestSuite suite;
+
+// Jan 1st, 2011
+#define START 1293840000UL
+
+Energy energy;
+
+void setup() {
+  Serial.begin(9600);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(blockingCall) {
+  setTime(START);
+  delay(10 * SECS_PER_HOUR * 1000UL + 999);
+  assertUnsignedLongEquals(START + 10 * SECS_PER_HOUR, now());
+  delay(1);
+  assertUnsignedLongEquals(START + 10 * SECS_PER_HOUR + 1, now());
+}
+
+// The timer stops in power down, the time the MCU slept has to be added
+test(powerDown) {
+  setTime(START);
+  SimClock::instance.sleepFor((3 * SECS_PER_HOUR * 1000UL + 1500) * 1000ULL);
+  energy.PowerDown();   // 100 ms awake before going to sleep
+  SimClock::instance.sleepFor(0);
+  assertUnsignedLongEquals(START, now());
+
+  addSleepTime(3 * SECS_PER_HOUR * 1000UL + 1500);
+  assertUnsignedLongEquals(START + 3 * SECS_PER_HOUR + 1, now());
+  delay(399);
+  assertUnsignedLongEquals(START + 3 * SECS_PER_HOUR + 1, now());
+  delay(1);
+  assertUnsignedLongEquals(START + 3 * SECS_PER_HOUR + 2, now());
+}
+
+// The timer keeps running in idle mode, nothing to add
+test(idle) {
+  setTime(START);
+  SimClock::instance.sleepFor(SECS_PER_HOUR * 1000000ULL);
+  energy.Idle();
+  SimClock::instance.sleepFor(0);
+  assertUnsignedLongEquals(START + SECS_PER_HOUR, now());
+}
@@ -0,0 +1,210 @@
+/*
+ * Tests the time zones against the transitions of the C library. The last test needs a simulated DS1307,
+ * i.e. only runs on the host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Wire.h>
+#include <Time.h>
+#include <TimeZone.h>
+#include <DS1307RTC.h>
+#include <HostSim.h>
+#include <SimI2C.h>
+
+TestSuite suite;
+
+#define ZONES 5
+
+const char *rules[ZONES] = {
+  "CET-1CEST,M3.5.0,M10.5.0/3",
+  "EST5EDT,M3.2.0,M11.1.0",
+  "AEST-10AEDT,M10.1.0,M4.1.0/3",
+  "<+0330>-3:30<+0430>,J79/24,J263/24",
+  "XXX3YYY,60/-1,M12.5.6/25:30"
+};
+
+// The transitions of 2011 and 2012 and the offsets before and after, from tzset of glibc
+#define TRANSITIONS 18
+
+const uint8_t zoneOf[TRANSITIONS] = { 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4 };
+
+const time_t transitions[TRANSITIONS] = {
+  1301187600UL, 1319936400UL, 1332637200UL, 1351386000UL,
+  1299999600UL, 1320559200UL, 1331449200UL, 1352008800UL,
+  1301760000UL, 1317484800UL, 1333209600UL, 1349539200UL,
+  1300653000UL, 1316547000UL, 1332275400UL, 1348169400UL,
+  1330567200UL, 1356838200UL
+};
+
+const long before[TRANSITIONS] = {
+  3600, 7200, 3600, 7200,
+  -18000, -14400, -18000, -14400,
+  39600, 36000, 39600, 36000,
+  12600, 16200, 12600, 16200,
+  -10800, -7200
+};
+
+const long after[TRANSITIONS] = {
+  7200, 3600, 7200, 3600,
+  -14400, -18000, -14400, -18000,
+  36000, 39600, 36000, 39600,
+  16200, 12600, 16200, 12600,
+  -7200, -10800
+};
+
+// Jan 1st, 2010
+#define START 1262304000UL
+
+SimDS1307 rtc;
+
+void setup() {
+  Serial.begin(9600);
+  SimI2CBus::instance.attach(&rtc);
+  RTC.initialize(-1, true);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(parse) {
+  TimeZone zone;
+
+  assertEquals(0, zone.offset(START));
+  assertTrue(zone.setRule("EST5"));
+  assertEquals(-18000, zone.offset(START));
+  assertEquals(0, zone.nextTransition(START));
+  assertTrue(zone.setRule("<+0330>-3:30"));
+  assertEquals(12600, zone.offset(START));
+  assertTrue(zone.setRule("NZST-12NZDT-13,M9.5.0,M4.1.0/3"));
+  assertEquals(46800, zone.offset(START));
+  assertTrue(zone.isDST(START));
+
+  assertTrue(!zone.setRule("E5"));
+  assertEquals(0, zone.offset(START));
+  assertTrue(!zone.setRule("CET-1CEST"));
+  assertTrue(!zone.setRule("CET-1CEST,M3.5.0"));
+  assertTrue(!zone.setRule("CET-1CEST,M13.5.0,M10.5.0"));
+  assertTrue(!zone.setRule("CET-1CEST,M3.6.0,M10.5.0"));
+  assertTrue(!zone.setRule("CET-1CEST,M3.5.7,M10.5.0"));
+  assertTrue(!zone.setRule("CET-1CEST,J0,M10.5.0"));
+  assertTrue(!zone.setRule("CET-1CEST,M3.5.0,M10.5.0/"));
+  assertTrue(!zone.setRule("CET-1CEST,M3.5.0,M10.5.0x"));
+  assertTrue(!zone.setRule("<CET-1"));
+  assertEquals(0, zone.offset(START));
+  assertTrue(!zone.isDST(START));
+}
+
+test(transitions) {
+  TimeZone zone;
+
+  for(uint8_t i = 0; i < TRANSITIONS; i++) {
+    assertTrue(zone.setRule(rules[zoneOf[i]]));
+    assertEquals(before[i], zone.offset(transitions[i] - 1));
+    assertUnsignedLongEquals(transitions[i], zone.nextTransition(transitions[i] - 1));
+    assertEquals(after[i], zone.offset(transitions[i]));
+    assertUnsignedLongEquals(transitions[i] - 1 + before[i], zone.toLocal(transitions[i] - 1));
+    assertUnsignedLongEquals(transitions[i] + after[i], zone.toLocal(transitions[i]));
+  }
+
+  // Before the first transition of 1970
+  assertTrue(zone.setRule(rules[0]));
+  assertEquals(3600, zone.offset(1000));
+  assertTrue(zone.setRule(rules[2]));
+  assertEquals(39600, zone.offset(1000));
+}
+
+// The zone kept across conversions, going forward and back, gives the same offsets as a new zone
+test(cache) {
+  TimeZone zone;
+  time_t t;
+
+  for(uint8_t i = 0; i < ZONES; i++) {
+    assertTrue(zone.setRule(rules[i]));
+    t = START;
+    for(int j = 0; j < 3000; j++) {
+      TimeZone fresh;
+      fresh.setRule(rules[i]);
+      // Steps of 3 days forward and 1 day back now and then, across five years
+      t += (j % 7 == 6) ? -(long)SECS_PER_DAY : 3 * SECS_PER_DAY + 4567;
+      assertEquals(fresh.offset(t), zone.offset(t));
+      assertUnsignedLongEquals(fresh.toLocal(t), zone.toLocal(t));
+    }
+  }
+}
+
+test(toUTC) {
+  TimeZone zone;
+  time_t t;
+
+  assertTrue(zone.setRule(rules[0]));
+  for(t = START; t < (time_t)(START + 3 * SECS_PER_YEAR); t += 1234) {
+    time_t local = zone.toLocal(t);
+    if(zone.isDST(t) && !zone.isDST(t + SECS_PER_HOUR)) {
+      // The last hour of daylight saving time exists twice and is taken as standard time
+      assertUnsignedLongEquals(t + SECS_PER_HOUR, zone.toUTC(local));
+    }
+    else {
+      assertUnsignedLongEquals(t, zone.toUTC(local));
+    }
+  }
+  // 02:30 on Mar 27th 2011 does not exist, it is 03:30 CEST
+  assertUnsignedLongEquals(1301189400UL, zone.toUTC(1301193000UL));
+}
+
+test(record) {
+  TimeZone zone, copy;
+  uint8_t buffer[TimeZone::RECORD_SIZE];
+
+  for(uint8_t i = 0; i < TRANSITIONS; i++) {
+    assertTrue(zone.setRule(rules[zoneOf[i]]));
+    assertTrue(zone.encode(buffer));
+    assertTrue(copy.decode(buffer));
+    assertEquals(before[i], copy.offset(transitions[i] - 1));
+    assertEquals(after[i], copy.offset(transitions[i]));
+  }
+
+  assertTrue(zone.setRule("EST5"));
+  assertTrue(zone.encode(buffer));
+  assertTrue(copy.decode(buffer));
+  assertEquals(-18000, copy.offset(START));
+  assertEquals(0, copy.nextTransition(START));
+
+  buffer[1]++;
+  assertTrue(!copy.decode(buffer));
+  assertEquals(-18000, copy.offset(START));
+
+  // Neither 20 minutes nor 30 seconds fit into the record
+  assertTrue(zone.setRule("XXX0:20"));
+  assertTrue(!zone.encode(buffer));
+  assertTrue(zone.setRule("CET-1CEST,M3.5.0/2:00:30,M10.5.0/3"));
+  assertTrue(!zone.encode(buffer));
+}
+
+test(rtc) {
+  TimeZone zone, copy;
+  uint8_t zero[TimeZone::RECORD_SIZE] = { 0 };
+  byte buffer[DS1307RTC::USER_MEMORY_SIZE];
+
+  assertTrue(zone.setRule(rules[2]));
+  assertTrue(RTC.writeTimeZone(zone));
+  // The user memory does not overlap the record
+  for(uint8_t i = 0; i < DS1307RTC::USER_MEMORY_SIZE; i++) {
+    buffer[i] = 0x55;
+  }
+  assertEquals(DS1307RTC::USER_MEMORY_SIZE, RTC.writeUserMemory(buffer, 0, DS1307RTC::USER_MEMORY_SIZE));
+  // Writes past the end are cut
+  assertEquals(3, RTC.writeUserMemory(buffer, DS1307RTC::USER_MEMORY_SIZE - 3, 8));
+  assertEquals(0, RTC.writeUserMemory(buffer, DS1307RTC::USER_MEMORY_SIZE, 1));
+  assertTrue(RTC.readTimeZone(copy));
+  for(uint8_t i = 8; i < 12; i++) {
+    assertEquals(before[i], copy.offset(transitions[i] - 1));
+    assertEquals(after[i], copy.offset(transitions[i]));
+  }
+
+  // Clocks set up with the hours only
+  assertEquals(TimeZone::RECORD_SIZE, RTC.writeBytes(zero, 0x40 - TimeZone::RECORD_SIZE, TimeZone::RECORD_SIZE));
+  assertTrue(RTC.setTimeZone(-5));
+  assertTrue(RTC.readTimeZone(copy));
+  assertEquals(-18000, copy.offset(START));
+  assertEquals(0, copy.nextTransition(START));
+}
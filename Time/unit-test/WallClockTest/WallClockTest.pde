@@ -0,0 +1,141 @@
+/*
+ * Tests the millisecond wall clock against the square wave of simulated real time clocks, i.e. only
+ * runs on the host, see HostSim/readme.txt.
+ */
+#include <ArduinoUnit.h>
+#include <Wire.h>
+#include <Time.h>
+#include <WallClock.h>
+#include <DS1307RTC.h>
+#include <DS1339.h>
+#include <HostSim.h>
+#include <SimI2C.h>
+
+TestSuite suite;
+
+// Jan 1st, 2011
+#define START 1293840000UL
+
+SimDS1307 ds1307;
+SimDS1339 ds1339;
+
+time_t ds1307Time() {
+  RTC.readTime();
+  return RTC.getTime();
+}
+
+time_t ds1339Time() {
+  return DS1339::instance.getTime();
+}
+
+// The time of the simulated clock in ms
+unsigned long long expected(SimRTC &rtc) {
+  unsigned long long t = rtc.getTime();
+  return t * 1000 + (SimClock::instance.wallMicros() - rtc.secondStart()) * 1000 / rtc.secondMicros();
+}
+
+// Lets time pass in small steps, so the pins see every edge of the square wave
+void wait(unsigned long ms) {
+  for(unsigned long i = 0; i < ms; i++) {
+    delay(1);
+  }
+}
+
+// Compares the time stamps with the clock every 7 ms for the given time, they may be off by tolerance ms
+bool follows(SimRTC &rtc, unsigned long ms, unsigned long tolerance) {
+  unsigned long long last = 0;
+
+  for(unsigned long i = 0; i < ms; i += 7) {
+    unsigned long long t = WALLCLOCK.timestamp();
+    unsigned long long e = expected(rtc);
+    if((t < last) || (t + tolerance < e) || (t > e + tolerance)) {
+      return false;
+    }
+    last = t;
+    wait(7);
+  }
+  return true;
+}
+
+void setup() {
+  Serial.begin(9600);
+  SimI2CBus::instance.attach(&ds1307);
+  SimPins::instance.attach(2, &ds1307);
+  RTC.initialize(-1, true);
+  RTC.start();
+  RTC.setTime(START);
+  RTC.startSquareWave(DS1307RTC::SQW_1HZ);
+}
+
+void loop() {
+  suite.run();
+}
+
+test(follow) {
+  assertTrue(WALLCLOCK.begin(0, ds1307Time));
+  assertTrue(follows(ds1307, 5000, 2));
+  assertTrue(WALLCLOCK.isLocked());
+  assertUnsignedLongEquals(ds1307.getTime(), WALLCLOCK.time());
+  WALLCLOCK.end();
+}
+
+// The clock runs 2% fast, the milliseconds follow its seconds once the period is measured
+test(drift) {
+  ds1307.setDrift(20000);
+  assertTrue(WALLCLOCK.begin(0, ds1307Time));
+  wait(40000);
+  assertTrue(WALLCLOCK.period() > 979000UL);
+  assertTrue(WALLCLOCK.period() < 981000UL);
+  assertTrue(follows(ds1307, 5000, 2));
+  WALLCLOCK.end();
+  ds1307.setDrift(0);
+}
+
+// Waits for the second half of a second, when the square wave is high
+void waitHigh(SimRTC &rtc) {
+  while(expected(rtc) % 1000 < 600) {
+    wait(1);
+  }
+}
+
+// Without the square wave the clock keeps counting with the measured period. The wire is cut and
+// connected again while the square wave is high, so there is no edge out of phase.
+test(missingEdges) {
+  assertTrue(WALLCLOCK.begin(0, ds1307Time));
+  wait(3000);
+  waitHigh(ds1307);
+  SimPins::instance.detach(2);
+  // The time stamps stand still for 1/128 s while an edge is due
+  assertTrue(follows(ds1307, 3500, 10));
+  assertTrue(!WALLCLOCK.isLocked());
+  waitHigh(ds1307);
+  SimPins::instance.attach(2, &ds1307);
+  assertTrue(follows(ds1307, 3000, 2));
+  assertTrue(WALLCLOCK.isLocked());
+  WALLCLOCK.end();
+}
+
+test(noSquareWave) {
+  RTC.stopSquareWave(false);
+  assertTrue(!WALLCLOCK.begin(0, ds1307Time));
+  assertTrue(WALLCLOCK.timestamp() == 0);
+  RTC.startSquareWave(DS1307RTC::SQW_1HZ);
+}
+
+test(ds1339) {
+  SimI2CBus::instance.detach(&ds1307);
+  SimI2CBus::instance.attach(&ds1339);
+  SimPins::instance.attach(3, &ds1339);
+  DS1339::instance.initialize();
+  ds1339.setTime(START + SECS_PER_DAY);
+  assertTrue(!WALLCLOCK.begin(1, ds1339Time));
+
+  DS1339::instance.startSquareWave(DS1339::SQW_1HZ);
+  assertTrue(WALLCLOCK.begin(1, ds1339Time));
+  assertTrue(follows(ds1339, 3000, 2));
+  WALLCLOCK.end();
+
+  SimPins::instance.detach(3);
+  SimI2CBus::instance.detach(&ds1339);
+  SimI2CBus::instance.attach(&ds1307);
+}